@@ -0,0 +1,15 @@
+option(USE_NUMA "Enable libnuma placement for --numa interleave and bind")
+
+if (USE_NUMA)
+    find_path(NUMA_INCLUDE_DIR NAMES numa.h)
+    find_library(NUMA_LIB NAMES numa)
+
+    if (NUMA_INCLUDE_DIR AND NUMA_LIB)
+        message(STATUS "Found libnuma: ${NUMA_LIB}")
+        include_directories(${NUMA_INCLUDE_DIR})
+        set(COMMON_LINK_LIBRARIES ${COMMON_LINK_LIBRARIES} ${NUMA_LIB})
+        add_definitions(-DUSE_NUMA)
+    else()
+        message(FATAL_ERROR "USE_NUMA requested but libnuma was not found")
+    endif()
+endif()
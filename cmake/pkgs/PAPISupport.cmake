@@ -0,0 +1,14 @@
+option(USE_PAPI "Enable PAPI hardware counters for --papi")
+
+if (USE_PAPI)
+    list(APPEND CMAKE_MODULE_PATH "${CMAKE_CURRENT_LIST_DIR}")
+    find_package(PAPI)
+
+    if (PAPI_FOUND)
+        include_directories(${PAPI_INCLUDE_DIRS})
+        set(COMMON_LINK_LIBRARIES ${COMMON_LINK_LIBRARIES} ${PAPI_LIBRARIES})
+        add_definitions(-DUSE_PAPI)
+    else()
+        message(FATAL_ERROR "USE_PAPI requested but PAPI was not found")
+    endif()
+endif()
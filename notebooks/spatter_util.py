@@ -72,6 +72,7 @@ import math   #get_gap
 from io import StringIO
 import matplotlib.pyplot as plt
 import pickle
+import json   #output2df
 
 ALLARCH = list(GPU_NAMES.keys()) + list(CPU_NAMES.keys())
 ALLNAMES = {**GPU_NAMES, **CPU_NAMES}
@@ -177,6 +178,22 @@ def file2df(filename, restrict_pat_len=0, archtype=None):
 
     return table
 
+# Reads a file written with --output json:<file> or csv:<file>, one row per
+# config with the build information repeated on every row
+def output2df(filename):
+    if filename.endswith('.csv'):
+        table = pd.read_csv(filename)
+        table['times'] = table['times'].apply(lambda x: [float(t) for t in str(x).split()])
+        return table
+
+    with open(filename, 'r') as file:
+        contents = json.load(file)
+
+    table = pd.DataFrame(contents['configs'])
+    for key, value in contents['build'].items():
+        table[key] = value
+    return table
+
 def ustride_plot(df_custom, kernel):
     
     # Concatenate the new data to the old data
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <vector>
 
+#include "HugePages.hh"
+#include "SharedWindows.hh"
+
 /**
  * Allocator for aligned data.
  * Adapted from Stephan T. Lavavej.
@@ -45,6 +48,14 @@ public:
     new (pv) T(t);
   }
 
+  // Default-initializes rather than zeroing, so resize() leaves the pages of
+  // a new buffer untouched until the threads that fill it first touch them
+  void construct(T *const p) const {
+    void *const pv = static_cast<void *>(p);
+
+    new (pv) T;
+  }
+
   void destroy(T *const p) const { p->~T(); }
 
   // Returns true if and only if storage allocated from *this
@@ -91,6 +102,16 @@ public:
       alloc = Alignment;
     }
 
+    // Under --mpi-shared the sparse buffers come from windows shared by the
+    // ranks of a node
+    if (void *const shared = Spatter::shared_window_alloc(alloc))
+      return static_cast<T *>(shared);
+
+    // Buffers of at least one huge page come from huge pages under
+    // --hugepages; those mappings are aligned far beyond Alignment
+    if (void *const huge = Spatter::hugepage_alloc(alloc))
+      return static_cast<T *>(huge);
+
     // Allocate memory
     void *const pv = std::aligned_alloc(Alignment, alloc);
 
@@ -103,7 +124,10 @@ public:
     return static_cast<T *>(pv);
   }
 
-  void deallocate(T *const p, const std::size_t) const { std::free(p); }
+  void deallocate(T *const p, const std::size_t) const {
+    if (!Spatter::shared_window_free(p) && !Spatter::hugepage_free(p))
+      std::free(p);
+  }
 
   // The following will be the same for all allocators that ignore hints.
   template <typename U>
@@ -0,0 +1,113 @@
+/*!
+  \file CacheFlush.cc
+*/
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CacheFlush.hh"
+
+namespace Spatter {
+
+namespace {
+
+// CPUs in a sysfs list such as "0-15,32-47"
+size_t count_cpus(const std::string &list) {
+  size_t cpus = 0;
+  std::stringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    size_t first = 0, last = 0;
+    const size_t dash = range.find('-');
+    try {
+      first = std::stoul(range.substr(0, dash));
+      last = (dash == std::string::npos) ? first
+                                         : std::stoul(range.substr(dash + 1));
+    } catch (const std::exception &) {
+      continue;
+    }
+    if (last >= first)
+      cpus += last - first + 1;
+  }
+  return cpus;
+}
+
+// Sizes in sysfs read "32768K"
+size_t parse_size(const std::string &size) {
+  size_t bytes = 0;
+  try {
+    bytes = std::stoul(size);
+  } catch (const std::exception &) {
+    return 0;
+  }
+  if (size.find('K') != std::string::npos)
+    bytes <<= 10;
+  else if (size.find('M') != std::string::npos)
+    bytes <<= 20;
+  return bytes;
+}
+
+volatile double flush_sink;
+
+} // namespace
+
+size_t last_level_cache_bytes() {
+  static size_t bytes = 0;
+  if (bytes)
+    return bytes;
+
+  // The highest cache level cpu0 sees, and how many CPUs share it
+  int level = 0;
+  size_t size = 0, sharing = 0;
+  for (int index = 0;; ++index) {
+    const std::string dir =
+        "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+    std::ifstream level_file(dir + "level");
+    if (!level_file)
+      break;
+
+    int l = 0;
+    std::string s, shared;
+    level_file >> l;
+    std::ifstream(dir + "size") >> s;
+    std::ifstream(dir + "shared_cpu_list") >> shared;
+    if (l > level) {
+      level = l;
+      size = parse_size(s);
+      sharing = count_cpus(shared);
+    }
+  }
+
+  // Each group of CPUs sharing a last-level cache has its own
+  const long online = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t instances = 1;
+  if (online > 0 && sharing > 0)
+    instances = (static_cast<size_t>(online) + sharing - 1) / sharing;
+
+  bytes = size ? size * instances : (size_t(32) << 20);
+  return bytes;
+}
+
+size_t cache_flush_bytes() { return 2 * last_level_cache_bytes(); }
+
+void flush_host_caches() {
+  static std::vector<double> scratch;
+  if (scratch.empty())
+    scratch.assign(cache_flush_bytes() / sizeof(double), 1.0);
+
+  const double *data = scratch.data();
+  const size_t n = scratch.size();
+  double sum = 0.0;
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) reduction(+ : sum)
+#endif
+  for (size_t i = 0; i < n; ++i)
+    sum += data[i];
+  flush_sink = sum;
+}
+
+} // namespace Spatter
@@ -0,0 +1,26 @@
+/*!
+  \file CacheFlush.hh
+*/
+
+#ifndef SPATTER_CACHE_FLUSH_HH
+#define SPATTER_CACHE_FLUSH_HH
+
+#include <cstddef>
+
+namespace Spatter {
+
+// Bytes of the last-level cache of every socket, from sysfs, or 32 MiB if
+// it can't be read
+size_t last_level_cache_bytes();
+
+// Bytes flush_host_caches() streams over: twice last_level_cache_bytes()
+size_t cache_flush_bytes();
+
+// --cold: reads a scratch buffer of cache_flush_bytes() on every thread, so
+// the lines a run touched, dirty or clean, leave the caches before the
+// next one. The scratch lines are left clean, adding no write-backs to it.
+void flush_host_caches();
+
+} // namespace Spatter
+
+#endif
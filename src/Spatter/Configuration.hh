@@ -8,11 +8,14 @@
 #include <algorithm>
 #include <cctype>
 #include <experimental/iterator>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifdef USE_MPI
@@ -47,8 +50,17 @@ inline void gpuAssert(
 #endif
 
 #include "AlignedAllocator.hh"
+#include "Locality.hh"
+#include "PatternDescriptor.hh"
+#include "RemoteSparse.hh"
+#include "SimdKernels.hh"
 #include "SpatterTypes.hh"
+#include "CacheFlush.hh"
+#include "Counters.hh"
+#include "Statistics.hh"
+#include "Threads.hh"
 #include "Timer.hh"
+#include "Traffic.hh"
 
 #define ALIGN 64
 template <typename T>
@@ -56,6 +68,50 @@ using aligned_vector = std::vector<T, aligned_allocator<T, ALIGN>>;
 
 namespace Spatter {
 
+// Sizes, in doubles, the shared buffers need to hold a set of configs, so
+// they can be allocated and filled once before any config runs
+struct BufferPlan {
+  size_t sparse_size = 0;
+  size_t sparse_gather_size = 0;
+  size_t sparse_scatter_size = 0;
+  size_t dense_size = 0;
+
+  // Stride and count of the config reaching furthest into each buffer, whose
+  // iterations partition it under --numa
+  struct Extent {
+    size_t stride = 0;
+    size_t count = 0;
+  };
+  Extent sparse, sparse_gather, sparse_scatter, dense;
+
+  // Each kernel any planned config runs, once
+  std::vector<std::string> kernels;
+
+  // Grows the plan to hold a config
+  void add(const std::string &kernel, const aligned_vector<size_t> &pattern,
+      const aligned_vector<size_t> &pattern_gather,
+      const aligned_vector<size_t> &pattern_scatter, const size_t delta,
+      const size_t delta_gather, const size_t delta_scatter,
+      const size_t count, const size_t wrap);
+
+  // Bytes of all of the buffers, with dense_copies copies of dense
+  size_t bytes(const size_t dense_copies) const;
+};
+
+// pattern, pattern_gather and pattern_scatter stored with narrower indices
+template <typename Index> struct NarrowPatterns {
+  aligned_vector<Index> pattern;
+  aligned_vector<Index> pattern_gather;
+  aligned_vector<Index> pattern_scatter;
+
+  void assign(const aligned_vector<size_t> &p,
+      const aligned_vector<size_t> &pg, const aligned_vector<size_t> &ps) {
+    pattern.assign(p.begin(), p.end());
+    pattern_gather.assign(pg.begin(), pg.end());
+    pattern_scatter.assign(ps.begin(), ps.end());
+  }
+};
+
 class ConfigurationBase {
 public:
   ConfigurationBase(const size_t id, const std::string name, std::string k,
@@ -74,7 +130,9 @@ public:
       const size_t shared_mem, const size_t local_work_size, const int nthreads,
       const unsigned long nruns, const bool aggregate, const bool atomic,
       const bool atomic_fence, const bool dense_buffers,
-      const unsigned long verbosity);
+      const unsigned long verbosity, const PatternDescriptor &pattern_desc,
+      const PatternDescriptor &pattern_gather_desc,
+      const PatternDescriptor &pattern_scatter_desc);
 
   virtual ~ConfigurationBase();
 
@@ -85,11 +143,84 @@ public:
   virtual void gather_scatter(bool timed, unsigned long run_id) = 0;
   virtual void multi_gather(bool timed, unsigned long run_id) = 0;
   virtual void multi_scatter(bool timed, unsigned long run_id) = 0;
+  // gather-reduce sums each iteration's gathered elements into
+  // dense[i % wrap], scatter-add adds dense rows into the sparse targets
+  virtual void gather_reduce(bool timed, unsigned long run_id) = 0;
+  virtual void scatter_add(bool timed, unsigned long run_id) = 0;
 
   virtual void report();
 
+  // Adds the --papi counts of the calling thread to counter_totals
+  void record_counters();
+
+  // Prints the --papi counts per timed run, summed over threads and ranks
+  void report_counters();
+
+  // The timed run times and --papi totals, under MPI each run's slowest
+  // rank and the sums over ranks, valid on rank 0. Collective.
+  std::vector<double> run_seconds() const;
+  std::vector<long long> counter_sums() const;
+
+  // --adaptive: whether the first runs timed runs pin the mean run time to
+  // within target of it with 95% confidence, or out_of_time, on every rank
+  bool runs_settled(size_t runs, double target, bool out_of_time) const;
+
+  // Prints the statistics of the timed runs, under MPI of each run's
+  // slowest rank
+  void report_runs();
+
+  // --stream: prints the bandwidth report() printed as a percent of peak,
+  // the STREAM MB/s summed over ranks
+  void report_peak(double peak);
+
+  // --corun: prints the fastest timed run made alongside other configs,
+  // and how much slower it is than alone_seconds, the fastest run alone
+  void report_corun(double alone_seconds);
+
+  // --cold: evicts what the last run left in the caches, called between
+  // timed runs
+  virtual void flush_caches();
+
   virtual void setup();
 
+  // Bytes of one run under the --bw-model selected
+  size_t bytes_per_run() const;
+
+  // Payload, index and read/write bytes of one run of this config
+  virtual Traffic traffic() const;
+
+  // Locality of every pattern the kernel indexes the sparse arrays through
+  // (--analyze), composed as pattern[pattern_gather[j]] for multigather and
+  // multiscatter
+  std::vector<PatternLocality> locality() const;
+
+  // --prefetch-distance: a distance, 0 for none or negative to tune it on
+  // the first run
+  void set_prefetch(const long int distance) {
+    prefetch_requested = distance != 0;
+    prefetch_tune = distance < 0;
+    prefetch_distance = distance > 0 ? static_cast<size_t>(distance) : 0;
+  }
+
+protected:
+  // Sets prefetch_distance to the fastest of a few candidates, once
+  void tune_prefetch();
+
+  // traffic() for elements and indices of the given sizes. Computed indices
+  // are not read.
+  Traffic traffic(size_t element_size, size_t index_size) const;
+
+  // Gives up on computing the indices, which the kernels load instead
+  void load_indices(const std::string &reason);
+
+  // True if two writes of the scatter kernel, or two adds of scatter-add,
+  // go to the same sparse index
+  bool scatter_conflicts() const;
+
+  // Picks index_width from the largest pattern value and narrows the
+  // patterns to it
+  void narrow_indices();
+
 private:
   void print_no_mpi(
       size_t bytes_per_run, double minimum_time, double maximum_bandwidth);
@@ -140,18 +271,94 @@ public:
   const int omp_threads;
   const unsigned long nruns;
 
+  // --corun: the CPU of the --affinity list thread 0 is pinned to, so
+  // configs running at once take disjoint CPUs
+  int thread_offset = 0;
+
   const bool aggregate;
   const bool atomic;
   const bool atomic_fence;
   const bool dense_buffers;
   const unsigned long verbosity;
 
-  Spatter::Timer timer;
+  Spatter::KernelTimer timer;
   std::vector<double> time_seconds;
+
+  // --papi events counted over every timed run, one per counter_events()
+  std::vector<long long> counter_totals;
+
+  // Iterations ahead the gather kernels prefetch, 0 for none
+  size_t prefetch_distance = 0;
+  bool prefetch_requested = false;
+  bool prefetch_tune = false;
+
+  // --procedural: closed forms of the patterns, empty unless requested, and
+  // whether the kernels compute their indices from them. setup() checks
+  // they still describe the patterns after -j, remapping and compression.
+  PatternDescriptor pattern_desc;
+  PatternDescriptor pattern_gather_desc;
+  PatternDescriptor pattern_scatter_desc;
+  bool procedural = false;
+
+  // Bytes per index the kernels load, the narrowest of 2, 4 and 8 that
+  // holds every pattern value. The copies of the patterns at 2 and 4 bytes
+  // are only filled at that width.
+  size_t index_width = sizeof(size_t);
+  NarrowPatterns<uint16_t> indices16;
+  NarrowPatterns<uint32_t> indices32;
 };
 
 std::ostream &operator<<(std::ostream &out, const ConfigurationBase &config);
 
+// The configs of a run. Deferred configs are only built the first time they
+// are accessed, so a suite sets up each config just before it runs.
+class ConfigList {
+public:
+  using Config = std::unique_ptr<ConfigurationBase>;
+  using Factory = std::function<Config(const size_t index)>;
+
+  class iterator {
+  public:
+    iterator(const ConfigList *list, size_t i) : list_(list), i_(i) {}
+    Config &operator*() const { return (*list_)[i_]; }
+    Config *operator->() const { return &(*list_)[i_]; }
+    iterator &operator++() {
+      ++i_;
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return i_ != other.i_; }
+
+  private:
+    const ConfigList *list_;
+    size_t i_;
+  };
+
+  size_t size() const { return configs_.size(); }
+  bool empty() const { return configs_.empty(); }
+
+  // Builds config i if it has not been yet
+  Config &operator[](const size_t i) const;
+  Config &back() const { return (*this)[size() - 1]; }
+
+  // Whether config i has been built
+  bool built(const size_t i) const { return !deferred_[i]; }
+
+  void push_back(Config config);
+  // Appends n configs, the i-th of them built by factory(i) when accessed
+  void defer(const size_t n, Factory factory);
+  // Frees config i once it is done with; it is null from then on
+  void release(const size_t i);
+  void clear();
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, size()); }
+
+private:
+  mutable std::vector<Config> configs_;
+  // How each config that has not been built yet is built, else empty
+  mutable std::vector<std::function<Config()>> deferred_;
+};
+
 template <typename Backend> class Configuration : public ConfigurationBase {};
 
 template <> class Configuration<Spatter::Serial> : public ConfigurationBase {
@@ -170,13 +377,18 @@ public:
       const size_t delta_gather, const size_t delta_scatter,
       const long int seed, const size_t wrap, const size_t count,
       const unsigned long nruns, const bool aggregate,
-      const unsigned long verbosity);
+      const unsigned long verbosity, const long int prefetch_distance,
+      const PatternDescriptor &pattern_desc,
+      const PatternDescriptor &pattern_gather_desc,
+      const PatternDescriptor &pattern_scatter_desc);
 
   void gather(bool timed, unsigned long run_id);
   void scatter(bool timed, unsigned long run_id);
   void gather_scatter(bool timed, unsigned long run_id);
   void multi_gather(bool timed, unsigned long run_id);
   void multi_scatter(bool timed, unsigned long run_id);
+  void gather_reduce(bool timed, unsigned long run_id);
+  void scatter_add(bool timed, unsigned long run_id);
 };
 
 #ifdef USE_OPENMP
@@ -197,15 +409,75 @@ public:
       const long int seed, const size_t wrap, const size_t count,
       const int nthreads, const unsigned long nruns, const bool aggregate,
       const bool atomic, const bool atomic_fence, const bool dense_buffers,
-      const unsigned long verbosity);
+      const unsigned long verbosity, const std::string simd_name,
+      const bool persistent, const bool nt_stores,
+      const long int prefetch_distance, const PatternDescriptor &pattern_desc,
+      const PatternDescriptor &pattern_gather_desc,
+      const PatternDescriptor &pattern_scatter_desc);
 
   int run(bool timed, unsigned long run_id);
 
+  void report();
+
   void gather(bool timed, unsigned long run_id);
   void scatter(bool timed, unsigned long run_id);
   void gather_scatter(bool timed, unsigned long run_id);
   void multi_gather(bool timed, unsigned long run_id);
   void multi_scatter(bool timed, unsigned long run_id);
+  void gather_reduce(bool timed, unsigned long run_id);
+  void scatter_add(bool timed, unsigned long run_id);
+
+private:
+  // Kernel bodies, called by every thread inside a parallel region
+  void gather_loop();
+  void scatter_loop();
+  void gather_scatter_loop();
+  void multi_gather_loop();
+  void multi_scatter_loop();
+  void gather_reduce_loop();
+  void scatter_add_loop();
+
+  // Runs loop in a parallel region, timing each thread's share
+  void parallel_loop(void (Configuration<Spatter::OpenMP>::*loop)(),
+      bool timed, unsigned long run_id);
+
+  // All nruns timed runs in one parallel region, separated by barriers
+  int run_persistent();
+
+public:
+  // The intrinsic kernels read the 32-bit copy of the pattern
+  Traffic traffic() const;
+
+  // Intrinsic gather/scatter kernels (--simd) over a 32-bit copy of the
+  // pattern, or nullptr for the compiler-vectorized loops
+  const SimdKernels *simd;
+  std::vector<uint32_t> pattern32;
+
+  // Run all timed runs inside one parallel region (--persistent)
+  const bool persistent;
+
+  // --nt-stores was requested, and whether this kernel streams its stores
+  // (gather and scatter only)
+  const bool nt_stores;
+  bool nt = false;
+
+  // How scatter-add combines its adds (--accumulate), auto resolved by the
+  // constructor. With Private each thread adds into its own zeroed copy
+  // of the sparse array, and the copies are summed into it by all threads
+  // at the end of the run.
+  Accumulate accumulate;
+  std::vector<aligned_vector<double>> sparse_private;
+  // No index is added to twice, so the adds vectorize
+  bool distinct_adds = false;
+
+  // Seconds each thread spent in its share of every timed run,
+  // [run * omp_threads + thread]
+  std::vector<double> thread_seconds;
+
+  // The calling thread whose pool of threads was pinned to their
+  // --affinity CPUs, from thread_offset on
+  std::thread::id pinned_by;
+  int pinned_offset = 0;
 };
 #endif
 
@@ -227,22 +499,71 @@ public:
       const long int seed, const size_t wrap, const size_t count,
       const size_t shared_mem, const size_t local_work_size,
       const unsigned long nruns, const bool aggregate, const bool atomic,
-      const unsigned long verbosity);
+      const unsigned long verbosity, const bool cuda_graph,
+      const std::string cuda_kernel, const std::string atomic_mode,
+      const size_t cuda_streams, const size_t cuda_chunk,
+      const PatternDescriptor &pattern_desc,
+      const PatternDescriptor &pattern_gather_desc,
+      const PatternDescriptor &pattern_scatter_desc);
 
   ~Configuration();
 
   int run(bool timed, unsigned long run_id);
+  void report();
+  // Flushes the device L2, and the host caches the streamed runs read from
+  void flush_caches();
   void gather(bool timed, unsigned long run_id);
   void scatter(bool timed, unsigned long run_id);
   void gather_scatter(bool timed, unsigned long run_id);
   void multi_gather(bool timed, unsigned long run_id);
   void multi_scatter(bool timed, unsigned long run_id);
+  void gather_reduce(bool timed, unsigned long run_id);
+  void scatter_add(bool timed, unsigned long run_id);
   void setup();
 
+private:
+  void replay_graph(bool timed);
+  CudaKernelArgs kernel_args() const;
+  bool resolve_kernel(CudaKernel &launch, CudaKernelArgs &args) const;
+  CudaKernel gather_kernel() const;
+  CudaKernel scatter_kernel(
+      CudaKernel plain, CudaKernel exchange, CudaKernel aggregate) const;
+
 public:
-  size_t *dev_pattern;
-  size_t *dev_pattern_gather;
-  size_t *dev_pattern_scatter;
+  // Device copies of the patterns at index_width
+  void *dev_pattern;
+  void *dev_pattern_gather;
+  void *dev_pattern_scatter;
+
+  // Gather kernel variant (--cuda-kernel): naive, vector2, vector4 or shared
+  std::string cuda_kernel;
+
+  // --procedural: the descriptor runs the kernels compute indices from,
+  // uploaded instead of the patterns
+  PatternSegment *dev_runs;
+  PatternSegment *dev_runs_gather;
+  PatternSegment *dev_runs_scatter;
+
+  // How scatters write (--atomic-mode), resolved in setup(). Plain unless
+  // --atomic-writes or a scatter-add that conflicts; auto picks Plain for
+  // patterns that never write the same index twice and Aggregate otherwise.
+  // For scatter-add Exchange is an atomicAdd per element and Aggregate one
+  // per distinct index per warp.
+  enum class ScatterWrite { Plain, Exchange, Aggregate };
+  std::string atomic_mode;
+  ScatterWrite scatter_write;
+
+  // All nruns launches captured in setup() (--cuda-graph), else nullptr
+  bool cuda_graph;
+  CudaGraph *graph;
+
+  // Chunked runs over cuda_streams streams for sparse arrays left on the
+  // host (--cuda-streams), else nullptr. time_seconds is end to end,
+  // kernel_seconds the kernels alone.
+  size_t cuda_streams;
+  size_t cuda_chunk;
+  CudaStreamer *streamer;
+  std::vector<double> kernel_seconds;
 };
 #endif
 
@@ -263,7 +584,12 @@ public:
       const size_t delta_gather, const size_t delta_scatter,
       const long int seed, const size_t wrap, const size_t count,
       const unsigned long nruns, const bool aggregate,
-      const unsigned long verbosity, const int tt_cores);
+      const unsigned long verbosity, const int tt_cores,
+      const std::string tt_dtype, const std::string tt_memory,
+      const bool tt_batch, const int tt_devices, const bool tt_tile_sort,
+      const PatternDescriptor &pattern_desc,
+      const PatternDescriptor &pattern_gather_desc,
+      const PatternDescriptor &pattern_scatter_desc);
 
   ~Configuration();
 
@@ -273,17 +599,98 @@ public:
   void gather_scatter(bool timed, unsigned long run_id);
   void multi_gather(bool timed, unsigned long run_id);
   void multi_scatter(bool timed, unsigned long run_id);
+  void gather_reduce(bool timed, unsigned long run_id);
+  void scatter_add(bool timed, unsigned long run_id);
+  void report();
   void setup();
 
+  // Elements are counted at the size selected by --tt-dtype, indices at the
+  // 32 bits the kernels read
+  Traffic traffic() const;
+
+  // Elements [offset, offset + length) of a host array
+  struct Slice {
+    size_t offset = 0;
+    size_t length = 0;
+  };
+
+  // One TensTorrent card (--tt-devices) and the contiguous range of count
+  // iterations it runs. Each card holds the slices of the host arrays that
+  // its range touches.
+  struct Shard {
+    // Shared with every other config on this card, see TensTorrentDevice::shared
+    std::shared_ptr<TensTorrentDevice> device;
+    std::shared_ptr<tt::tt_metal::Buffer> pattern_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> pattern_gather_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> pattern_scatter_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> sparse_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> dense_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> sparse_gather_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> sparse_scatter_buffer;
+    // Destination tile owners for scatter and gs
+    TensTorrentDevice::ScatterPartition scatter_partition;
+    // Source tile order for gather (--tt-tile-sort)
+    std::shared_ptr<tt::tt_metal::Buffer> gather_order;
+
+    size_t first_iteration = 0;
+    size_t count = 0;
+    Slice sparse;
+    // Elements of the device dense buffer. Gather and scatter don't wrap on
+    // the device, so they hold one row per iteration of the shard, row r
+    // standing for host row (first_iteration + r) % wrap. The multi kernels
+    // wrap themselves and hold the host rows as they are.
+    size_t dense_length = 0;
+    Slice sparse_gather;
+    Slice sparse_scatter;
+
+    // Device-only time of the last launch and of each timed run
+    double launch_seconds = 0.0;
+    std::vector<double> time_seconds;
+  };
+
+private:
+  bool launch_kernel(
+      TensTorrentDevice::LaunchMode mode = TensTorrentDevice::LaunchMode::Blocking);
+  bool launch_shard(Shard &shard, TensTorrentDevice::LaunchMode mode);
+  bool run_on_shards(const std::function<bool(Shard &)> &fn);
+  void record_shard_times(unsigned long run_id);
+  bool buffers_ready() const;
+  void release_buffers();
+  void read_output();
+  void run_batch(bool timed);
+  // Checks out[dst(k)] == in[src(k)] (as stored on the device) for
+  // first <= k < n with order-independent checksums, diffing elements only
+  // on a checksum mismatch. The writes below first are overwritten. Unless
+  // unique_dst, the last k writing a destination wins.
+  template <typename Src, typename Dst>
+  bool validate_output(const std::string &name, const aligned_vector<double> &in,
+      Src src, const aligned_vector<double> &out, Dst dst, size_t first,
+      size_t n, bool unique_dst);
+  // The first element of the iterations whose dense rows survive a gather,
+  // the last wrap of them
+  size_t surviving_rows(size_t pattern_length) const;
+
 public:
-  std::unique_ptr<TensTorrentDevice> tt_device_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_pattern_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_pattern_gather_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_pattern_scatter_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_sparse_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_dense_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_sparse_gather_buffer_;
-  std::shared_ptr<tt::tt_metal::Buffer> tt_sparse_scatter_buffer_;
+  std::vector<Shard> tt_shards_;
+  // --tt-cores and --tt-dtype, applied to the shared devices in setup()
+  int tt_cores_;
+  std::string tt_dtype_;
+  // Buffer placement requested with --tt-memory (l1, dram or auto)
+  std::string tt_memory_;
+  // Enqueue all nruns repetitions at once (--tt-batch)
+  bool tt_batch_;
+  // Run gathers in source tile order (--tt-tile-sort)
+  bool tt_tile_sort_;
+  // Set in setup() when the gather or scatter pattern is base + stride * i
+  AffinePattern tt_affine_;
+
+  // Host<->device transfer times, reported separately from the device-only
+  // kernel time in time_seconds. h2d covers the initial upload in setup(),
+  // d2h is the per-run readback of the output buffer.
+  double h2d_seconds;
+  std::vector<double> d2h_seconds;
+  // Times the transfers, which timer and its --papi counts leave out
+  Spatter::Timer transfer_timer;
 };
 #endif
 
@@ -0,0 +1,122 @@
+/*!
+  \file Counters.cc
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "Counters.hh"
+
+#ifdef USE_PAPI
+#include <papi.h>
+#include <pthread.h>
+#endif
+
+namespace Spatter {
+
+namespace {
+
+std::vector<std::string> events;
+#ifdef USE_PAPI
+std::vector<int> codes;
+#endif
+
+} // namespace
+
+bool set_counter_events(const std::string &list, std::string &error) {
+#ifdef USE_PAPI
+  if (PAPI_library_init(PAPI_VER_CURRENT) != PAPI_VER_CURRENT) {
+    error = "PAPI failed to initialize";
+    return false;
+  }
+  // OpenMP threads each count their own share of a run
+  if (PAPI_thread_init(
+          reinterpret_cast<unsigned long (*)(void)>(pthread_self)) !=
+      PAPI_OK) {
+    error = "PAPI failed to initialize threads";
+    return false;
+  }
+
+  events.clear();
+  codes.clear();
+
+  std::stringstream stream(list);
+  std::string name;
+  while (std::getline(stream, name, ',')) {
+    int code = PAPI_NULL;
+    if (PAPI_event_name_to_code(name.c_str(), &code) != PAPI_OK ||
+        PAPI_query_event(code) != PAPI_OK) {
+      error = "PAPI event " + name + " is not available";
+      return false;
+    }
+    events.push_back(name);
+    codes.push_back(code);
+  }
+
+  if (events.empty()) {
+    error = "--papi needs at least one event";
+    return false;
+  }
+  return true;
+#else
+  (void)list;
+  error = "--papi requires PAPI (configure with -DUSE_PAPI=ON)";
+  return false;
+#endif
+}
+
+const std::vector<std::string> &counter_events() { return events; }
+
+CounterSet::~CounterSet() {
+#ifdef USE_PAPI
+  if (event_set_ != PAPI_NULL) {
+    PAPI_cleanup_eventset(event_set_);
+    PAPI_destroy_eventset(&event_set_);
+  }
+#endif
+}
+
+void CounterSet::start() {
+#ifdef USE_PAPI
+  // Event sets belong to the thread that creates them
+  if (event_set_ == PAPI_NULL) {
+    if (PAPI_create_eventset(&event_set_) != PAPI_OK) {
+      std::cerr << "PAPI failed to create an event set" << std::endl;
+      exit(1);
+    }
+    for (size_t e = 0; e < codes.size(); ++e)
+      if (PAPI_add_event(event_set_, codes[e]) != PAPI_OK) {
+        std::cerr << "PAPI cannot count " << events[e]
+                  << " together with the events before it" << std::endl;
+        exit(1);
+      }
+    sums_.assign(codes.size(), 0);
+  }
+
+  PAPI_start(event_set_);
+#endif
+}
+
+void CounterSet::stop() {
+#ifdef USE_PAPI
+  std::vector<long long> values(codes.size(), 0);
+  PAPI_stop(event_set_, values.data());
+  for (size_t e = 0; e < values.size(); ++e)
+    sums_[e] += values[e];
+#endif
+}
+
+void CounterSet::drain(std::vector<long long> &totals) {
+  for (size_t e = 0; e < sums_.size() && e < totals.size(); ++e) {
+    totals[e] += sums_[e];
+    sums_[e] = 0;
+  }
+}
+
+CounterSet &thread_counters() {
+  thread_local CounterSet counters;
+  return counters;
+}
+
+} // namespace Spatter
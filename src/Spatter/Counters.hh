@@ -0,0 +1,69 @@
+/*!
+  \file Counters.hh
+*/
+
+#ifndef SPATTER_COUNTERS_HH
+#define SPATTER_COUNTERS_HH
+
+#include <string>
+#include <vector>
+
+#include "Timer.hh"
+
+namespace Spatter {
+
+// --papi hardware counters, counted over the region the kernels time
+
+// Selects the comma-separated PAPI events, e.g. PAPI_L3_TCM,PAPI_TLB_DM.
+// false, with the reason in error, if PAPI is unavailable or an event is.
+bool set_counter_events(const std::string &events, std::string &error);
+
+// The events selected, empty without --papi
+const std::vector<std::string> &counter_events();
+
+// An event set counting counter_events() on the thread that starts it,
+// summed over its start/stop pairs
+class CounterSet {
+public:
+  CounterSet() = default;
+  ~CounterSet();
+
+  CounterSet(const CounterSet &) = delete;
+  CounterSet &operator=(const CounterSet &) = delete;
+
+  void start();
+  void stop();
+
+  // Adds the sums to totals, one per event, and clears them
+  void drain(std::vector<long long> &totals);
+
+private:
+  int event_set_ = -1;
+  std::vector<long long> sums_;
+};
+
+// The event set of the calling thread
+CounterSet &thread_counters();
+
+// The kernels' timer, which also counts the --papi events on the calling
+// thread unless the threads it runs count for themselves
+class KernelTimer : public Timer {
+public:
+  bool count_thread = true;
+
+  void start() {
+    Timer::start();
+    if (count_thread && !counter_events().empty())
+      thread_counters().start();
+  }
+
+  void stop() {
+    if (count_thread && !counter_events().empty())
+      thread_counters().stop();
+    Timer::stop();
+  }
+};
+
+} // namespace Spatter
+
+#endif
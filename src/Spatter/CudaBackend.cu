@@ -1,11 +1,16 @@
 #include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #include <cuda.h>
 #include <cuda_runtime.h>
 
 #include "Configuration.hh"
+#include "Random.hh"
 
-__global__ void cuda_gather(const size_t *pattern, const double *sparse,
+template <typename Index>
+__global__ void cuda_gather(const Index *pattern, const double *sparse,
     double *dense, const size_t pattern_length, const size_t delta,
     const size_t wrap, const size_t count) {
   size_t total_id =
@@ -23,7 +28,8 @@ __global__ void cuda_gather(const size_t *pattern, const double *sparse,
   }
 }
 
-__global__ void cuda_scatter(const size_t *pattern, double *sparse,
+template <typename Index>
+__global__ void cuda_scatter(const Index *pattern, double *sparse,
     const double *dense, const size_t pattern_length, const size_t delta,
     const size_t wrap, const size_t count) {
   size_t total_id =
@@ -35,7 +41,8 @@ __global__ void cuda_scatter(const size_t *pattern, double *sparse,
     sparse[pattern[j] + delta * i] = dense[j + pattern_length * (i % wrap)];
 }
 
-__global__ void cuda_scatter_atomic(const size_t *pattern, double *sparse,
+template <typename Index>
+__global__ void cuda_scatter_atomic(const Index *pattern, double *sparse,
     const double *dense, const size_t pattern_length, const size_t delta,
     const size_t wrap, const size_t count) {
   size_t total_id =
@@ -48,8 +55,9 @@ __global__ void cuda_scatter_atomic(const size_t *pattern, double *sparse,
         __double_as_longlong(dense[j + pattern_length * (i % wrap)]));
 }
 
-__global__ void cuda_gather_scatter(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
+template <typename Index>
+__global__ void cuda_gather_scatter(const Index *pattern_scatter,
+    double *sparse_scatter, const Index *pattern_gather,
     const double *sparse_gather, const size_t pattern_length,
     const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
     const size_t count) {
@@ -64,8 +72,9 @@ __global__ void cuda_gather_scatter(const size_t *pattern_scatter,
         sparse_gather[pattern_gather[j] + delta_gather * i];
 }
 
-__global__ void cuda_gather_scatter_atomic(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
+template <typename Index>
+__global__ void cuda_gather_scatter_atomic(const Index *pattern_scatter,
+    double *sparse_scatter, const Index *pattern_gather,
     const double *sparse_gather, const size_t pattern_length,
     const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
     const size_t count) {
@@ -82,8 +91,9 @@ __global__ void cuda_gather_scatter_atomic(const size_t *pattern_scatter,
             sparse_gather[pattern_gather[j] + delta_gather * i]));
 }
 
-__global__ void cuda_multi_gather(const size_t *pattern,
-    const size_t *pattern_gather, const double *sparse, double *dense,
+template <typename Index>
+__global__ void cuda_multi_gather(const Index *pattern,
+    const Index *pattern_gather, const double *sparse, double *dense,
     const size_t pattern_length, const size_t delta, const size_t wrap,
     const size_t count) {
   size_t total_id =
@@ -102,8 +112,9 @@ __global__ void cuda_multi_gather(const size_t *pattern,
   }
 }
 
-__global__ void cuda_multi_scatter(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
+template <typename Index>
+__global__ void cuda_multi_scatter(const Index *pattern,
+    const Index *pattern_scatter, double *sparse, const double *dense,
     const size_t pattern_length, const size_t delta, const size_t wrap,
     const size_t count) {
   size_t total_id =
@@ -116,8 +127,9 @@ __global__ void cuda_multi_scatter(const size_t *pattern,
         dense[j + pattern_length * (i % wrap)];
 }
 
-__global__ void cuda_multi_scatter_atomic(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
+template <typename Index>
+__global__ void cuda_multi_scatter_atomic(const Index *pattern,
+    const Index *pattern_scatter, double *sparse, const double *dense,
     const size_t pattern_length, const size_t delta, const size_t wrap,
     const size_t count) {
   size_t total_id =
@@ -131,120 +143,481 @@ __global__ void cuda_multi_scatter_atomic(const size_t *pattern,
         __double_as_longlong(dense[j + pattern_length * (i % wrap)]));
 }
 
-float cuda_gather_wrapper(const size_t *pattern, const double *sparse,
+template <typename V> struct vector_width;
+template <> struct vector_width<double2> {
+  static constexpr size_t value = 2;
+};
+template <> struct vector_width<double4> {
+  static constexpr size_t value = 4;
+};
+
+// Each thread gathers width pattern entries, with one vector load when they
+// are a contiguous and aligned run of sparse, else one load per entry
+template <typename V, typename Index>
+__global__ void cuda_gather_vector(const Index *pattern, const double *sparse,
     double *dense, const size_t pattern_length, const size_t delta,
     const size_t wrap, const size_t count) {
-  cudaEvent_t start, stop;
+  constexpr size_t width = vector_width<V>::value;
+  size_t groups = (pattern_length + width - 1) / width;
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = (total_id % groups) * width; // first pat_idx
+  size_t i = total_id / groups;           // count_idx
+
+  if (i >= count)
+    return;
+
+  size_t first = pattern[j] + delta * i;
+  bool contiguous = (j + width <= pattern_length) && (first % width == 0);
+  for (size_t k = 1; contiguous && k < width; ++k)
+    contiguous = (pattern[j + k] == pattern[j] + k);
+
+  double x[width];
+  if (contiguous) {
+    V v = *reinterpret_cast<const V *>(&sparse[first]);
+    const double *lanes = reinterpret_cast<const double *>(&v);
+    for (size_t k = 0; k < width; ++k)
+      x[k] = lanes[k];
+  } else {
+    for (size_t k = 0; k < width; ++k)
+      x[k] = (j + k < pattern_length) ? sparse[pattern[j + k] + delta * i]
+                                      : 0.0;
+  }
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+  for (size_t k = 0; k < width; ++k)
+    if (x[k] == 0.5)
+      dense[0] = x[k];
+}
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+// Each block stages tile_length pattern entries at a time in shared memory
+// and gathers them for count_idx blockIdx.x, blockIdx.x + gridDim.x, ...
+template <typename Index>
+__global__ void cuda_gather_shared(const Index *pattern, const double *sparse,
+    double *dense, const size_t pattern_length, const size_t delta,
+    const size_t wrap, const size_t count, const size_t tile_length) {
+  // Each instantiation views the same dynamic shared memory at its width
+  extern __shared__ __align__(8) unsigned char tile_bytes[];
+  Index *tile = reinterpret_cast<Index *>(tile_bytes);
+
+  for (size_t t = 0; t < pattern_length; t += tile_length) {
+    size_t length = min(tile_length, pattern_length - t);
+
+    __syncthreads();
+    for (size_t j = threadIdx.x; j < length; j += blockDim.x)
+      tile[j] = pattern[t + j];
+    __syncthreads();
+
+    for (size_t i = blockIdx.x; i < count; i += gridDim.x) {
+      for (size_t j = threadIdx.x; j < length; j += blockDim.x) {
+        double x = sparse[tile[j] + delta * i];
+        if (x == 0.5)
+          dense[0] = x;
+      }
+    }
+  }
+}
 
-  checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
+// Atomic store where only one lane of a warp writes each distinct target,
+// so contention is paid once per address instead of once per element
+__device__ void cuda_aggregated_store(double *target, double value) {
+#if __CUDA_ARCH__ >= 700
+  unsigned int peers =
+      __match_any_sync(__activemask(), (unsigned long long)target);
+  unsigned int lane = threadIdx.x % warpSize;
+  // The highest lane of the group is the last writer, as without atomics
+  if (lane != 31 - __clz(peers))
+    return;
+#endif
+  atomicExch((unsigned long long int *)target, __double_as_longlong(value));
+}
 
-  cuda_gather<<<blocks_per_grid, threads_per_block>>>(
-      pattern, sparse, dense, pattern_length, delta, wrap, count);
-  checkCudaErrors(cudaGetLastError());
+template <typename Index>
+__global__ void cuda_scatter_aggregate(const Index *pattern, double *sparse,
+    const double *dense, const size_t pattern_length, const size_t delta,
+    const size_t wrap, const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+  if (i < count)
+    cuda_aggregated_store(&sparse[pattern[j] + delta * i],
+        dense[j + pattern_length * (i % wrap)]);
+}
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+template <typename Index>
+__global__ void cuda_gather_scatter_aggregate(const Index *pattern_scatter,
+    double *sparse_scatter, const Index *pattern_gather,
+    const double *sparse_gather, const size_t pattern_length,
+    const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
+    const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+  if (i < count)
+    cuda_aggregated_store(
+        &sparse_scatter[pattern_scatter[j] + delta_scatter * i],
+        sparse_gather[pattern_gather[j] + delta_gather * i]);
+}
 
-  return time_ms;
+template <typename Index>
+__global__ void cuda_multi_scatter_aggregate(const Index *pattern,
+    const Index *pattern_scatter, double *sparse, const double *dense,
+    const size_t pattern_length, const size_t delta, const size_t wrap,
+    const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
+
+  if (i < count)
+    cuda_aggregated_store(&sparse[pattern[pattern_scatter[j]] + delta * i],
+        dense[j + pattern_length * (i % wrap)]);
 }
 
-float cuda_scatter_wrapper(const size_t *pattern, double *sparse,
-    const double *dense, const size_t pattern_length, const size_t delta,
+// One warp per iteration: the lanes stride over the pattern and shuffle
+// their partial sums down to lane 0
+template <typename Index>
+__global__ void cuda_gather_reduce(const Index *pattern, const double *sparse,
+    double *dense, const size_t pattern_length, const size_t delta,
     const size_t wrap, const size_t count) {
-  cudaEvent_t start, stop;
+  size_t i =
+      ((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x) /
+      warpSize;
+  unsigned int lane = threadIdx.x % warpSize;
+
+  // Whole warps leave together, the shuffles need every lane
+  if (i >= count)
+    return;
+
+  double sum = 0.0;
+  for (size_t j = lane; j < pattern_length; j += warpSize)
+    sum += sparse[pattern[j] + delta * i];
+  for (int offset = warpSize / 2; offset > 0; offset /= 2)
+    sum += __shfl_down_sync(0xffffffff, sum, offset);
+
+  if (lane == 0)
+    dense[i % wrap] = sum;
+}
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+// Double atomicAdd, a compare-and-swap loop before sm_60
+__device__ void cuda_atomic_add(double *target, double value) {
+#if __CUDA_ARCH__ >= 600
+  atomicAdd(target, value);
+#else
+  unsigned long long int *word = (unsigned long long int *)target;
+  unsigned long long int old = *word, seen;
+  do {
+    seen = old;
+    old = atomicCAS(word, seen,
+        __double_as_longlong(__longlong_as_double(seen) + value));
+  } while (old != seen);
+#endif
+}
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+// Atomic add where the lanes of a warp adding to the same target sum their
+// values first, so the lowest of them adds once per address
+__device__ void cuda_aggregated_add(double *target, double value) {
+#if __CUDA_ARCH__ >= 700
+  unsigned int peers =
+      __match_any_sync(__activemask(), (unsigned long long)target);
+  unsigned int lane = threadIdx.x % warpSize;
+  double sum = 0.0;
+  for (unsigned int rest = peers; rest; rest &= rest - 1)
+    sum += __shfl_sync(peers, value, __ffs(rest) - 1);
+  if (lane != __ffs(peers) - 1)
+    return;
+  value = sum;
+#endif
+  cuda_atomic_add(target, value);
+}
 
-  checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
+template <typename Index>
+__global__ void cuda_scatter_add(const Index *pattern, double *sparse,
+    const double *dense, const size_t pattern_length, const size_t delta,
+    const size_t wrap, const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  cuda_scatter<<<blocks_per_grid, threads_per_block>>>(
-      pattern, sparse, dense, pattern_length, delta, wrap, count);
-  checkCudaErrors(cudaGetLastError());
+  if (i < count)
+    sparse[pattern[j] + delta * i] += dense[j + pattern_length * (i % wrap)];
+}
 
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+template <typename Index>
+__global__ void cuda_scatter_add_atomic(const Index *pattern, double *sparse,
+    const double *dense, const size_t pattern_length, const size_t delta,
+    const size_t wrap, const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+  if (i < count)
+    cuda_atomic_add(&sparse[pattern[j] + delta * i],
+        dense[j + pattern_length * (i % wrap)]);
+}
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+template <typename Index>
+__global__ void cuda_scatter_add_aggregate(const Index *pattern,
+    double *sparse, const double *dense, const size_t pattern_length,
+    const size_t delta, const size_t wrap, const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  return time_ms;
+  if (i < count)
+    cuda_aggregated_add(&sparse[pattern[j] + delta * i],
+        dense[j + pattern_length * (i % wrap)]);
 }
 
-float cuda_scatter_atomic_wrapper(const size_t *pattern, double *sparse,
-    const double *dense, const size_t pattern_length, const size_t delta,
-    const size_t wrap, const size_t count) {
-  cudaEvent_t start, stop;
+// Value j of the pattern a descriptor's runs expand to, by binary search on
+// their offsets. Descending runs wrap around in the unsigned arithmetic.
+__device__ size_t procedural_index(
+    const Spatter::PatternSegment *runs, const size_t num_runs, size_t j) {
+  size_t lo = 0, hi = num_runs;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (runs[mid].offset <= j)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return runs[lo].base + (j - runs[lo].offset) * (size_t)runs[lo].stride;
+}
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+__global__ void cuda_gather_procedural(const Spatter::PatternSegment *runs,
+    const size_t num_runs, const double *sparse, double *dense,
+    const size_t pattern_length, const size_t delta, const size_t wrap,
+    const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+  double x;
 
-  checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
+  if (i < count) {
+    x = sparse[procedural_index(runs, num_runs, j) + delta * i];
+    if (x == 0.5)
+      dense[0] = x;
+  }
+}
 
-  cuda_scatter_atomic<<<blocks_per_grid, threads_per_block>>>(
-      pattern, sparse, dense, pattern_length, delta, wrap, count);
-  checkCudaErrors(cudaGetLastError());
+__global__ void cuda_scatter_procedural(const Spatter::PatternSegment *runs,
+    const size_t num_runs, double *sparse, const double *dense,
+    const size_t pattern_length, const size_t delta, const size_t wrap,
+    const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+  if (i < count)
+    sparse[procedural_index(runs, num_runs, j) + delta * i] =
+        dense[j + pattern_length * (i % wrap)];
+}
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+__global__ void cuda_gather_scatter_procedural(
+    const Spatter::PatternSegment *runs_scatter, const size_t num_runs_scatter,
+    double *sparse_scatter, const Spatter::PatternSegment *runs_gather,
+    const size_t num_runs_gather, const double *sparse_gather,
+    const size_t pattern_length, const size_t delta_scatter,
+    const size_t delta_gather, const size_t wrap, const size_t count) {
+  size_t total_id =
+      (size_t)((size_t)blockDim.x * (size_t)blockIdx.x + (size_t)threadIdx.x);
+  size_t j = total_id % pattern_length; // pat_idx
+  size_t i = total_id / pattern_length; // count_idx
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+  if (i < count)
+    sparse_scatter[procedural_index(runs_scatter, num_runs_scatter, j) +
+        delta_scatter * i] =
+        sparse_gather[procedural_index(runs_gather, num_runs_gather, j) +
+            delta_gather * i];
+}
 
-  return time_ms;
+struct CudaGraph {
+  cudaStream_t stream;
+  cudaGraphExec_t exec;
+  std::vector<cudaEvent_t> events; // nruns + 1, launch i runs between i and i + 1
+};
+
+// Launches kernel with the patterns of a read as Index
+template <typename Index>
+static void cuda_launch_indexed(
+    CudaKernel kernel, const CudaKernelArgs &a, cudaStream_t stream) {
+  const Index *pattern = static_cast<const Index *>(a.pattern);
+  const Index *pattern_gather = static_cast<const Index *>(a.pattern_gather);
+  const Index *pattern_scatter = static_cast<const Index *>(a.pattern_scatter);
+
+  int threads_per_block = min(a.pattern_length, (size_t)1024);
+  int blocks_per_grid =
+      ((a.pattern_length * a.count) + threads_per_block - 1) / threads_per_block;
+
+  switch (kernel) {
+  case CudaKernel::Gather:
+    cuda_gather<<<blocks_per_grid, threads_per_block, 0, stream>>>(pattern,
+        a.sparse, a.dense, a.pattern_length, a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::GatherVector2:
+  case CudaKernel::GatherVector4: {
+    size_t width = (kernel == CudaKernel::GatherVector2) ? 2 : 4;
+    size_t groups = (a.pattern_length + width - 1) / width;
+    threads_per_block = min(groups, (size_t)1024);
+    blocks_per_grid =
+        ((groups * a.count) + threads_per_block - 1) / threads_per_block;
+    if (width == 2)
+      cuda_gather_vector<double2><<<blocks_per_grid, threads_per_block, 0,
+          stream>>>(pattern, a.sparse, a.dense, a.pattern_length, a.delta,
+          a.wrap, a.count);
+    else
+      cuda_gather_vector<double4><<<blocks_per_grid, threads_per_block, 0,
+          stream>>>(pattern, a.sparse, a.dense, a.pattern_length, a.delta,
+          a.wrap, a.count);
+    break;
+  }
+  case CudaKernel::GatherShared: {
+    int device, sms;
+    checkCudaErrors(cudaGetDevice(&device));
+    checkCudaErrors(
+        cudaDeviceGetAttribute(&sms, cudaDevAttrMultiProcessorCount, device));
+
+    size_t tile_bytes = a.shared_mem ? a.shared_mem : 48 * 1024;
+    size_t tile_length =
+        min(a.pattern_length, max(tile_bytes / sizeof(Index), (size_t)1));
+    // Beyond 48 KiB the dynamic shared memory has to be opted into
+    if (tile_length * sizeof(Index) > 48 * 1024)
+      checkCudaErrors(cudaFuncSetAttribute(cuda_gather_shared<Index>,
+          cudaFuncAttributeMaxDynamicSharedMemorySize,
+          (int)(tile_length * sizeof(Index))));
+
+    threads_per_block =
+        min(max(a.local_work_size, (size_t)32), (size_t)1024);
+    blocks_per_grid = min(a.count, (size_t)sms * 8);
+    cuda_gather_shared<<<blocks_per_grid, threads_per_block,
+        tile_length * sizeof(Index), stream>>>(pattern, a.sparse, a.dense,
+        a.pattern_length, a.delta, a.wrap, a.count, tile_length);
+    break;
+  }
+  case CudaKernel::Scatter:
+    cuda_scatter<<<blocks_per_grid, threads_per_block, 0, stream>>>(pattern,
+        a.sparse, a.dense, a.pattern_length, a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::ScatterAtomic:
+    cuda_scatter_atomic<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, a.sparse, a.dense, a.pattern_length, a.delta, a.wrap,
+        a.count);
+    break;
+  case CudaKernel::ScatterAggregate:
+    cuda_scatter_aggregate<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, a.sparse, a.dense, a.pattern_length, a.delta, a.wrap,
+        a.count);
+    break;
+  case CudaKernel::GatherScatter:
+    cuda_gather_scatter<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern_scatter, a.sparse_scatter, pattern_gather, a.sparse_gather,
+        a.pattern_length, a.delta_scatter, a.delta_gather, a.wrap, a.count);
+    break;
+  case CudaKernel::GatherScatterAtomic:
+    cuda_gather_scatter_atomic<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern_scatter, a.sparse_scatter, pattern_gather,
+        a.sparse_gather, a.pattern_length, a.delta_scatter, a.delta_gather,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::GatherScatterAggregate:
+    cuda_gather_scatter_aggregate<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern_scatter, a.sparse_scatter, pattern_gather,
+        a.sparse_gather, a.pattern_length, a.delta_scatter, a.delta_gather,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::MultiGather:
+    cuda_multi_gather<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, pattern_gather, a.sparse, a.dense, a.pattern_length,
+        a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::MultiScatter:
+    cuda_multi_scatter<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, pattern_scatter, a.sparse, a.dense, a.pattern_length,
+        a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::MultiScatterAtomic:
+    cuda_multi_scatter_atomic<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern, pattern_scatter, a.sparse, a.dense,
+        a.pattern_length, a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::MultiScatterAggregate:
+    cuda_multi_scatter_aggregate<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern, pattern_scatter, a.sparse, a.dense,
+        a.pattern_length, a.delta, a.wrap, a.count);
+    break;
+  case CudaKernel::GatherReduce:
+    // A warp per iteration
+    threads_per_block = 256;
+    blocks_per_grid =
+        ((a.count * 32) + threads_per_block - 1) / threads_per_block;
+    cuda_gather_reduce<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, a.sparse, a.dense, a.pattern_length, a.delta, a.wrap,
+        a.count);
+    break;
+  case CudaKernel::ScatterAdd:
+    cuda_scatter_add<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        pattern, a.sparse, a.dense, a.pattern_length, a.delta, a.wrap,
+        a.count);
+    break;
+  case CudaKernel::ScatterAddAtomic:
+    cuda_scatter_add_atomic<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern, a.sparse, a.dense, a.pattern_length, a.delta,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::ScatterAddAggregate:
+    cuda_scatter_add_aggregate<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(pattern, a.sparse, a.dense, a.pattern_length, a.delta,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::GatherProcedural:
+    cuda_gather_procedural<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        a.runs, a.num_runs, a.sparse, a.dense, a.pattern_length, a.delta,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::ScatterProcedural:
+    cuda_scatter_procedural<<<blocks_per_grid, threads_per_block, 0, stream>>>(
+        a.runs, a.num_runs, a.sparse, a.dense, a.pattern_length, a.delta,
+        a.wrap, a.count);
+    break;
+  case CudaKernel::GatherScatterProcedural:
+    cuda_gather_scatter_procedural<<<blocks_per_grid, threads_per_block, 0,
+        stream>>>(a.runs_scatter, a.num_runs_scatter, a.sparse_scatter,
+        a.runs_gather, a.num_runs_gather, a.sparse_gather, a.pattern_length,
+        a.delta_scatter, a.delta_gather, a.wrap, a.count);
+    break;
+  }
 }
 
-float cuda_gather_scatter_wrapper(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
-    const double *sparse_gather, const size_t pattern_length,
-    const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
-    const size_t count) {
+static void cuda_launch(
+    CudaKernel kernel, const CudaKernelArgs &a, cudaStream_t stream) {
+  if (a.index_width == sizeof(uint16_t))
+    cuda_launch_indexed<uint16_t>(kernel, a, stream);
+  else if (a.index_width == sizeof(uint32_t))
+    cuda_launch_indexed<uint32_t>(kernel, a, stream);
+  else
+    cuda_launch_indexed<size_t>(kernel, a, stream);
+  checkCudaErrors(cudaGetLastError());
+}
+
+float cuda_kernel_wrapper(CudaKernel kernel, const CudaKernelArgs &args) {
   cudaEvent_t start, stop;
 
   checkCudaErrors(cudaEventCreate(&start));
   checkCudaErrors(cudaEventCreate(&stop));
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
-
   checkCudaErrors(cudaDeviceSynchronize());
   checkCudaErrors(cudaEventRecord(start));
 
-  cuda_gather_scatter<<<blocks_per_grid, threads_per_block>>>(pattern_scatter,
-      sparse_scatter, pattern_gather, sparse_gather, pattern_length,
-      delta_scatter, delta_gather, wrap, count);
-  checkCudaErrors(cudaGetLastError());
+  cuda_launch(kernel, args, 0);
 
   checkCudaErrors(cudaEventRecord(stop));
   checkCudaErrors(cudaEventSynchronize(stop));
@@ -258,132 +631,328 @@ float cuda_gather_scatter_wrapper(const size_t *pattern_scatter,
   return time_ms;
 }
 
-float cuda_gather_scatter_atomic_wrapper(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
-    const double *sparse_gather, const size_t pattern_length,
-    const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
-    const size_t count) {
-  cudaEvent_t start, stop;
+CudaGraph *cuda_graph_create(
+    CudaKernel kernel, const CudaKernelArgs &args, const size_t nruns) {
+  CudaGraph *graph = new CudaGraph;
+  checkCudaErrors(
+      cudaStreamCreateWithFlags(&graph->stream, cudaStreamNonBlocking));
+
+  graph->events.resize(nruns + 1);
+  for (cudaEvent_t &event : graph->events)
+    checkCudaErrors(cudaEventCreate(&event));
+
+  // Event records are captured as graph nodes between the kernel nodes
+  cudaGraph_t captured;
+  checkCudaErrors(
+      cudaStreamBeginCapture(graph->stream, cudaStreamCaptureModeThreadLocal));
+  for (size_t run = 0; run < nruns; ++run) {
+    checkCudaErrors(cudaEventRecord(graph->events[run], graph->stream));
+    cuda_launch(kernel, args, graph->stream);
+  }
+  checkCudaErrors(cudaEventRecord(graph->events[nruns], graph->stream));
+  checkCudaErrors(cudaStreamEndCapture(graph->stream, &captured));
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+  checkCudaErrors(cudaGraphInstantiateWithFlags(&graph->exec, captured, 0));
+  checkCudaErrors(cudaGraphDestroy(captured));
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+  return graph;
+}
 
+void cuda_graph_replay(CudaGraph *graph, float *times_ms) {
   checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
-
-  cuda_gather_scatter_atomic<<<blocks_per_grid, threads_per_block>>>(
-      pattern_scatter, sparse_scatter, pattern_gather, sparse_gather,
-      pattern_length, delta_scatter, delta_gather, wrap, count);
-  checkCudaErrors(cudaGetLastError());
-
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+  checkCudaErrors(cudaGraphLaunch(graph->exec, graph->stream));
+  checkCudaErrors(cudaStreamSynchronize(graph->stream));
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+  for (size_t run = 0; run + 1 < graph->events.size(); ++run)
+    checkCudaErrors(cudaEventElapsedTime(
+        &times_ms[run], graph->events[run], graph->events[run + 1]));
+}
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+struct CudaStreamBuffer {
+  CudaStreamWindow window;
+  size_t base;               // smallest pattern value
+  size_t span;               // elements touched by one iteration
+  void *dev_pattern;         // pattern - base, at the launch index width
+  std::vector<double *> dev; // one window per stream
+};
+
+struct CudaStreamer {
+  CudaKernel kernel;
+  CudaKernelArgs args;
+  size_t chunk;
+  std::vector<CudaStreamBuffer> buffers;
+  std::vector<cudaStream_t> streams;
+  std::vector<cudaEvent_t> kernel_start; // one per chunk
+  std::vector<cudaEvent_t> kernel_stop;
+};
+
+static bool cuda_is_gather_scatter(CudaKernel kernel) {
+  return kernel == CudaKernel::GatherScatter ||
+      kernel == CudaKernel::GatherScatterAtomic ||
+      kernel == CudaKernel::GatherScatterAggregate;
+}
 
-  return time_ms;
+// Copies the pattern [first, last) less base to the device as Index
+template <typename Index>
+static void *cuda_upload_rebased(
+    const size_t *first, const size_t *last, const size_t base) {
+  std::vector<Index> rebased;
+  rebased.reserve(last - first);
+  for (const size_t *index = first; index != last; ++index)
+    rebased.push_back(static_cast<Index>(*index - base));
+
+  void *dev;
+  checkCudaErrors(cudaMalloc(&dev, sizeof(Index) * rebased.size()));
+  checkCudaErrors(cudaMemcpy(dev, rebased.data(),
+      sizeof(Index) * rebased.size(), cudaMemcpyHostToDevice));
+  return dev;
 }
 
-float cuda_multi_gather_wrapper(const size_t *pattern,
-    const size_t *pattern_gather, const double *sparse, double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count) {
-  cudaEvent_t start, stop;
+CudaStreamer *cuda_streamer_create(CudaKernel kernel,
+    const CudaKernelArgs &args, const CudaStreamWindow *windows,
+    const size_t num_windows, const size_t streams, const size_t chunk) {
+  CudaStreamer *streamer = new CudaStreamer;
+  streamer->kernel = kernel;
+  streamer->args = args;
+  streamer->chunk = max(chunk, (size_t)1);
+
+  streamer->streams.resize(max(streams, (size_t)1));
+  for (cudaStream_t &stream : streamer->streams)
+    checkCudaErrors(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+
+  for (size_t w = 0; w < num_windows; ++w) {
+    const CudaStreamWindow &window = windows[w];
+    const size_t *first = window.pattern;
+    const size_t *last = window.pattern + window.pattern_length;
+
+    CudaStreamBuffer buffer;
+    buffer.window = window;
+    buffer.base = *std::min_element(first, last);
+    buffer.span = *std::max_element(first, last) - buffer.base + 1;
+
+    // The kernels index the window from 0, so the pattern is rebased, which
+    // never widens its indices
+    if (args.index_width == sizeof(uint16_t))
+      buffer.dev_pattern =
+          cuda_upload_rebased<uint16_t>(first, last, buffer.base);
+    else if (args.index_width == sizeof(uint32_t))
+      buffer.dev_pattern =
+          cuda_upload_rebased<uint32_t>(first, last, buffer.base);
+    else
+      buffer.dev_pattern =
+          cuda_upload_rebased<size_t>(first, last, buffer.base);
+
+    size_t chunk_span = buffer.span + window.delta * (streamer->chunk - 1);
+    buffer.dev.resize(streamer->streams.size());
+    for (double *&dev : buffer.dev)
+      checkCudaErrors(cudaMalloc((void **)&dev, sizeof(double) * chunk_span));
+
+    streamer->buffers.push_back(buffer);
+  }
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+  size_t chunks = (args.count + streamer->chunk - 1) / streamer->chunk;
+  streamer->kernel_start.resize(chunks);
+  streamer->kernel_stop.resize(chunks);
+  for (size_t c = 0; c < chunks; ++c) {
+    checkCudaErrors(cudaEventCreate(&streamer->kernel_start[c]));
+    checkCudaErrors(cudaEventCreate(&streamer->kernel_stop[c]));
+  }
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+  return streamer;
+}
+
+// Work on one stream is ordered, so a window is only refilled once the
+// previous chunk on its stream has been written back. Scatter windows of
+// different streams overlap when delta is below the pattern span, and the
+// overlap is then written back by whichever chunk finishes last.
+CudaStreamTimes cuda_streamer_run(CudaStreamer *streamer) {
+  const CudaKernelArgs &args = streamer->args;
+  size_t chunks = streamer->kernel_start.size();
 
   checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t c = 0; c < chunks; ++c) {
+    size_t s = c % streamer->streams.size();
+    cudaStream_t stream = streamer->streams[s];
+    size_t first = c * streamer->chunk;
+    size_t n = min(streamer->chunk, args.count - first);
+
+    for (CudaStreamBuffer &buffer : streamer->buffers) {
+      size_t offset = buffer.base + buffer.window.delta * first;
+      size_t length = buffer.span + buffer.window.delta * (n - 1);
+      checkCudaErrors(cudaMemcpyAsync(buffer.dev[s],
+          buffer.window.host + offset, sizeof(double) * length,
+          cudaMemcpyHostToDevice, stream));
+    }
+
+    CudaKernelArgs chunk_args = args;
+    chunk_args.count = n;
+    if (cuda_is_gather_scatter(streamer->kernel)) {
+      chunk_args.sparse_scatter = streamer->buffers[0].dev[s];
+      chunk_args.pattern_scatter = streamer->buffers[0].dev_pattern;
+      chunk_args.sparse_gather = streamer->buffers[1].dev[s];
+      chunk_args.pattern_gather = streamer->buffers[1].dev_pattern;
+    } else {
+      chunk_args.sparse = streamer->buffers[0].dev[s];
+      chunk_args.pattern = streamer->buffers[0].dev_pattern;
+    }
+
+    checkCudaErrors(cudaEventRecord(streamer->kernel_start[c], stream));
+    cuda_launch(streamer->kernel, chunk_args, stream);
+    checkCudaErrors(cudaEventRecord(streamer->kernel_stop[c], stream));
+
+    for (CudaStreamBuffer &buffer : streamer->buffers) {
+      if (!buffer.window.write_back)
+        continue;
+      size_t offset = buffer.base + buffer.window.delta * first;
+      size_t length = buffer.span + buffer.window.delta * (n - 1);
+      checkCudaErrors(cudaMemcpyAsync(buffer.window.host + offset,
+          buffer.dev[s], sizeof(double) * length, cudaMemcpyDeviceToHost,
+          stream));
+    }
+  }
 
-  cuda_multi_gather<<<blocks_per_grid, threads_per_block>>>(pattern,
-      pattern_gather, sparse, dense, pattern_length, delta, wrap, count);
-  checkCudaErrors(cudaGetLastError());
+  checkCudaErrors(cudaDeviceSynchronize());
+  auto stop = std::chrono::steady_clock::now();
+
+  CudaStreamTimes times;
+  times.total_ms =
+      std::chrono::duration<float, std::milli>(stop - start).count();
+  times.kernel_ms = 0;
+  for (size_t c = 0; c < chunks; ++c) {
+    float ms = 0;
+    checkCudaErrors(cudaEventElapsedTime(
+        &ms, streamer->kernel_start[c], streamer->kernel_stop[c]));
+    times.kernel_ms += ms;
+  }
 
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+  return times;
+}
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+void cuda_streamer_destroy(CudaStreamer *streamer) {
+  if (!streamer)
+    return;
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+  for (CudaStreamBuffer &buffer : streamer->buffers) {
+    checkCudaErrors(cudaFree(buffer.dev_pattern));
+    for (double *dev : buffer.dev)
+      checkCudaErrors(cudaFree(dev));
+  }
+  for (size_t c = 0; c < streamer->kernel_start.size(); ++c) {
+    checkCudaErrors(cudaEventDestroy(streamer->kernel_start[c]));
+    checkCudaErrors(cudaEventDestroy(streamer->kernel_stop[c]));
+  }
+  for (cudaStream_t stream : streamer->streams)
+    checkCudaErrors(cudaStreamDestroy(stream));
 
-  return time_ms;
+  delete streamer;
 }
 
-float cuda_multi_scatter_wrapper(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count) {
-  cudaEvent_t start, stop;
+void cuda_graph_destroy(CudaGraph *graph) {
+  if (!graph)
+    return;
 
-  checkCudaErrors(cudaEventCreate(&start));
-  checkCudaErrors(cudaEventCreate(&stop));
+  checkCudaErrors(cudaGraphExecDestroy(graph->exec));
+  for (cudaEvent_t event : graph->events)
+    checkCudaErrors(cudaEventDestroy(event));
+  checkCudaErrors(cudaStreamDestroy(graph->stream));
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
+  delete graph;
+}
 
-  checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
+__global__ void cuda_fill(double *dev, const size_t n, const uint64_t seed) {
+  const size_t stride = (size_t)blockDim.x * (size_t)gridDim.x;
+  for (size_t i = (size_t)blockDim.x * (size_t)blockIdx.x + threadIdx.x;
+       i < n; i += stride)
+    dev[i] = Spatter::random_value(seed, i);
+}
+
+void cuda_fill_random(double *dev, const size_t n, const uint64_t seed) {
+  if (n == 0)
+    return;
 
-  cuda_multi_scatter<<<blocks_per_grid, threads_per_block>>>(pattern,
-      pattern_scatter, sparse, dense, pattern_length, delta, wrap, count);
+  const size_t threads = 256;
+  const size_t blocks = std::min((n + threads - 1) / threads, (size_t)65535);
+  cuda_fill<<<blocks, threads>>>(dev, n, seed);
   checkCudaErrors(cudaGetLastError());
+}
 
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
+void cuda_flush_l2() {
+  static void *scratch = nullptr;
+  static size_t bytes = 0;
+  if (!scratch) {
+    int device = 0;
+    int l2_bytes = 0;
+    checkCudaErrors(cudaGetDevice(&device));
+    checkCudaErrors(
+        cudaDeviceGetAttribute(&l2_bytes, cudaDevAttrL2CacheSize, device));
+    bytes = 2 * static_cast<size_t>(std::max(l2_bytes, 1 << 20));
+    checkCudaErrors(cudaMalloc(&scratch, bytes));
+  }
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+  checkCudaErrors(cudaMemset(scratch, 0, bytes));
+  checkCudaErrors(cudaDeviceSynchronize());
+}
 
-  checkCudaErrors(cudaEventDestroy(start));
-  checkCudaErrors(cudaEventDestroy(stop));
+__global__ void cuda_stream_copy(double *c, const double *a, const size_t n) {
+  const size_t stride = (size_t)blockDim.x * (size_t)gridDim.x;
+  for (size_t i = (size_t)blockDim.x * (size_t)blockIdx.x + threadIdx.x;
+       i < n; i += stride)
+    c[i] = a[i];
+}
 
-  return time_ms;
+__global__ void cuda_stream_triad(double *a, const double *b, const double *c,
+    const double scalar, const size_t n) {
+  const size_t stride = (size_t)blockDim.x * (size_t)gridDim.x;
+  for (size_t i = (size_t)blockDim.x * (size_t)blockIdx.x + threadIdx.x;
+       i < n; i += stride)
+    a[i] = b[i] + scalar * c[i];
 }
 
-float cuda_multi_scatter_atomic_wrapper(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count) {
-  cudaEvent_t start, stop;
+void cuda_stream(
+    const size_t n, const int runs, float *copy_ms, float *triad_ms) {
+  double *a, *b, *c;
+  checkCudaErrors(cudaMalloc(&a, n * sizeof(double)));
+  checkCudaErrors(cudaMalloc(&b, n * sizeof(double)));
+  checkCudaErrors(cudaMalloc(&c, n * sizeof(double)));
+  cuda_fill_random(a, n, 1);
+  cuda_fill_random(b, n, 2);
+  cuda_fill_random(c, n, 3);
 
+  cudaEvent_t start, stop;
   checkCudaErrors(cudaEventCreate(&start));
   checkCudaErrors(cudaEventCreate(&stop));
 
-  int threads_per_block = min(pattern_length, (size_t)1024);
-  int blocks_per_grid =
-      ((pattern_length * count) + threads_per_block - 1) / threads_per_block;
-
+  const size_t threads = 1024;
+  const size_t blocks = std::min((n + threads - 1) / threads, (size_t)65535);
   checkCudaErrors(cudaDeviceSynchronize());
-  checkCudaErrors(cudaEventRecord(start));
-
-  cuda_multi_scatter_atomic<<<blocks_per_grid, threads_per_block>>>(pattern,
-      pattern_scatter, sparse, dense, pattern_length, delta, wrap, count);
-  checkCudaErrors(cudaGetLastError());
-
-  checkCudaErrors(cudaEventRecord(stop));
-  checkCudaErrors(cudaEventSynchronize(stop));
 
-  float time_ms = 0;
-  checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+  *copy_ms = *triad_ms = 0.0f;
+  for (int run = 0; run < runs; ++run) {
+    float time_ms = 0;
+    checkCudaErrors(cudaEventRecord(start));
+    cuda_stream_copy<<<blocks, threads>>>(c, a, n);
+    checkCudaErrors(cudaGetLastError());
+    checkCudaErrors(cudaEventRecord(stop));
+    checkCudaErrors(cudaEventSynchronize(stop));
+    checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+    if (run == 0 || time_ms < *copy_ms)
+      *copy_ms = time_ms;
+
+    checkCudaErrors(cudaEventRecord(start));
+    cuda_stream_triad<<<blocks, threads>>>(a, b, c, 3.0, n);
+    checkCudaErrors(cudaGetLastError());
+    checkCudaErrors(cudaEventRecord(stop));
+    checkCudaErrors(cudaEventSynchronize(stop));
+    checkCudaErrors(cudaEventElapsedTime(&time_ms, start, stop));
+    if (run == 0 || time_ms < *triad_ms)
+      *triad_ms = time_ms;
+  }
 
   checkCudaErrors(cudaEventDestroy(start));
   checkCudaErrors(cudaEventDestroy(stop));
-
-  return time_ms;
+  checkCudaErrors(cudaFree(a));
+  checkCudaErrors(cudaFree(b));
+  checkCudaErrors(cudaFree(c));
 }
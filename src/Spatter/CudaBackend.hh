@@ -2,36 +2,116 @@
 #define CUDA_BACKEND_HH
 
 #include <cstddef>
+#include <cstdint>
 
-float cuda_gather_wrapper(const size_t *pattern, const double *sparse,
-    double *dense, const size_t pattern_length, const size_t delta,
-    const size_t wrap, const size_t count);
-float cuda_scatter_wrapper(const size_t *pattern, double *sparse,
-    const double *dense, const size_t pattern_length, const size_t delta,
-    const size_t wrap, const size_t count);
-float cuda_scatter_atomic_wrapper(const size_t *pattern, double *sparse,
-    const double *dense, const size_t pattern_length, const size_t delta,
-    const size_t wrap, const size_t count);
-float cuda_gather_scatter_wrapper(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
-    const double *sparse_gather, const size_t pattern_length,
-    const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
-    const size_t count);
-float cuda_gather_scatter_atomic_wrapper(const size_t *pattern_scatter,
-    double *sparse_scatter, const size_t *pattern_gather,
-    const double *sparse_gather, const size_t pattern_length,
-    const size_t delta_scatter, const size_t delta_gather, const size_t wrap,
-    const size_t count);
-float cuda_multi_gather_wrapper(const size_t *pattern,
-    const size_t *pattern_gather, const double *sparse, double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count);
-float cuda_multi_scatter_wrapper(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count);
-float cuda_multi_scatter_atomic_wrapper(const size_t *pattern,
-    const size_t *pattern_scatter, double *sparse, const double *dense,
-    const size_t pattern_length, const size_t delta, const size_t wrap,
-    const size_t count);
+#include "PatternDescriptor.hh"
+
+// Kernels that can be captured into a CUDA Graph or timed through
+// cuda_kernel_wrapper. The Gather* variants are selected by --cuda-kernel.
+enum class CudaKernel {
+  Gather,
+  GatherVector2,
+  GatherVector4,
+  GatherShared,
+  Scatter,
+  ScatterAtomic,
+  ScatterAggregate,
+  GatherScatter,
+  GatherScatterAtomic,
+  GatherScatterAggregate,
+  MultiGather,
+  MultiScatter,
+  MultiScatterAtomic,
+  MultiScatterAggregate,
+  // gather-reduce and scatter-add
+  GatherReduce,
+  ScatterAdd,
+  ScatterAddAtomic,
+  ScatterAddAggregate,
+  // --procedural: indices computed from the runs of the patterns
+  GatherProcedural,
+  ScatterProcedural,
+  GatherScatterProcedural
+};
+
+// Device arguments of one launch, the ones a kernel doesn't take are ignored
+struct CudaKernelArgs {
+  // Device patterns of index_width bytes per index: uint16_t, uint32_t or
+  // size_t
+  const void *pattern = nullptr;
+  const void *pattern_gather = nullptr;
+  const void *pattern_scatter = nullptr;
+  size_t index_width = sizeof(size_t);
+  // Device copies of the descriptor runs, the *Procedural kernels only
+  const Spatter::PatternSegment *runs = nullptr;
+  const Spatter::PatternSegment *runs_gather = nullptr;
+  const Spatter::PatternSegment *runs_scatter = nullptr;
+  size_t num_runs = 0;
+  size_t num_runs_gather = 0;
+  size_t num_runs_scatter = 0;
+  double *sparse = nullptr;
+  double *sparse_gather = nullptr;
+  double *sparse_scatter = nullptr;
+  double *dense = nullptr;
+  size_t pattern_length = 0;
+  size_t delta = 0;
+  size_t delta_gather = 0;
+  size_t delta_scatter = 0;
+  size_t wrap = 1;
+  size_t count = 0;
+  size_t shared_mem = 0; // GatherShared pattern tile bytes, 0 = 48 KiB
+  size_t local_work_size = 1024; // GatherShared threads per block
+};
+
+// Fills n doubles at dev with the counter-based contents of the stream
+// seeded with seed, on the device rather than through a host copy
+void cuda_fill_random(double *dev, const size_t n, const uint64_t seed);
+
+// Evicts the device L2 with a memset of a buffer twice its size (--cold)
+void cuda_flush_l2();
+
+// STREAM copy and triad over n doubles (--stream), the fastest of runs
+// launches of each in ms
+void cuda_stream(
+    const size_t n, const int runs, float *copy_ms, float *triad_ms);
+
+// Times one launch of kernel on the default stream
+float cuda_kernel_wrapper(CudaKernel kernel, const CudaKernelArgs &args);
+
+// nruns back-to-back launches of one kernel captured into a CUDA Graph, with
+// an event recorded before and after each launch. The events are created
+// once with the graph.
+struct CudaGraph;
+CudaGraph *cuda_graph_create(
+    CudaKernel kernel, const CudaKernelArgs &args, const size_t nruns);
+// Replays the graph once, times_ms[i] is the time of launch i
+void cuda_graph_replay(CudaGraph *graph, float *times_ms);
+void cuda_graph_destroy(CudaGraph *graph);
+
+// A sparse array streamed through per-stream device windows (--cuda-streams).
+// The iterations [i, i + n) of a chunk only touch the host elements from
+// min(pattern) + delta * i to max(pattern) + delta * (i + n - 1).
+struct CudaStreamWindow {
+  double *host = nullptr;
+  const size_t *pattern = nullptr; // host pattern indexing this array
+  size_t pattern_length = 0;
+  size_t delta = 0;
+  bool write_back = false; // scatter target, copied back after each chunk
+};
+
+struct CudaStreamTimes {
+  float total_ms;  // first upload to last write back
+  float kernel_ms; // sum of the chunk kernels
+};
+
+// Runs kernel over args.count iterations in chunks of chunk iterations,
+// round robin over streams. windows[0] stands in for args.sparse, or for
+// args.sparse_scatter and windows[1] for args.sparse_gather with the gs
+// kernels. Buffers and events are created once with the streamer.
+struct CudaStreamer;
+CudaStreamer *cuda_streamer_create(CudaKernel kernel,
+    const CudaKernelArgs &args, const CudaStreamWindow *windows,
+    const size_t num_windows, const size_t streams, const size_t chunk);
+CudaStreamTimes cuda_streamer_run(CudaStreamer *streamer);
+void cuda_streamer_destroy(CudaStreamer *streamer);
 #endif
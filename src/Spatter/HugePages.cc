@@ -0,0 +1,230 @@
+/*!
+  \file HugePages.cc
+*/
+
+#include "HugePages.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace Spatter {
+
+namespace {
+
+const size_t huge_2m = size_t(1) << 21;
+const size_t huge_1g = size_t(1) << 30;
+
+enum class Backing { HugeTLB2M, HugeTLB1G, THP };
+
+struct Mapping {
+  void *base;
+  size_t length;
+  Backing backing;
+};
+
+std::atomic<HugePageMode> current_mode{HugePageMode::Off};
+
+// Mappings by the pointer handed out; allocations go through here from
+// several threads when buffers are first touched in parallel
+std::mutex mappings_mutex;
+std::unordered_map<const void *, Mapping> mappings;
+std::atomic<size_t> live_mappings{0};
+
+size_t round_up(size_t bytes, size_t page) {
+  return (bytes + page - 1) / page * page;
+}
+
+void *map_hugetlb(size_t length, int size_flag) {
+  void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1, 0);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+// Over-maps by one huge page and trims, so a 2 MiB aligned range is left
+// for the kernel to back with transparent huge pages
+void *map_thp(size_t length, void *&base) {
+  void *p = mmap(nullptr, length + huge_2m, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return nullptr;
+
+  const uintptr_t start = reinterpret_cast<uintptr_t>(p);
+  const uintptr_t aligned = round_up(start, huge_2m);
+  if (aligned > start)
+    munmap(p, aligned - start);
+  const size_t tail = huge_2m - (aligned - start);
+  if (tail > 0)
+    munmap(reinterpret_cast<void *>(aligned + length), tail);
+
+  base = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+  madvise(base, length, MADV_HUGEPAGE);
+#endif
+  return base;
+}
+
+// AnonHugePages of the mapping containing p, in KiB, or -1 if not found
+long anon_huge_kib(const void *p) {
+  std::ifstream smaps("/proc/self/smaps");
+  const uintptr_t address = reinterpret_cast<uintptr_t>(p);
+  bool inside = false;
+
+  std::string line;
+  while (std::getline(smaps, line)) {
+    std::istringstream fields(line);
+    std::string first;
+    fields >> first;
+
+    if (!first.empty() && first.back() == ':') {
+      if (inside && first.compare("AnonHugePages:") == 0) {
+        long kib = -1;
+        fields >> kib;
+        return kib;
+      }
+      continue;
+    }
+
+    // Mapping header: start-end perms offset dev inode [path]
+    const size_t dash = first.find('-');
+    if (dash != std::string::npos) {
+      const uintptr_t start = std::stoull(first.substr(0, dash), nullptr, 16);
+      const uintptr_t end = std::stoull(first.substr(dash + 1), nullptr, 16);
+      inside = start <= address && address < end;
+    }
+  }
+  return -1;
+}
+
+} // namespace
+
+bool hugepage_mode(const std::string &name, HugePageMode &mode) {
+  if (name.compare("off") == 0)
+    mode = HugePageMode::Off;
+  else if (name.compare("thp") == 0)
+    mode = HugePageMode::THP;
+  else if (name.compare("2m") == 0)
+    mode = HugePageMode::Huge2M;
+  else if (name.compare("1g") == 0)
+    mode = HugePageMode::Huge1G;
+  else
+    return false;
+  return true;
+}
+
+void set_hugepage_mode(HugePageMode mode) { current_mode = mode; }
+
+HugePageMode get_hugepage_mode() { return current_mode; }
+
+void *hugepage_alloc(size_t bytes) {
+  HugePageMode mode = current_mode;
+  if (mode == HugePageMode::Off || bytes < huge_2m)
+    return nullptr;
+
+  // Buffers smaller than a gigantic page would mostly waste it
+  const size_t page = (mode == HugePageMode::Huge1G && bytes >= huge_1g)
+      ? huge_1g
+      : huge_2m;
+  if (page == huge_2m && mode == HugePageMode::Huge1G)
+    mode = HugePageMode::Huge2M;
+
+  Mapping mapping{nullptr, 0, Backing::THP};
+  if (mode == HugePageMode::Huge2M || mode == HugePageMode::Huge1G) {
+    mapping.length = round_up(bytes, page);
+    mapping.backing = (mode == HugePageMode::Huge1G) ? Backing::HugeTLB1G
+                                                     : Backing::HugeTLB2M;
+    mapping.base = map_hugetlb(mapping.length,
+        (mode == HugePageMode::Huge1G) ? MAP_HUGE_1GB : MAP_HUGE_2MB);
+
+    if (!mapping.base) {
+      static std::once_flag warned;
+      std::call_once(warned, [] {
+        std::cerr << "Warning: MAP_HUGETLB failed (is the hugetlb pool "
+                     "reserved?), falling back to transparent huge pages"
+                  << std::endl;
+      });
+    }
+  }
+
+  if (!mapping.base) {
+    mapping.length = round_up(bytes, huge_2m);
+    mapping.backing = Backing::THP;
+    map_thp(mapping.length, mapping.base);
+  }
+
+  if (!mapping.base)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(mappings_mutex);
+  mappings[mapping.base] = mapping;
+  ++live_mappings;
+  return mapping.base;
+}
+
+bool hugepage_free(void *p) {
+  if (live_mappings == 0 || !p)
+    return false;
+
+  Mapping mapping;
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    auto it = mappings.find(p);
+    if (it == mappings.end())
+      return false;
+    mapping = it->second;
+    mappings.erase(it);
+    --live_mappings;
+  }
+
+  munmap(mapping.base, mapping.length);
+  return true;
+}
+
+std::string hugepage_backing(const void *p) {
+  Mapping mapping;
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex);
+    auto it = mappings.find(p);
+    if (it == mappings.end())
+      return "4 KiB pages";
+    mapping = it->second;
+  }
+
+  switch (mapping.backing) {
+  case Backing::HugeTLB2M:
+    return "2 MiB hugetlb";
+  case Backing::HugeTLB1G:
+    return "1 GiB hugetlb";
+  case Backing::THP:
+    break;
+  }
+
+  // Transparent huge pages are only known once touched
+  std::ostringstream out;
+  const long kib = anon_huge_kib(p);
+  out << "THP ";
+  if (kib < 0)
+    out << "unknown";
+  else
+    out << kib / 1024;
+  out << "/" << mapping.length / (1024 * 1024) << " MiB";
+  return out.str();
+}
+
+} // namespace Spatter
@@ -0,0 +1,40 @@
+/*!
+  \file HugePages.hh
+*/
+
+#ifndef SPATTER_HUGEPAGES_HH
+#define SPATTER_HUGEPAGES_HH
+
+#include <cstddef>
+#include <string>
+
+namespace Spatter {
+
+// --hugepages backing for large aligned_allocator buffers:
+//   THP:    2 MiB aligned mapping with madvise(MADV_HUGEPAGE)
+//   Huge2M: MAP_HUGETLB 2 MiB pages, THP if the pool is empty
+//   Huge1G: MAP_HUGETLB 1 GiB pages for buffers of at least 1 GiB, 2 MiB
+//           pages below that
+enum class HugePageMode { Off, THP, Huge2M, Huge1G };
+
+// By --hugepages name: "off", "thp", "2m" or "1g". false for others.
+bool hugepage_mode(const std::string &name, HugePageMode &mode);
+
+// Mode for allocations made from now on
+void set_hugepage_mode(HugePageMode mode);
+HugePageMode get_hugepage_mode();
+
+// bytes backed by huge pages under the current mode. nullptr when the mode
+// is Off, bytes is below 2 MiB or the mapping fails.
+void *hugepage_alloc(size_t bytes);
+
+// Unmaps p if hugepage_alloc returned it, false otherwise
+bool hugepage_free(void *p);
+
+// How the memory at p is backed, e.g. "2 MiB hugetlb", "THP 62/64 MiB" or
+// "4 KiB pages"
+std::string hugepage_backing(const void *p);
+
+} // namespace Spatter
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <functional>
 #include <getopt.h>
 #include <iomanip>
 #include <iostream>
@@ -21,15 +22,21 @@
 #endif
 
 #include "Configuration.hh"
+#include "Counters.hh"
 #include "JSONParser.hh"
+#include "Numa.hh"
+#include "Output.hh"
 #include "PatternParser.hh"
+#include "Random.hh"
+#include "SharedWindows.hh"
 #include "SpatterTypes.hh"
+#include "Stream.hh"
+#include "Sweep.hh"
+#include "Threads.hh"
+#include "Trace.hh"
+#include "Traffic.hh"
 
 namespace Spatter {
-static unsigned int seed_perthread;
-#ifdef USE_OPENMP
-#pragma omp threadprivate(seed_perthread)
-#endif
 
 static char *shortargs =
     (char *)"ab:cd:e:f:g:hj:k:l:m:n:o:p:r:s::t:u:v:w:x:y:z:";
@@ -61,10 +68,43 @@ const option longargs[] = {{"aggregate", no_argument, nullptr, 'a'},
     {"delta-scatter", required_argument, nullptr, 'y'},
     {"local-work-size", required_argument, nullptr, 'z'},
     {"tt-cores", required_argument, nullptr, 0},
+    {"tt-dtype", required_argument, nullptr, 0},
+    {"tt-memory", required_argument, nullptr, 0},
+    {"tt-batch", no_argument, nullptr, 0},
+    {"tt-devices", required_argument, nullptr, 0},
+    {"tt-tile-sort", no_argument, nullptr, 0},
+    {"cuda-graph", no_argument, nullptr, 0},
+    {"cuda-kernel", required_argument, nullptr, 0},
+    {"cuda-streams", required_argument, nullptr, 0},
+    {"cuda-chunk", required_argument, nullptr, 0},
+    {"simd", required_argument, nullptr, 0},
+    {"numa", required_argument, nullptr, 0},
+    {"hugepages", required_argument, nullptr, 0},
+    {"mpi-shared", required_argument, nullptr, 0},
+    {"mpi-remote", no_argument, nullptr, 0},
+    {"papi", required_argument, nullptr, 0},
+    {"output", required_argument, nullptr, 0},
+    {"bw-model", required_argument, nullptr, 0},
+    {"affinity", required_argument, nullptr, 0},
+    {"persistent", no_argument, nullptr, 0},
+    {"warmup", required_argument, nullptr, 0},
+    {"cold", no_argument, nullptr, 0},
+    {"adaptive", required_argument, nullptr, 0},
+    {"time-budget", required_argument, nullptr, 0},
+    {"stream", optional_argument, nullptr, 0},
+    {"corun", required_argument, nullptr, 0},
+    {"nt-stores", no_argument, nullptr, 0},
+    {"prefetch-distance", required_argument, nullptr, 0},
+    {"procedural", no_argument, nullptr, 0},
+    {"analyze", no_argument, nullptr, 0},
+    {"sweep", required_argument, nullptr, 0},
+    {"schedule", required_argument, nullptr, 0},
+    {"atomic-mode", required_argument, nullptr, 0},
+    {"accumulate", required_argument, nullptr, 0},
     {nullptr, no_argument, nullptr, 0}};
 
 struct ClArgs {
-  std::vector<std::unique_ptr<Spatter::ConfigurationBase>> configs;
+  Spatter::ConfigList configs;
 
   aligned_vector<double> sparse;
   double *dev_sparse;
@@ -89,9 +129,65 @@ struct ClArgs {
   bool atomic_fence;
   bool compress;
   bool dense_buffers;
+  std::string simd;
+  bool persistent;
+  bool nt_stores;
+  long int prefetch_distance;
+  bool procedural;
+  bool analyze;
+  unsigned long warmup;
+  bool cold;
+  double adaptive;
+  double time_budget;
+  std::string stream;
+  size_t corun;
+  std::string numa;
+  std::string hugepages;
+  std::string mpi_shared;
+  bool mpi_remote;
+  std::string papi;
+  std::vector<Spatter::SweepAxis> sweep;
+  std::string bw_model;
+  std::string affinity;
+  std::string schedule;
   int tt_cores;
+  std::string tt_dtype;
+  std::string tt_memory;
+  bool tt_batch;
+  int tt_devices;
+  bool tt_tile_sort;
+  bool cuda_graph;
+  std::string cuda_kernel;
+  size_t cuda_streams;
+  size_t cuda_chunk;
+  std::string atomic_mode;
+  std::string accumulate;
   unsigned long verbosity;
 
+  // -p TRACE: the trace being read, and a function that replaces configs
+  // with one for its next window. That returns 0 at the end of the trace and
+  // -1 on errors.
+  std::unique_ptr<Spatter::TraceReader> trace;
+  std::function<int()> next_trace_config;
+
+  // Seed of the buffer contents
+  uint64_t buffer_seed = 0;
+
+  // --stream: the backend's STREAM bandwidth, configs are reported as a
+  // percent of its peak
+  Spatter::StreamBaseline stream_baseline;
+
+  // --output json:<file> or csv:<file>
+  Spatter::ResultOutput output;
+
+  // Footprint of all configs in the shared buffers
+  Spatter::BufferPlan plan;
+
+  // Bytes and fastest times of the configs reported so far, for -a
+  size_t suite_bytes = 0;
+  double suite_seconds = 0.0;
+  size_t suite_configs = 0;
+
   void report_header() {
 #ifdef USE_MPI
     int numpes = 0;
@@ -109,7 +205,51 @@ struct ClArgs {
 #else
     std::cout << std::setw(15) << std::left << "config" << std::setw(15)
               << std::left << "bytes" << std::setw(15) << std::left << "time(s)"
-              << std::setw(15) << std::left << "bw(MB/s)" << std::endl;
+              << std::setw(15) << std::left << "bw(MB/s)";
+#ifdef USE_TENSTORRENT
+    if (backend.compare("tenstorrent") == 0)
+      std::cout << std::setw(15) << std::left << "h2d(s)" << std::setw(15)
+                << std::left << "d2h(s)";
+#endif
+#ifdef USE_CUDA
+    if (backend.compare("cuda") == 0 && cuda_streams > 0)
+      std::cout << std::setw(15) << std::left << "kernel(s)" << std::setw(15)
+                << std::left << "kernel bw(MB/s)";
+#endif
+#ifdef USE_OPENMP
+    if (backend.compare("openmp") == 0 && nt_stores)
+      std::cout << std::setw(15) << std::left << "stores";
+#endif
+    if ((backend.compare("serial") == 0 || backend.compare("openmp") == 0) &&
+        prefetch_distance != 0)
+      std::cout << std::setw(15) << std::left << "prefetch";
+    std::cout << std::endl;
+#endif
+  }
+
+  // Adds a config that has run to the suite totals and --output
+  void record(const Spatter::ConfigurationBase &config) {
+    suite_bytes += config.bytes_per_run();
+    suite_seconds += *std::min_element(
+        config.time_seconds.begin(), config.time_seconds.end());
+    ++suite_configs;
+
+    if (output.enabled())
+      output.record(config);
+  }
+
+  // With -a, the bandwidth of the whole suite: the bytes of one run of every
+  // config over the sum of their fastest times
+  void report_suite() {
+#ifndef USE_MPI
+    if (!aggregate || suite_configs < 2)
+      return;
+
+    std::cout << std::setw(15) << std::left << "suite" << std::setw(15)
+              << std::left << suite_bytes << std::setw(15) << std::left
+              << suite_seconds << std::setw(15) << std::left
+              << static_cast<double>(suite_bytes) / suite_seconds / 1000000.0
+              << std::endl;
 #endif
   }
 };
@@ -134,18 +274,52 @@ void help(char *progname) {
   std::cout << "Spatter\n";
   std::cout << "Usage: " << progname << "\n";
   std::cout << std::left << std::setw(10) << "-a (--aggregate)" << std::setw(40)
-            << "Aggregate (default off)" << std::left << "\n";
+            << "Aggregate: per-thread OpenMP times and total suite "
+            << "bandwidth (default off)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "   (--atomic-thread-fence) "
             << std::setw(40)
             << "Enable atomic thread fence for OpenMP kernels "
             << "(default off)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "   (--atomic-writes) "
             << std::setw(40)
-            << "Enable atomic writes for CUDA backend (default off) (TODO: "
-               "OpenMP atomics)"
-            << std::left << "\n";
+            << "Make CUDA scatter writes atomic, as --atomic-mode selects "
+            << "(default off). OpenMP scatter-add picks atomic or private "
+            << "accumulation with --accumulate" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--atomic-mode) "
+            << std::setw(40)
+            << "CUDA atomic writes: auto (plain writes if no index is "
+            << "written twice, else aggregate), aggregate (one atomic per "
+            << "distinct index per warp), exch (atomicExch per element) "
+            << "(default auto); scatter-add adds atomically wherever it "
+            << "conflicts" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--accumulate) "
+            << std::setw(40)
+            << "OpenMP scatter-add: auto (plain if no index is added to "
+            << "twice, else private if a copy of sparse per thread fits the "
+            << "LLC, else atomic), plain (unsynchronized adds), atomic (omp "
+            << "atomic per element), private (per-thread copies summed after "
+            << "each run) (default auto)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-b (--backend)" << std::setw(40)
             << "Backend (default serial)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--cuda-graph) "
+            << std::setw(40)
+            << "Capture all runs of a CUDA config into one CUDA Graph and "
+            << "replay it (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--cuda-kernel) "
+            << std::setw(40)
+            << "CUDA gather kernel: naive, vector2, vector4 (double2/double4 "
+            << "loads of contiguous runs), shared "
+            << "(pattern staged in -m bytes of shared memory, 0 = 48 KiB) "
+            << "(default naive)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--cuda-streams) "
+            << std::setw(40)
+            << "Keep sparse arrays on the host and stream chunks of count "
+            << "through this many CUDA streams (default 0, off)" << std::left
+            << "\n";
+  std::cout << std::left << std::setw(10) << "   (--cuda-chunk) "
+            << std::setw(40)
+            << "Iterations per streamed chunk (default 0, four chunks per "
+            << "stream)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-c (--compress)" << std::setw(40)
             << " Enable compression of pattern indices" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-d (--delta)" << std::setw(40)
@@ -154,9 +328,148 @@ void help(char *progname) {
             << std::setw(40)
             << "Enable multiple dense buffers for OpenMP kernels "
             << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--simd) "
+            << std::setw(40)
+            << "OpenMP gather/scatter kernels: auto (best the CPU supports), "
+            << "scalar (compiler-vectorized), avx2, avx512, sve "
+            << "(default auto)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--numa) "
+            << std::setw(40)
+            << "Buffer placement: off, touch (first touch along the kernels' "
+            << "iteration partition), interleave, bind (touch with threads "
+            << "bound to nodes); interleave and bind need libnuma "
+            << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--hugepages) "
+            << std::setw(40)
+            << "Back buffers of 2 MiB or more with huge pages: off, thp "
+            << "(madvise), 2m, 1g (MAP_HUGETLB, thp if the pool is empty; 1g "
+            << "only for buffers of 1 GiB or more) "
+            << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--mpi-shared) "
+            << std::setw(40)
+            << "Allocate buffers once per node in an MPI shared memory "
+            << "window, each rank starting one delta past the previous: off, "
+            << "sparse, all (sparse and sparse-gather); needs MPI "
+            << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--mpi-remote) "
+            << std::setw(40)
+            << "Serial gather and scatter over a sparse buffer "
+            << "block-distributed across the ranks, with MPI_Get and "
+            << "MPI_Accumulate batched per owning rank; needs MPI "
+            << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--papi) "
+            << std::setw(40)
+            << "Count comma-separated PAPI events (e.g. "
+            << "PAPI_L3_TCM,PAPI_TLB_DM,PAPI_STL_CCY) over the timed kernels, "
+            << "reported per run; needs PAPI "
+            << "(default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--output) "
+            << std::setw(40)
+            << "Also write every config's parameters and run times, with "
+            << "the build and host information, to a file: json:<file> or "
+            << "csv:<file> (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--bw-model) "
+            << std::setw(40)
+            << "Bytes the bandwidth counts: payload (sparse-side elements), "
+            << "rw (every element read and written, like STREAM), full (rw "
+            << "plus index reads) (default payload)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--affinity) "
+            << std::setw(40)
+            << "Pin OpenMP threads: compact (fill a package core by core), "
+            << "scatter (round-robin over packages and cores), list:<cpus> "
+            << "(e.g. list:0-3,8) (default unpinned)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--nt-stores) "
+            << std::setw(40)
+            << "Non-temporal stores for the OpenMP gather output and scatter "
+            << "targets (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--prefetch-distance) "
+            << std::setw(40)
+            << "Serial/OpenMP gather, gs and multigather prefetch the rows "
+            << "this many iterations ahead; auto tries 0-64 and keeps the "
+            << "fastest per config (default 0, off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--procedural) "
+            << std::setw(40)
+            << "Compute the indices of UNIFORM, MS1 and LAPLACIAN patterns "
+            << "in the gather, scatter and gs kernels instead of loading "
+            << "them (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--sweep) "
+            << std::setw(40)
+            << "Run the -p config once for every combination of values, "
+            << "e.g. threads=1..64x2;delta=1..64x2;count=2^20..2^24, over "
+            << "kernel, threads, tt-cores, delta, count and wrap, in "
+            << "buffers sized for the largest (default off)" << std::left
+            << "\n";
+  std::cout << std::left << std::setw(10) << "   (--analyze) "
+            << std::setw(40)
+            << "Print the cache lines and pages each config touches per "
+            << "iteration, its reuse distances, strides and predicted "
+            << "TensTorrent tile hits (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--warmup) "
+            << std::setw(40)
+            << "Untimed runs of each config before its timed runs "
+            << "(default 0)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--cold) "
+            << std::setw(40)
+            << "Flush the caches between timed runs, untimed: the host "
+            << "caches by streaming over twice the last-level cache, the "
+            << "device L2 on CUDA (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--adaptive) "
+            << std::setw(40)
+            << "Stop a config's timed runs once the 95% confidence interval "
+            << "of its mean run time is within this fraction of the mean, "
+            << "e.g. 0.01, or --time-budget runs out; -r is the most runs, "
+            << "and the run time statistics are printed (default off)"
+            << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--time-budget) "
+            << std::setw(40)
+            << "Seconds of timed runs --adaptive spends on a config at most "
+            << "(default none)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--corun) "
+            << std::setw(40)
+            << "After each group of this many configs has run alone, run "
+            << "them at once, each on its own OpenMP team with the --affinity "
+            << "CPUs after the previous config's and every run started "
+            << "together, and report their slowdown; the configs share the "
+            << "suite's buffers (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--stream) "
+            << std::setw(40)
+            << "Report each config's bandwidth as a percent of the backend's "
+            << "STREAM copy/triad peak, reusing the host's cached result; "
+            << "--stream=run measures it again (default off)" << std::left
+            << "\n";
+  std::cout << std::left << std::setw(10) << "   (--persistent) "
+            << std::setw(40)
+            << "Run all timed OpenMP runs in one parallel region with a "
+            << "barrier between runs; a run spans its first thread's start "
+            << "to its last thread's finish (default off)" << std::left
+            << "\n";
+  std::cout << std::left << std::setw(10) << "   (--schedule) "
+            << std::setw(40)
+            << "OpenMP kernel loop schedule: static, static,N, dynamic,N, "
+            << "guided[,N] (default static)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "   (--tt-cores) "
             << std::setw(40)
             << "Number of TensTorrent cores to use (0=all, default 0)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--tt-dtype) "
+            << std::setw(40)
+            << "TensTorrent element type: bf16, fp32, u32, u64-as-2xu32 "
+            << "(default bf16)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--tt-memory) "
+            << std::setw(40)
+            << "TensTorrent buffer placement: l1, dram, auto (L1 if the "
+            << "working set fits) (default dram)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--tt-batch) "
+            << std::setw(40)
+            << "Enqueue all TensTorrent runs back-to-back and wait once, "
+            << "reporting the average run (default off)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--tt-devices) "
+            << std::setw(40)
+            << "Number of TensTorrent cards to shard count across "
+            << "(default 1)" << std::left << "\n";
+  std::cout << std::left << std::setw(10) << "   (--tt-tile-sort) "
+            << std::setw(40)
+            << "Order TensTorrent gathers by source tile so each tile is "
+            << "fetched once per block (default off)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-e (--boundary)" << std::setw(40)
             << " Set Boundary (limits max value of pattern using modulo)"
             << std::left << "\n";
@@ -173,7 +486,9 @@ void help(char *progname) {
             << " Set Pattern Size"
                " (truncates pattern to pattern-size)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-k (--kernel)" << std::setw(40)
-            << "Kernel (default gather)" << std::left << "\n";
+            << "Kernel: gather, scatter, gs, multigather, multiscatter, "
+            << "gather-reduce, scatter-add (default gather)" << std::left
+            << "\n";
   std::cout << std::left << std::setw(10) << "-l (--count)" << std::setw(40)
             << "Set Number of Gathers or Scatters to Perform (default 1024)"
             << std::left << "\n";
@@ -186,11 +501,14 @@ void help(char *progname) {
   std::cout << std::left << std::setw(10) << "-o (--op)" << std::setw(40)
             << "TODO" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-p (--pattern)" << std::setw(40)
-            << "Set Pattern" << std::left << "\n";
+            << "Set Pattern (TRACE:<file>[:window] streams a gzipped binary "
+            << "address trace in windows of 1024 by default)" << std::left
+            << "\n";
   std::cout << std::left << std::setw(10) << "-r (--runs)" << std::setw(40)
             << "Set Number of Runs (default 10)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-s (--random)" << std::setw(40)
-            << "Set Random Seed (default random)" << std::left << "\n";
+            << "Set Random Seed of the buffer contents (default fixed, "
+            << "-s alone seeds from the time)" << std::left << "\n";
   std::cout << std::left << std::setw(10) << "-t (--omp-threads)"
             << std::setw(40)
             << "Set Number of Threads (default 1 if !USE_OPENMP or backend != "
@@ -217,10 +535,24 @@ void help(char *progname) {
 void usage(char *progname) {
   std::cout << "Usage: " << progname
             << " [-a aggregate] [--atomic-thread-fence] [--atomic-writes] "
-               "[-b backend] [-c compress] "
-               "[-d delta] [--dense-buffers] [-e "
+               "[--atomic-mode mode] [--accumulate mode] "
+               "[-b backend] [--cuda-graph] [--cuda-kernel kernel] "
+               "[--cuda-streams streams] [--cuda-chunk chunk] "
+               "[-c compress] "
+               "[-d delta] [--dense-buffers] [--simd isa] [--numa mode] [--hugepages size] "
+               "[--mpi-shared buffers] [--mpi-remote] [--papi events] "
+               "[--output format:file] "
+               "[--bw-model model] "
+               "[--affinity affinity] [--persistent] [--schedule schedule] "
+               "[--nt-stores] [--prefetch-distance distance] "
+               "[--procedural] [--sweep spec] [--analyze] [--warmup runs] "
+               "[--cold] "
+               "[--adaptive target] [--time-budget seconds] "
+               "[--stream[=run]] [--corun configs] [-e "
                "boundary] [-f input file] [-g inner gather pattern] "
-               "[--tt-cores cores] "
+               "[--tt-cores cores] [--tt-dtype dtype] "
+               "[--tt-memory memory] [--tt-batch] "
+               "[--tt-devices devices] [--tt-tile-sort] "
                "[-h "
                "help] [-j pattern-size] [-k kernel] [-l count] [-m "
                "shared-memory] [-n name] [-o op]"
@@ -254,6 +586,31 @@ int read_int_arg(std::string cl, int &arg, const int min_value,
   return 0;
 }
 
+// Reads a positive number
+int read_double_arg(
+    std::string cl, double &arg, const std::string &err_msg) {
+  double parsed_arg;
+
+  try {
+    parsed_arg = std::stod(cl);
+  } catch (const std::invalid_argument &ia) {
+    std::cerr << err_msg << std::endl;
+    return -1;
+  } catch (const std::out_of_range &oor) {
+    std::cerr << err_msg << std::endl;
+    return -1;
+  }
+
+  if (!(parsed_arg > 0.0)) {
+    std::cerr << err_msg << std::endl;
+    return -1;
+  }
+
+  arg = parsed_arg;
+
+  return 0;
+}
+
 int read_ul_arg(std::string cl, size_t &arg, const long long min_value,
   const std::string &err_msg) {
   long long parsed_arg;
@@ -278,6 +635,143 @@ int read_ul_arg(std::string cl, size_t &arg, const long long min_value,
   return 0;
 }
 
+// Fills buf in one contiguous block per thread, each thread first touching
+// its own block
+static void fill_buffer(
+    double *buf, const size_t size, const uint64_t seed, const int nthreads) {
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(nthreads)
+  {
+    const size_t t = static_cast<size_t>(omp_get_thread_num());
+    const size_t n = static_cast<size_t>(omp_get_num_threads());
+    fill_random(buf, size / n * t + std::min(t, size % n),
+        size / n * (t + 1) + std::min(t + 1, size % n), seed);
+  }
+#else
+  (void)nthreads;
+  fill_random(buf, 0, size, seed);
+#endif
+}
+
+// Fills buf to size with random values for --numa. The thread that runs
+// iteration i of the kernels' omp for over count first touches
+// [stride * i, stride * (i + 1)); the last iteration also takes the tail.
+static void numa_fill(aligned_vector<double> &buf, const size_t size,
+    const size_t stride, const size_t count, const int nthreads,
+    const NumaMode mode, const uint64_t seed) {
+  buf.resize(size);
+  if (mode == NumaMode::Interleave)
+    numa_interleave(buf.data(), buf.size());
+
+  const size_t iterations = std::max(count, static_cast<size_t>(1));
+#ifdef USE_OPENMP
+#pragma omp parallel for num_threads(nthreads)
+#else
+  (void)nthreads;
+#endif
+  for (size_t i = 0; i < iterations; ++i) {
+    const size_t lo = std::min(size, stride * i);
+    const size_t hi =
+        (i + 1 == iterations) ? size : std::min(size, stride * (i + 1));
+    fill_random(buf.data(), lo, hi, seed);
+  }
+}
+
+static void numa_fill_buffers(ClArgs &cl, const BufferPlan &plan,
+    const NumaMode mode, const int nthreads, const bool dense_perthread) {
+  // Pool threads keep their node for the kernels' parallel regions
+  if (mode == NumaMode::Bind) {
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(nthreads)
+    numa_bind_thread(omp_get_thread_num(), nthreads);
+#else
+    numa_bind_thread(0, 1);
+#endif
+  }
+
+  // Buffers are sized for the config reaching furthest into them, so that
+  // config's count and stride partition them
+  auto fill = [&](aligned_vector<double> &buf, const size_t size,
+                  const BufferPlan::Extent &extent, const uint64_t stream) {
+    if (buf.size() >= size)
+      return;
+
+    numa_fill(buf, size, extent.stride, extent.count, nthreads, mode,
+        stream_seed(cl.buffer_seed, stream));
+  };
+
+  fill(cl.sparse, cl.sparse_size, plan.sparse, Sparse);
+  fill(cl.sparse_gather, cl.sparse_gather_size, plan.sparse_gather,
+      SparseGather);
+  fill(cl.sparse_scatter, cl.sparse_scatter_size, plan.sparse_scatter,
+      SparseScatter);
+
+#ifdef USE_OPENMP
+  if (dense_perthread) {
+    cl.dense_perthread.resize(nthreads);
+
+    // Each private dense buffer is first touched by the thread that owns it
+#pragma omp parallel num_threads(nthreads)
+    {
+      const int t = omp_get_thread_num();
+      aligned_vector<double> &dense = cl.dense_perthread[t];
+      if (dense.size() < cl.dense_size) {
+        dense.resize(cl.dense_size);
+        if (mode == NumaMode::Interleave)
+          numa_interleave(dense.data(), dense.size());
+        fill_random(dense.data(), 0, dense.size(),
+            stream_seed(cl.buffer_seed,
+                DensePerThread + static_cast<uint64_t>(t)));
+      }
+    }
+    return;
+  }
+#else
+  (void)dense_perthread;
+#endif
+
+  // Iteration i writes the dense row (i % wrap)
+  fill(cl.dense, cl.dense_size, plan.dense, Dense);
+}
+
+static void numa_report(const ClArgs &cl, const int nthreads) {
+  std::cout << "NUMA placement (" << cl.numa << ", " << numa_nodes()
+            << " node(s))" << std::endl;
+
+  std::vector<int> thread_nodes(nthreads, -1);
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(nthreads)
+  thread_nodes[omp_get_thread_num()] = numa_thread_node();
+#else
+  thread_nodes[0] = numa_thread_node();
+#endif
+
+  std::cout << "  thread nodes:";
+  for (int node : thread_nodes)
+    std::cout << " " << (node < 0 ? std::string("?") : std::to_string(node));
+  std::cout << std::endl;
+
+  auto pages = [](const std::string &name, const aligned_vector<double> &buf) {
+    if (buf.empty())
+      return;
+
+    std::vector<size_t> nodes = numa_page_nodes(buf.data(), buf.size());
+    std::cout << "  " << name << " pages:";
+    if (nodes.empty())
+      std::cout << " unknown (built without libnuma)";
+    for (size_t n = 0; n < nodes.size(); ++n)
+      std::cout << " node " << n << "=" << nodes[n];
+    std::cout << std::endl;
+  };
+
+  pages("sparse", cl.sparse);
+  pages("sparse_gather", cl.sparse_gather);
+  pages("sparse_scatter", cl.sparse_scatter);
+  pages("dense", cl.dense);
+  for (size_t t = 0; t < cl.dense_perthread.size(); ++t)
+    pages("dense[" + std::to_string(t) + "]", cl.dense_perthread[t]);
+}
+
 int parse_input(const int argc, char **argv, ClArgs &cl) {
   cl.sparse_size = 0;
   cl.sparse_gather_size = 0;
@@ -295,7 +789,39 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
   cl.atomic_fence = false;
   cl.compress = false;
   cl.dense_buffers = false;
+  cl.simd = "auto";
+  cl.persistent = false;
+  cl.nt_stores = false;
+  cl.prefetch_distance = 0;
+  cl.procedural = false;
+  cl.analyze = false;
+  cl.warmup = 0;
+  cl.cold = false;
+  cl.adaptive = 0.0;
+  cl.time_budget = 0.0;
+  cl.stream = "off";
+  cl.corun = 0;
+  cl.numa = "off";
+  cl.hugepages = "off";
+  cl.mpi_shared = "off";
+  cl.mpi_remote = false;
+  cl.papi = "";
+  cl.sweep.clear();
+  cl.bw_model = "payload";
+  cl.affinity = "";
+  cl.schedule = "static";
   cl.tt_cores = 0;  // 0 means use all available cores
+  cl.tt_dtype = "bf16";
+  cl.tt_memory = "dram";
+  cl.tt_batch = false;
+  cl.tt_devices = 1;
+  cl.tt_tile_sort = false;
+  cl.cuda_graph = false;
+  cl.cuda_kernel = "naive";
+  cl.atomic_mode = "auto";
+  cl.accumulate = "auto";
+  cl.cuda_streams = 0;
+  cl.cuda_chunk = 0;
   cl.verbosity = 1;
 
   // In flag alphabetical order
@@ -305,7 +831,42 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
   std::string backend = cl.backend;
   bool compress = cl.compress;
   bool dense_buffers = cl.dense_buffers;
+  std::string simd = cl.simd;
+  bool persistent = cl.persistent;
+  bool nt_stores = cl.nt_stores;
+  long int prefetch_distance = cl.prefetch_distance;
+  bool procedural = cl.procedural;
+  bool analyze = cl.analyze;
+  unsigned long warmup = cl.warmup;
+  bool cold = cl.cold;
+  double adaptive = cl.adaptive;
+  double time_budget = cl.time_budget;
+  std::string stream = cl.stream;
+  size_t corun = cl.corun;
+  std::string numa = cl.numa;
+  std::string hugepages = cl.hugepages;
+  std::string mpi_shared = cl.mpi_shared;
+  bool mpi_remote = cl.mpi_remote;
+  std::string papi = cl.papi;
+  std::vector<Spatter::SweepAxis> sweep = cl.sweep;
+  std::string bw_model = cl.bw_model;
+  std::string affinity = cl.affinity;
+  std::string schedule = cl.schedule;
+  std::vector<int> affinity_cpus;
+  Spatter::Schedule loop_schedule = {Spatter::LoopSchedule::Static, 0};
   int tt_cores = cl.tt_cores;
+  std::string tt_dtype = cl.tt_dtype;
+  std::string tt_memory = cl.tt_memory;
+  bool tt_batch = cl.tt_batch;
+  int tt_devices = cl.tt_devices;
+  bool tt_tile_sort = cl.tt_tile_sort;
+  bool cuda_graph = cl.cuda_graph;
+  std::string cuda_kernel = cl.cuda_kernel;
+  std::string atomic_mode = cl.atomic_mode;
+  std::string accumulate = cl.accumulate;
+  Spatter::Accumulate accumulate_mode = Spatter::Accumulate::Auto;
+  size_t cuda_streams = cl.cuda_streams;
+  size_t cuda_chunk = cl.cuda_chunk;
   size_t delta = 8;
   size_t boundary = 0;
 
@@ -313,17 +874,19 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
   std::string json_fname = "";
 
   aligned_vector<size_t> pattern_gather;
+  Spatter::PatternDescriptor pattern_gather_desc;
   std::stringstream pattern_gather_string;
 
   size_t pattern_size = 0;
   std::string kernel = "gather";
   size_t count = 1024;
-  size_t shared_mem;
+  size_t shared_mem = 0;
   std::string config_name = "";
   size_t op;
 
   std::stringstream pattern_string;
   aligned_vector<size_t> pattern;
+  Spatter::PatternDescriptor pattern_desc;
 
   unsigned long nruns = 10;
   long int seed = -1;
@@ -336,6 +899,7 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
 
   std::stringstream pattern_scatter_string;
   aligned_vector<size_t> pattern_scatter;
+  Spatter::PatternDescriptor pattern_scatter_desc;
 
   unsigned long verbosity = cl.verbosity;
   size_t wrap = 1;
@@ -358,14 +922,293 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
       if (strcmp(longargs[option_index].name, "atomic-thread-fence") == 0) {
         atomic_fence = true;
       }
+      if (strcmp(longargs[option_index].name, "atomic-mode") == 0) {
+        atomic_mode = optarg;
+        std::transform(atomic_mode.begin(), atomic_mode.end(),
+            atomic_mode.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if ((atomic_mode.compare("auto") != 0) &&
+            (atomic_mode.compare("aggregate") != 0) &&
+            (atomic_mode.compare("exch") != 0)) {
+          std::cerr << "Valid atomic modes are: auto, aggregate, exch"
+                    << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "accumulate") == 0) {
+        accumulate = optarg;
+        std::transform(accumulate.begin(), accumulate.end(),
+            accumulate.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if (!Spatter::parse_accumulate(accumulate, accumulate_mode)) {
+          std::cerr << "Valid accumulate modes are: auto, plain, atomic, "
+                       "private"
+                    << std::endl;
+          return -1;
+        }
+      }
       if (strcmp(longargs[option_index].name, "dense-buffers") == 0) {
         dense_buffers = true;
       }
+      if (strcmp(longargs[option_index].name, "simd") == 0) {
+        simd = optarg;
+        std::transform(simd.begin(), simd.end(), simd.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if ((simd.compare("auto") != 0) && (simd.compare("scalar") != 0) &&
+            (simd.compare("avx2") != 0) && (simd.compare("avx512") != 0) &&
+            (simd.compare("sve") != 0)) {
+          std::cerr << "Valid SIMD kernels are: auto, scalar, avx2, avx512, sve"
+                    << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "numa") == 0) {
+        numa = optarg;
+        std::transform(numa.begin(), numa.end(), numa.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        Spatter::NumaMode mode;
+        if (!Spatter::numa_mode(numa, mode)) {
+          std::cerr << "Valid NUMA modes are: off, touch, interleave, bind"
+                    << std::endl;
+          return -1;
+        }
+
+        if ((mode == Spatter::NumaMode::Interleave ||
+                mode == Spatter::NumaMode::Bind) &&
+            !Spatter::numa_policies_available()) {
+          std::cerr << "Parsing Error: --numa " << numa
+                    << " requires libnuma (configure with -DUSE_NUMA=ON)"
+                    << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "hugepages") == 0) {
+        hugepages = optarg;
+        std::transform(hugepages.begin(), hugepages.end(), hugepages.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        Spatter::HugePageMode mode;
+        if (!Spatter::hugepage_mode(hugepages, mode)) {
+          std::cerr << "Valid huge page sizes are: off, thp, 2m, 1g"
+                    << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "mpi-shared") == 0) {
+        mpi_shared = optarg;
+        std::transform(mpi_shared.begin(), mpi_shared.end(),
+            mpi_shared.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        Spatter::SharedMode mode;
+        if (!Spatter::shared_mode(mpi_shared, mode)) {
+          std::cerr << "Valid MPI shared buffers are: off, sparse, all"
+                    << std::endl;
+          return -1;
+        }
+
+        if (mode != Spatter::SharedMode::Off &&
+            !Spatter::shared_windows_available()) {
+          std::cerr << "Parsing Error: --mpi-shared " << mpi_shared
+                    << " requires MPI (configure with -DUSE_MPI=ON)"
+                    << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "mpi-remote") == 0) {
+        if (!Spatter::shared_windows_available()) {
+          std::cerr << "Parsing Error: --mpi-remote requires MPI (configure "
+                       "with -DUSE_MPI=ON)"
+                    << std::endl;
+          return -1;
+        }
+        mpi_remote = true;
+      }
+      if (strcmp(longargs[option_index].name, "papi") == 0) {
+        papi = optarg;
+
+        std::string error;
+        if (!Spatter::set_counter_events(papi, error)) {
+          std::cerr << "Parsing Error: " << error << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "sweep") == 0) {
+        std::string error;
+        if (!Spatter::parse_sweep(optarg, sweep, error)) {
+          std::cerr << "Parsing Error: " << error << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "output") == 0) {
+        std::string error;
+        if (!cl.output.open(optarg, error)) {
+          std::cerr << "Parsing Error: " << error << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "bw-model") == 0) {
+        bw_model = optarg;
+        std::transform(bw_model.begin(), bw_model.end(), bw_model.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        Spatter::BandwidthModel model;
+        if (!Spatter::bandwidth_model(bw_model, model)) {
+          std::cerr << "Valid bandwidth models are: payload, rw, full"
+                    << std::endl;
+          return -1;
+        }
+        Spatter::set_bandwidth_model(model);
+      }
+      if (strcmp(longargs[option_index].name, "affinity") == 0) {
+        affinity = optarg;
+        std::transform(affinity.begin(), affinity.end(), affinity.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        std::string err;
+        if (!Spatter::affinity_cpus(affinity, affinity_cpus, err)) {
+          std::cerr << "Parsing Error: " << err << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "persistent") == 0) {
+        persistent = true;
+      }
+      if (strcmp(longargs[option_index].name, "nt-stores") == 0) {
+        nt_stores = true;
+      }
+      if (strcmp(longargs[option_index].name, "prefetch-distance") == 0) {
+        // auto is passed on as -1
+        size_t distance = 0;
+        if (strcmp(optarg, "auto") == 0)
+          prefetch_distance = -1;
+        else if (read_ul_arg(optarg, distance, 0,
+                     "Parsing Error: Invalid prefetch distance") == -1)
+          return -1;
+        else
+          prefetch_distance = static_cast<long int>(distance);
+      }
+      if (strcmp(longargs[option_index].name, "procedural") == 0) {
+        procedural = true;
+      }
+      if (strcmp(longargs[option_index].name, "analyze") == 0) {
+        analyze = true;
+      }
+      if (strcmp(longargs[option_index].name, "warmup") == 0) {
+        if (read_ul_arg(optarg, warmup, 0,
+                "Parsing Error: Invalid Number of Warmup Runs") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "cold") == 0) {
+        cold = true;
+      }
+      if (strcmp(longargs[option_index].name, "adaptive") == 0) {
+        if (read_double_arg(optarg, adaptive,
+                "Parsing Error: Invalid Adaptive Target") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "time-budget") == 0) {
+        if (read_double_arg(optarg, time_budget,
+                "Parsing Error: Invalid Time Budget") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "corun") == 0) {
+        if (read_ul_arg(optarg, corun, 2,
+                "Parsing Error: Invalid Co-run Group Size") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "stream") == 0) {
+        stream = optarg ? optarg : "cached";
+        if (stream.compare("cached") != 0 && stream.compare("run") != 0) {
+          std::cerr << "Parsing Error: Invalid --stream mode " << stream
+                    << ", valid modes are: cached, run" << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "schedule") == 0) {
+        schedule = optarg;
+        std::transform(schedule.begin(), schedule.end(), schedule.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if (!Spatter::parse_schedule(schedule, loop_schedule)) {
+          std::cerr << "Valid schedules are: static, static,N, dynamic,N, "
+                       "guided, guided,N"
+                    << std::endl;
+          return -1;
+        }
+      }
       if (strcmp(longargs[option_index].name, "tt-cores") == 0) {
         if (read_int_arg(optarg, tt_cores, 0, 
             "Parsing Error: Invalid number of TensTorrent cores") == -1)
           return -1;
       }
+      if (strcmp(longargs[option_index].name, "tt-dtype") == 0) {
+        tt_dtype = optarg;
+        std::transform(tt_dtype.begin(), tt_dtype.end(), tt_dtype.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if ((tt_dtype.compare("bf16") != 0) &&
+            (tt_dtype.compare("fp32") != 0) && (tt_dtype.compare("u32") != 0) &&
+            (tt_dtype.compare("u64-as-2xu32") != 0)) {
+          std::cerr << "Valid TensTorrent data types are: bf16, fp32, u32, "
+                       "u64-as-2xu32" << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "tt-devices") == 0) {
+        if (read_int_arg(optarg, tt_devices, 1,
+            "Parsing Error: Invalid number of TensTorrent devices") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "tt-tile-sort") == 0) {
+        tt_tile_sort = true;
+      }
+      if (strcmp(longargs[option_index].name, "tt-batch") == 0) {
+        tt_batch = true;
+      }
+      if (strcmp(longargs[option_index].name, "cuda-graph") == 0) {
+        cuda_graph = true;
+      }
+      if (strcmp(longargs[option_index].name, "cuda-streams") == 0) {
+        if (read_ul_arg(optarg, cuda_streams, 0,
+                "Parsing Error: Invalid number of CUDA streams") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "cuda-chunk") == 0) {
+        if (read_ul_arg(optarg, cuda_chunk, 0,
+                "Parsing Error: Invalid CUDA chunk") == -1)
+          return -1;
+      }
+      if (strcmp(longargs[option_index].name, "cuda-kernel") == 0) {
+        cuda_kernel = optarg;
+        std::transform(cuda_kernel.begin(), cuda_kernel.end(),
+            cuda_kernel.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if ((cuda_kernel.compare("naive") != 0) &&
+            (cuda_kernel.compare("vector2") != 0) &&
+            (cuda_kernel.compare("vector4") != 0) &&
+            (cuda_kernel.compare("shared") != 0)) {
+          std::cerr << "Valid CUDA kernels are: naive, vector2, vector4, "
+                    << "shared" << std::endl;
+          return -1;
+        }
+      }
+      if (strcmp(longargs[option_index].name, "tt-memory") == 0) {
+        tt_memory = optarg;
+        std::transform(tt_memory.begin(), tt_memory.end(), tt_memory.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+
+        if ((tt_memory.compare("l1") != 0) &&
+            (tt_memory.compare("dram") != 0) && (tt_memory.compare("auto") != 0)) {
+          std::cerr << "Valid TensTorrent memory placements are: l1, dram, auto"
+                    << std::endl;
+          return -1;
+        }
+      }
       break;
 
     case 'a':
@@ -425,7 +1268,8 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
 
     case 'g':
       pattern_gather_string << optarg;
-      if (pattern_parser(pattern_gather_string, pattern_gather, delta_gather) != 0)
+      if (pattern_parser(pattern_gather_string, pattern_gather, delta_gather,
+              pattern_gather_desc) != 0)
         return -1;
       break;
 
@@ -446,9 +1290,11 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
 
       if ((kernel.compare("gather") != 0) && (kernel.compare("scatter") != 0) &&
           (kernel.compare("gs") != 0) && (kernel.compare("multigather") != 0) &&
-          (kernel.compare("multiscatter") != 0)) {
+          (kernel.compare("multiscatter") != 0) &&
+          (kernel.compare("gather-reduce") != 0) &&
+          (kernel.compare("scatter-add") != 0)) {
         std::cerr << "Valid Kernels are: gather, scatter, gs, multigather, "
-                     "multiscatter"
+                     "multiscatter, gather-reduce, scatter-add"
                   << std::endl;
         return -1;
       }
@@ -475,8 +1321,35 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
       break;
 
     case 'p':
+      // TRACE:<file>[:window] streams its windows rather than parsing one
+      if (strncmp(optarg, "TRACE:", 6) == 0) {
+        std::string file = optarg + 6;
+        size_t window = 1024;
+        size_t colon = file.rfind(':');
+        if (colon != std::string::npos &&
+            file.find_first_not_of("0123456789", colon + 1) ==
+                std::string::npos &&
+            colon + 1 < file.size()) {
+          window = std::stoul(file.substr(colon + 1));
+          file.resize(colon);
+        }
+
+        std::string err;
+        cl.trace = std::make_unique<Spatter::TraceReader>();
+        if (!cl.trace->open(file, window, err)) {
+          std::cerr << "Parsing Error: " << err << std::endl;
+          return -1;
+        }
+        if (!cl.trace->next(pattern, delta)) {
+          std::cerr << "Parsing Error: Trace " << file << " is empty"
+                    << std::endl;
+          return -1;
+        }
+        break;
+      }
+
       pattern_string << optarg;
-      if (pattern_parser(pattern_string, pattern, delta) != 0)
+      if (pattern_parser(pattern_string, pattern, delta, pattern_desc) != 0)
         return -1;
       break;
 
@@ -507,7 +1380,8 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
 
     case 'u':
       pattern_scatter_string << optarg;
-      if (pattern_parser(pattern_scatter_string, pattern_scatter, delta_scatter) != 0)
+      if (pattern_parser(pattern_scatter_string, pattern_scatter, delta_scatter,
+              pattern_scatter_desc) != 0)
         return -1;
       break;
 
@@ -564,7 +1438,39 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
   cl.aggregate = aggregate;
   cl.compress = compress;
   cl.dense_buffers = dense_buffers;
+  cl.simd = simd;
+  cl.persistent = persistent;
+  cl.nt_stores = nt_stores;
+  cl.prefetch_distance = prefetch_distance;
+  cl.procedural = procedural;
+  cl.analyze = analyze;
+  cl.warmup = warmup;
+  cl.cold = cold;
+  cl.adaptive = adaptive;
+  cl.time_budget = time_budget;
+  cl.stream = stream;
+  cl.corun = corun;
+  cl.numa = numa;
+  cl.hugepages = hugepages;
+  cl.mpi_shared = mpi_shared;
+  cl.mpi_remote = mpi_remote;
+  cl.papi = papi;
+  cl.sweep = sweep;
+  cl.bw_model = bw_model;
+  cl.affinity = affinity;
+  cl.schedule = schedule;
   cl.tt_cores = tt_cores;
+  cl.tt_dtype = tt_dtype;
+  cl.tt_memory = tt_memory;
+  cl.tt_batch = tt_batch;
+  cl.tt_devices = tt_devices;
+  cl.tt_tile_sort = tt_tile_sort;
+  cl.cuda_graph = cuda_graph;
+  cl.cuda_kernel = cuda_kernel;
+  cl.atomic_mode = atomic_mode;
+  cl.accumulate = accumulate;
+  cl.cuda_streams = cuda_streams;
+  cl.cuda_chunk = cuda_chunk;
   cl.verbosity = verbosity;
 
 #ifdef USE_OPENMP
@@ -605,11 +1511,24 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
   }
 #endif
 
+  // Threads are pinned before anything is first touched
+  Spatter::set_loop_schedule(loop_schedule);
+  Spatter::set_accumulate(accumulate_mode);
+  Spatter::set_thread_affinity(affinity_cpus);
+
 #ifdef USE_OPENMP
 #pragma omp parallel for num_threads(nthreads)
 #endif
-  for(int i = 0; i < nthreads; i++)
-    seed_perthread = static_cast<unsigned int>(time(nullptr)) + i;
+  for(int i = 0; i < nthreads; i++) {
+#ifdef USE_OPENMP
+    Spatter::pin_thread(omp_get_thread_num());
+#else
+    Spatter::pin_thread(0);
+#endif
+  }
+
+  // Buffer contents follow -s, and a fixed seed without it
+  cl.buffer_seed = seed >= 0 ? static_cast<uint64_t>(seed) : 0;
 
   if (pattern_size > 0) {
     if (pattern.size() > 0) {
@@ -675,165 +1594,504 @@ int parse_input(const int argc, char **argv, ClArgs &cl) {
 
   // Adjust count for pattern reuse: -l specifies total elements, but count should be iterations
   // Total elements = pattern.size() * count, so count = total_elements / pattern.size()
+  const size_t total_elements = count;
   if (pattern.size() > 0) {
-    size_t total_elements = count;
     count = total_elements / pattern.size();
+    if (cl.trace)
+      count = std::max<size_t>(1, count);
     if (verbosity >= 2) {
       std::cout << "Adjusted count from " << total_elements << " to " << count 
                 << " iterations for pattern size " << pattern.size() << std::endl;
     }
   }
 
-  if (!json) {
-    std::unique_ptr<Spatter::ConfigurationBase> c;
+  // The configs only get the descriptors under --procedural
+  if (!procedural) {
+    pattern_desc = Spatter::PatternDescriptor();
+    pattern_gather_desc = Spatter::PatternDescriptor();
+    pattern_scatter_desc = Spatter::PatternDescriptor();
+  }
+
+  // What a config takes from the command line, and --sweep varies
+  struct ConfigParams {
+    std::string name;
+    std::string kernel;
+    size_t delta;
+    size_t count;
+    size_t wrap;
+    int threads;
+    int tt_cores;
+  };
+
+  // Builds the -p config, under TRACE one for each window of the trace and
+  // under --sweep one for each combination
+  auto make_config = [=, &cl](const size_t id,
+                         const aligned_vector<size_t> &pattern,
+                         const Spatter::PatternDescriptor &pattern_desc,
+                         const ConfigParams &p) mutable
+      -> std::unique_ptr<Spatter::ConfigurationBase> {
     if (backend.compare("serial") == 0)
-      c = std::make_unique<Spatter::Configuration<Spatter::Serial>>(0,
-          config_name, kernel, pattern, pattern_gather, pattern_scatter,
+      return std::make_unique<Spatter::Configuration<Spatter::Serial>>(id,
+          p.name, p.kernel, pattern, pattern_gather, pattern_scatter,
           cl.sparse, cl.dev_sparse, cl.sparse_size, cl.sparse_gather,
           cl.dev_sparse_gather, cl.sparse_gather_size, cl.sparse_scatter,
           cl.dev_sparse_scatter, cl.sparse_scatter_size, cl.dense,
-          cl.dense_perthread, cl.dev_dense, cl.dense_size, delta, delta_gather,
-          delta_scatter, seed, wrap, count, nruns, aggregate, verbosity);
+          cl.dense_perthread, cl.dev_dense, cl.dense_size, p.delta, delta_gather,
+          delta_scatter, seed, p.wrap, p.count, nruns, aggregate, verbosity,
+          prefetch_distance, pattern_desc, pattern_gather_desc,
+          pattern_scatter_desc);
 #ifdef USE_OPENMP
     else if (backend.compare("openmp") == 0)
-      c = std::make_unique<Spatter::Configuration<Spatter::OpenMP>>(0,
-          config_name, kernel, pattern, pattern_gather, pattern_scatter,
+      return std::make_unique<Spatter::Configuration<Spatter::OpenMP>>(id,
+          p.name, p.kernel, pattern, pattern_gather, pattern_scatter,
           cl.sparse, cl.dev_sparse, cl.sparse_size, cl.sparse_gather,
           cl.dev_sparse_gather, cl.sparse_gather_size, cl.sparse_scatter,
           cl.dev_sparse_scatter, cl.sparse_scatter_size, cl.dense,
-          cl.dense_perthread, cl.dev_dense, cl.dense_size, delta, delta_gather,
-          delta_scatter, seed, wrap, count, nthreads, nruns, aggregate, atomic,
-          atomic_fence, dense_buffers, verbosity);
+          cl.dense_perthread, cl.dev_dense, cl.dense_size, p.delta, delta_gather,
+          delta_scatter, seed, p.wrap, p.count, p.threads, nruns, aggregate, atomic,
+          atomic_fence, dense_buffers, verbosity, simd, persistent,
+          nt_stores, prefetch_distance, pattern_desc, pattern_gather_desc,
+          pattern_scatter_desc);
 #endif
 #ifdef USE_CUDA
     else if (backend.compare("cuda") == 0)
-      c = std::make_unique<Spatter::Configuration<Spatter::CUDA>>(0,
-          config_name, kernel, pattern, pattern_gather, pattern_scatter,
+      return std::make_unique<Spatter::Configuration<Spatter::CUDA>>(id,
+          p.name, p.kernel, pattern, pattern_gather, pattern_scatter,
           cl.sparse, cl.dev_sparse, cl.sparse_size, cl.sparse_gather,
           cl.dev_sparse_gather, cl.sparse_gather_size, cl.sparse_scatter,
           cl.dev_sparse_scatter, cl.sparse_scatter_size, cl.dense,
-          cl.dense_perthread, cl.dev_dense, cl.dense_size, delta, delta_gather,
-          delta_scatter, seed, wrap, count, shared_mem, local_work_size, nruns,
-          aggregate, atomic, verbosity);
+          cl.dense_perthread, cl.dev_dense, cl.dense_size, p.delta, delta_gather,
+          delta_scatter, seed, p.wrap, p.count, shared_mem, local_work_size, nruns,
+          aggregate, atomic, verbosity, cuda_graph, cuda_kernel, atomic_mode,
+          cuda_streams, cuda_chunk, pattern_desc, pattern_gather_desc,
+          pattern_scatter_desc);
 #endif
 #ifdef USE_TENSTORRENT
     else if (backend.compare("tenstorrent") == 0)
-      c = std::make_unique<Spatter::Configuration<Spatter::TensTorrent>>(0,
-          config_name, kernel, pattern, pattern_gather, pattern_scatter,
+      return std::make_unique<Spatter::Configuration<Spatter::TensTorrent>>(id,
+          p.name, p.kernel, pattern, pattern_gather, pattern_scatter,
           cl.sparse, cl.dev_sparse, cl.sparse_size, cl.sparse_gather,
           cl.dev_sparse_gather, cl.sparse_gather_size, cl.sparse_scatter,
           cl.dev_sparse_scatter, cl.sparse_scatter_size, cl.dense,
-          cl.dense_perthread, cl.dev_dense, cl.dense_size, delta, delta_gather,
-          delta_scatter, seed, wrap, count, nruns, aggregate, verbosity, cl.tt_cores);
+          cl.dense_perthread, cl.dev_dense, cl.dense_size, p.delta, delta_gather,
+          delta_scatter, seed, p.wrap, p.count, nruns, aggregate, verbosity, p.tt_cores,
+          cl.tt_dtype, cl.tt_memory, cl.tt_batch, cl.tt_devices,
+          cl.tt_tile_sort, pattern_desc, pattern_gather_desc,
+          pattern_scatter_desc);
 #endif
     else {
       std::cerr << "Invalid Backend " << backend << std::endl;
+      return nullptr;
+    }
+  };
+
+  std::vector<ConfigParams> params = {
+      {config_name, kernel, delta, count, wrap, nthreads, tt_cores}};
+
+  // --sweep replaces the -p config with a config per combination of its
+  // axes, in one process rather than one run of spatter each
+  if (!sweep.empty()) {
+    if (json || cl.trace) {
+      std::cerr << "Parsing Error: --sweep varies the -p config, not -f "
+                   "suites or TRACE patterns"
+                << std::endl;
       return -1;
     }
 
-    cl.configs.push_back(std::move(c));
+    for (const Spatter::SweepAxis &axis : sweep)
+      if ((axis.name.compare("threads") == 0 &&
+              backend.compare("openmp") != 0) ||
+          (axis.name.compare("tt-cores") == 0 &&
+              backend.compare("tenstorrent") != 0)) {
+        std::cerr << "Parsing Error: --sweep " << axis.name
+                  << " does not apply to the " << backend << " backend"
+                  << std::endl;
+        return -1;
+      }
+
+    const ConfigParams base = params[0];
+    params.clear();
+    for (size_t i = 0; i < Spatter::sweep_size(sweep); ++i) {
+      ConfigParams p = base;
+      p.name = Spatter::sweep_name(sweep, i);
+
+      const std::vector<std::string> point = Spatter::sweep_point(sweep, i);
+      for (size_t a = 0; a < sweep.size(); ++a) {
+        const std::string &axis = sweep[a].name;
+        if (axis.compare("kernel") == 0) {
+          p.kernel = point[a];
+          std::transform(p.kernel.begin(), p.kernel.end(), p.kernel.begin(),
+              [](unsigned char c) { return std::tolower(c); });
+          continue;
+        }
+
+        const size_t value = std::stoul(point[a]);
+        if (axis.compare("threads") == 0)
+          p.threads = static_cast<int>(value);
+        else if (axis.compare("tt-cores") == 0)
+          p.tt_cores = static_cast<int>(value);
+        else if (axis.compare("delta") == 0)
+          p.delta = value;
+        else if (axis.compare("wrap") == 0)
+          p.wrap = value;
+        else // count is in elements, as -l
+          p.count = pattern.size() > 0
+              ? std::max<size_t>(1, value / pattern.size())
+              : value;
+      }
+
+      if (p.kernel.compare("gather") != 0 && p.kernel.compare("scatter") != 0 &&
+          p.kernel.compare("gs") != 0 && p.kernel.compare("multigather") != 0 &&
+          p.kernel.compare("multiscatter") != 0 &&
+          p.kernel.compare("gather-reduce") != 0 &&
+          p.kernel.compare("scatter-add") != 0) {
+        std::cerr << "Parsing Error: Invalid Kernel Type " << p.kernel
+                  << std::endl;
+        return -1;
+      }
+      if (p.threads < 1 || p.wrap < 1) {
+        std::cerr << "Parsing Error: --sweep needs threads and wrap of at "
+                     "least 1"
+                  << std::endl;
+        return -1;
+      }
+#ifdef USE_OPENMP
+      // Swept threads are held to the same limit as -t
+      if (p.threads > max_threads) {
+        std::cerr << "Parsing Warning: Too many OpenMP threads requested by "
+                     "--sweep "
+                  << p.name << ". Using OMP_MAX_THREADS instead" << std::endl;
+        p.threads = max_threads;
+      }
+#endif
+      params.push_back(p);
+    }
+
+    // Every thread of the widest config has its own dense buffer
+    for (const ConfigParams &p : params)
+      nthreads = std::max(nthreads, p.threads);
+  }
+
+  // Every config is planned before any buffer is allocated, so each shared
+  // buffer is sized, placed and filled once for the whole suite
+  std::shared_ptr<Spatter::JSONParser> json_file;
+  if (!json) {
+    for (const ConfigParams &p : params)
+      cl.plan.add(p.kernel, pattern, pattern_gather, pattern_scatter, p.delta,
+          delta_gather, delta_scatter, p.count, p.wrap);
   } else {
     try {
-      Spatter::JSONParser json_file = Spatter::JSONParser(json_fname, cl.sparse,
+      json_file = std::make_shared<Spatter::JSONParser>(json_fname, cl.sparse,
           cl.dev_sparse, cl.sparse_size, cl.sparse_gather, cl.dev_sparse_gather,
           cl.sparse_gather_size, cl.sparse_scatter, cl.dev_sparse_scatter,
           cl.sparse_scatter_size, cl.dense, cl.dense_perthread, cl.dev_dense,
           cl.dense_size, backend, aggregate, atomic, atomic_fence, compress,
-          dense_buffers, shared_mem, nthreads, verbosity);
-
-      for (size_t i = 0; i < json_file.size(); ++i) {
-        std::unique_ptr<Spatter::ConfigurationBase> c = json_file[i];
-        cl.configs.push_back(std::move(c));
-      }
+          dense_buffers, shared_mem, nthreads, tt_cores, tt_dtype,
+          tt_memory, tt_batch, tt_devices, tt_tile_sort, cuda_graph,
+          cuda_kernel, atomic_mode, cuda_streams, cuda_chunk, simd,
+          persistent, nt_stores, prefetch_distance, procedural, verbosity);
+      cl.plan = json_file->plan();
     } catch (const std::invalid_argument &ia) {
       std::cerr << "Parsing Error: " << ia.what() << std::endl;
       return -1;
     }
   }
 
-  if (cl.sparse.size() < cl.sparse_size) {
-    cl.sparse.resize(cl.sparse_size);
+  cl.sparse_size = cl.plan.sparse_size;
+  cl.sparse_gather_size = cl.plan.sparse_gather_size;
+  cl.sparse_scatter_size = cl.plan.sparse_scatter_size;
+  cl.dense_size = cl.plan.dense_size;
 
-#ifdef USE_OPENMP
-#pragma omp parallel for num_threads(nthreads)
-#endif
-    for (size_t i = 0; i < cl.sparse.size(); ++i)
-      cl.sparse[i] = rand_r(&seed_perthread);
+  // Buffers allocated from here on take the huge page mode
+  Spatter::HugePageMode huge_mode = Spatter::HugePageMode::Off;
+  Spatter::hugepage_mode(hugepages, huge_mode);
+  Spatter::set_hugepage_mode(huge_mode);
+
+  Spatter::NumaMode placement = Spatter::NumaMode::Off;
+  Spatter::numa_mode(numa, placement);
+
+  Spatter::SharedMode shared_buffers = Spatter::SharedMode::Off;
+  Spatter::shared_mode(mpi_shared, shared_buffers);
+  if (shared_buffers != Spatter::SharedMode::Off &&
+      placement != Spatter::NumaMode::Off) {
+    std::cerr << "Parsing Error: --mpi-shared does not support --numa"
+              << std::endl;
+    return -1;
   }
 
-  if (cl.sparse_gather.size() < cl.sparse_gather_size) {
-    cl.sparse_gather.resize(cl.sparse_gather_size);
+  // --mpi-remote distributes sparse itself, for the serial kernels
+  if (mpi_remote &&
+      (backend.compare("serial") != 0 ||
+          shared_buffers != Spatter::SharedMode::Off ||
+          placement != Spatter::NumaMode::Off)) {
+    std::cerr << "Parsing Error: --mpi-remote requires the serial backend "
+                 "and does not support --mpi-shared or --numa"
+              << std::endl;
+    return -1;
+  }
+  // Batched runs time all of a config's runs at once
+  if ((adaptive > 0.0 || cold) && (persistent || tt_batch || cuda_graph)) {
+    std::cerr << "Parsing Error: " << (cold ? "--cold" : "--adaptive")
+              << " does not support --persistent, --tt-batch or --cuda-graph"
+              << std::endl;
+    return -1;
+  }
+  if (time_budget > 0.0 && adaptive == 0.0) {
+    std::cerr << "Parsing Error: --time-budget requires --adaptive"
+              << std::endl;
+    return -1;
+  }
 
-#ifdef USE_OPENMP
-#pragma omp parallel for num_threads(nthreads)
-#endif
-    for (size_t i = 0; i < cl.sparse_gather.size(); ++i)
-      cl.sparse_gather[i] = rand_r(&seed_perthread);
+  // CUDA kernels are timed by device events, which host counters miss
+  if (!papi.empty() && backend.compare("cuda") == 0) {
+    std::cerr << "Parsing Error: --papi does not support the cuda backend"
+              << std::endl;
+    return -1;
   }
 
-  if (cl.sparse_scatter.size() < cl.sparse_scatter_size) {
-    cl.sparse_scatter.resize(cl.sparse_scatter_size);
+  // The TensTorrent kernels only move elements, they have nothing to add
+  // with. The plan holds the kernels of -k, --sweep and -f configs alike.
+  for (const std::string &k : cl.plan.kernels) {
+    if (backend.compare("tenstorrent") == 0 &&
+        (k.compare("gather-reduce") == 0 || k.compare("scatter-add") == 0)) {
+      std::cerr << "Parsing Error: the tenstorrent backend does not support "
+                   "the "
+                << k << " kernel" << std::endl;
+      return -1;
+    }
+  }
 
-#ifdef USE_OPENMP
-#pragma omp parallel for num_threads(nthreads)
+  // Co-running configs each drive their own team from a thread of their own
+  if (corun > 0) {
+#ifdef USE_MPI
+    std::cerr << "Parsing Error: --corun is not supported with MPI"
+              << std::endl;
+    return -1;
 #endif
-    for (size_t i = 0; i < cl.sparse_scatter.size(); ++i)
-      cl.sparse_scatter[i] = rand_r(&seed_perthread);
+    if (backend.compare("openmp") != 0) {
+      std::cerr << "Parsing Error: --corun requires the openmp backend"
+                << std::endl;
+      return -1;
+    }
+    if (persistent || !papi.empty() || cl.trace) {
+      std::cerr << "Parsing Error: --corun does not support --persistent, "
+                   "--papi or TRACE patterns"
+                << std::endl;
+      return -1;
+    }
   }
 
-#ifdef USE_OPENMP
-  if ((backend.compare("openmp") == 0) && dense_buffers) {
-    cl.dense_perthread.resize(nthreads);
+  if (placement != Spatter::NumaMode::Off) {
+    numa_fill_buffers(cl, cl.plan, placement, nthreads,
+        (backend.compare("openmp") == 0) && dense_buffers);
+    if (verbosity >= 2)
+      numa_report(cl, nthreads);
+  }
 
-    for (int j = 0; j < nthreads; ++j) {
-      cl.dense_perthread[j].resize(cl.dense_size);
+#ifdef USE_CUDA
+  // Streamed sparse arrays are pinned in place once, so they cannot grow
+  if (cl.trace && backend.compare("cuda") == 0 && cuda_streams > 0) {
+    std::cerr << "Parsing Error: TRACE patterns do not support --cuda-streams"
+              << std::endl;
+    return -1;
+  }
+#endif
 
-#pragma omp parallel for num_threads(nthreads)
-      for (size_t i = 0; i < cl.dense_perthread[j].size(); ++i)
-        cl.dense_perthread[j][i] = rand_r(&seed_perthread);
-    }
-  } else {
-      if (cl.dense.size() < cl.dense_size) {
-        cl.dense.resize(cl.dense_size);
+  // Sizes and fills the buffers to the plan, and again for each TRACE window
+  // that outgrows them
+  auto prepare_buffers = [=, &cl]() {
+#ifdef USE_CUDA
+    // The device fills its own copies, so the host buffers are only sized
+    const bool host_fill = backend.compare("cuda") != 0 || cuda_streams > 0;
+    // The device copies are as large as the host buffers before this call
+    const size_t sparse_before = cl.sparse.size();
+    const size_t sparse_gather_before = cl.sparse_gather.size();
+    const size_t sparse_scatter_before = cl.sparse_scatter.size();
+    const size_t dense_before = cl.dense.size();
+#else
+    const bool host_fill = true;
+#endif
+    auto grow = [&](aligned_vector<double> &buf, const size_t size,
+                    const uint64_t stream) {
+      if (buf.size() >= size)
+        return;
+      buf.resize(size);
+      if (host_fill)
+        fill_buffer(buf.data(), buf.size(),
+            stream_seed(cl.buffer_seed, stream), nthreads);
+    };
+
+    // --mpi-shared windows are replaced rather than grown. Node rank r's
+    // buffer starts r deltas, rounded up to cache lines, into the window,
+    // and the node's first rank fills all of it.
+    auto grow_shared = [&](aligned_vector<double> &buf, const size_t size,
+                           const size_t stride, const uint64_t stream) {
+      if (buf.size() >= size)
+        return;
+      aligned_vector<double>().swap(buf);
+      Spatter::arm_shared_window(
+          (stride * sizeof(double) + ALIGN - 1) / ALIGN * ALIGN);
+      buf.resize(size);
+      if (host_fill && Spatter::node_rank() == 0)
+        fill_buffer(buf.data(),
+            Spatter::shared_window_span(buf.data()) / sizeof(double),
+            stream_seed(cl.buffer_seed, stream), nthreads);
+      Spatter::shared_window_fence();
+    };
+
+    if (mpi_remote)
+      Spatter::distribute_sparse(
+          cl.sparse_size, stream_seed(cl.buffer_seed, Spatter::Sparse));
+    else if (shared_buffers != Spatter::SharedMode::Off)
+      grow_shared(
+          cl.sparse, cl.sparse_size, cl.plan.sparse.stride, Spatter::Sparse);
+    else
+      grow(cl.sparse, cl.sparse_size, Spatter::Sparse);
+    if (shared_buffers == Spatter::SharedMode::All)
+      grow_shared(cl.sparse_gather, cl.sparse_gather_size,
+          cl.plan.sparse_gather.stride, Spatter::SparseGather);
+    else
+      grow(cl.sparse_gather, cl.sparse_gather_size, Spatter::SparseGather);
+    grow(cl.sparse_scatter, cl.sparse_scatter_size, Spatter::SparseScatter);
 
-#pragma omp parallel for num_threads(nthreads)
-      for (size_t i = 0; i < cl.dense.size(); ++i)
-        cl.dense[i] = rand_r(&seed_perthread);
+#ifdef USE_OPENMP
+    if ((backend.compare("openmp") == 0) && dense_buffers) {
+      cl.dense_perthread.resize(nthreads);
+
+      for (int j = 0; j < nthreads; ++j)
+        grow(cl.dense_perthread[j], cl.dense_size,
+            Spatter::DensePerThread + static_cast<uint64_t>(j));
+    } else {
+      grow(cl.dense, cl.dense_size, Spatter::Dense);
     }
-  }
 #else
-  if (cl.dense.size() < cl.dense_size) {
-    cl.dense.resize(cl.dense_size);
-
-    for (size_t i = 0; i < cl.dense.size(); ++i)
-      cl.dense[i] = rand_r(&seed_perthread);
-  }
+    grow(cl.dense, cl.dense_size, Spatter::Dense);
 #endif
 #ifdef USE_CUDA
-  if (backend.compare("cuda") == 0) {
-    checkCudaErrors(cudaMalloc((void **)&cl.dev_sparse,
-        sizeof(double) * cl.sparse.size()));
-    checkCudaErrors(cudaMalloc((void **)&cl.dev_sparse_gather,
-        sizeof(double) * cl.sparse_gather.size()));
-    checkCudaErrors(cudaMalloc((void **)&cl.dev_sparse_scatter,
-        sizeof(double) * cl.sparse_scatter.size()));
-    checkCudaErrors(cudaMalloc((void **)&cl.dev_dense,
-        sizeof(double) * cl.dense.size()));
-
-    checkCudaErrors(cudaMemcpy(cl.dev_sparse, cl.sparse.data(),
-        sizeof(double) * cl.sparse.size(), cudaMemcpyHostToDevice));
-    checkCudaErrors(cudaMemcpy(cl.dev_sparse_gather, cl.sparse_gather.data(),
-        sizeof(double) * cl.sparse_gather.size(), cudaMemcpyHostToDevice));
-    checkCudaErrors(cudaMemcpy(cl.dev_sparse_scatter, cl.sparse_scatter.data(),
-        sizeof(double) * cl.sparse_scatter.size(), cudaMemcpyHostToDevice));
-    checkCudaErrors(cudaMemcpy(cl.dev_dense, cl.dense.data(),
-        sizeof(double) * cl.dense.size(), cudaMemcpyHostToDevice));
-
-    checkCudaErrors(cudaDeviceSynchronize());
-  }
+    if (backend.compare("cuda") == 0 && cuda_streams > 0) {
+      // Streamed sparse arrays stay on the host, pinned in place so the chunk
+      // copies are asynchronous
+      for (aligned_vector<double> *host :
+          {&cl.sparse, &cl.sparse_gather, &cl.sparse_scatter})
+        if (!host->empty())
+          checkCudaErrors(cudaHostRegister(host->data(),
+              sizeof(double) * host->size(), cudaHostRegisterDefault));
+    }
+
+    // Like grow, a device copy is only replaced when its buffer grew, so the
+    // configs built on it (and their CUDA Graphs) keep a live pointer
+    auto grow_device = [](double *&dev, const size_t before,
+                           const size_t size) {
+      if (size <= before && (dev != nullptr || size == 0))
+        return false;
+      checkCudaErrors(cudaFree(dev));
+      checkCudaErrors(cudaMalloc((void **)&dev, sizeof(double) * size));
+      return true;
+    };
+
+    if (backend.compare("cuda") == 0 && cuda_streams == 0) {
+      if (grow_device(cl.dev_sparse, sparse_before, cl.sparse.size()))
+        cuda_fill_random(cl.dev_sparse, cl.sparse.size(),
+            stream_seed(cl.buffer_seed, Spatter::Sparse));
+      if (grow_device(cl.dev_sparse_gather, sparse_gather_before,
+              cl.sparse_gather.size()))
+        cuda_fill_random(cl.dev_sparse_gather, cl.sparse_gather.size(),
+            stream_seed(cl.buffer_seed, Spatter::SparseGather));
+      if (grow_device(cl.dev_sparse_scatter, sparse_scatter_before,
+              cl.sparse_scatter.size()))
+        cuda_fill_random(cl.dev_sparse_scatter, cl.sparse_scatter.size(),
+            stream_seed(cl.buffer_seed, Spatter::SparseScatter));
+    }
+
+    if (backend.compare("cuda") == 0 &&
+        grow_device(cl.dev_dense, dense_before, cl.dense.size())) {
+      if (host_fill) {
+        checkCudaErrors(cudaMemcpy(cl.dev_dense, cl.dense.data(),
+            sizeof(double) * cl.dense.size(), cudaMemcpyHostToDevice));
+      } else {
+        cuda_fill_random(cl.dev_dense, cl.dense.size(),
+            stream_seed(cl.buffer_seed, Spatter::Dense));
+      }
+    }
+
+    if (backend.compare("cuda") == 0)
+      checkCudaErrors(cudaDeviceSynchronize());
 #endif
+  };
+  prepare_buffers();
+
+  if (!sweep.empty()) {
+    // Each combination is built when it is reached, into the buffers of the
+    // largest
+    cl.configs.defer(params.size(),
+        [make_config, pattern, pattern_desc, params](
+            const size_t i) mutable {
+          return make_config(i, pattern, pattern_desc, params[i]);
+        });
+  } else if (!json) {
+    std::unique_ptr<Spatter::ConfigurationBase> c =
+        make_config(0, pattern, pattern_desc, params[0]);
+    if (!c)
+      return -1;
+
+    cl.configs.push_back(std::move(c));
+  } else {
+    // The suite's configs are built as they are reached, from the patterns
+    // the plan generated
+    cl.configs.defer(json_file->size(),
+        [json_file](const size_t i) { return (*json_file)[i]; });
+  }
+
+  // -p TRACE: the configs after the first window are built one at a time as
+  // the trace is read
+  if (cl.trace) {
+    cl.next_trace_config = [=, &cl]() mutable -> int {
+      aligned_vector<size_t> window;
+      size_t window_delta = 0;
+      if (!cl.trace->next(window, window_delta))
+        return 0;
+
+      if (remap_pattern(window, boundary, 1) > boundary) {
+        std::cerr << "Re-mapping pattern to have maximum value of " << boundary
+                  << "failed" << std::endl;
+        return -1;
+      }
+      if (compress)
+        compress_pattern(window);
+
+      // The previous window's config is released before the next is set up
+      cl.configs.clear();
+      ConfigParams p = params[0];
+      p.delta = window_delta;
+      p.count = std::max<size_t>(1, total_elements / window.size());
+
+      // The buffers grow for the window before its config is built on them
+      Spatter::BufferPlan window_plan;
+      window_plan.add(p.kernel, window, pattern_gather, pattern_scatter,
+          p.delta, delta_gather, delta_scatter, p.count, p.wrap);
+      cl.sparse_size = std::max(cl.sparse_size, window_plan.sparse_size);
+      cl.sparse_gather_size =
+          std::max(cl.sparse_gather_size, window_plan.sparse_gather_size);
+      cl.sparse_scatter_size =
+          std::max(cl.sparse_scatter_size, window_plan.sparse_scatter_size);
+      cl.dense_size = std::max(cl.dense_size, window_plan.dense_size);
+      prepare_buffers();
+
+      std::unique_ptr<Spatter::ConfigurationBase> c = make_config(
+          cl.trace->windows() - 1, window, Spatter::PatternDescriptor(), p);
+      if (!c)
+        return -1;
+      cl.configs.push_back(std::move(c));
+      return 1;
+    };
+  }
+
+  for (size_t i = 0; i < cl.configs.size(); ++i) {
+    // Deferred configs take these flags from the command line
+    if (!cl.configs.built(i))
+      continue;
 
-  for (auto const &config : cl.configs) {
+    const std::unique_ptr<Spatter::ConfigurationBase> &config = cl.configs[i];
     if (config->aggregate != aggregate) {
       std::cerr << "Aggregate flag of Config does not match the aggregate flag "
                    "passed to the command line"
@@ -2,6 +2,8 @@
   \file JSONParser.cc
 */
 
+#include <limits>
+
 #include <nlohmann/json.hpp>
 
 #include "JSONParser.hh"
@@ -20,6 +22,13 @@ JSONParser::JSONParser(std::string filename, aligned_vector<double> &sparse,
     size_t &dense_size, const std::string backend, const bool aggregate,
     const bool atomic, const bool atomic_fence, const bool compress,
     const bool dense_buffers, size_t shared_mem, const int nthreads,
+    const int tt_cores, const std::string tt_dtype,
+    const std::string tt_memory, const bool tt_batch, const int tt_devices,
+    const bool tt_tile_sort, const bool cuda_graph,
+    const std::string cuda_kernel, const std::string atomic_mode,
+    const size_t cuda_streams, const size_t cuda_chunk,
+    const std::string simd, const bool persistent, const bool nt_stores,
+    const long int prefetch_distance, const bool procedural,
     const unsigned long verbosity, const std::string name,
     const std::string kernel, const size_t pattern_size, const size_t delta,
     const size_t delta_gather, const size_t delta_scatter,
@@ -34,7 +43,14 @@ JSONParser::JSONParser(std::string filename, aligned_vector<double> &sparse,
       dense_size(dense_size), backend_(backend), aggregate_(aggregate),
       atomic_(atomic), atomic_fence_(atomic_fence), compress_(compress),
       dense_buffers_(dense_buffers), shared_mem_(shared_mem),
-      omp_threads_(nthreads), verbosity_(verbosity),
+      omp_threads_(nthreads), tt_cores_(tt_cores), tt_dtype_(tt_dtype),
+      tt_memory_(tt_memory), tt_batch_(tt_batch),
+      tt_devices_(tt_devices), tt_tile_sort_(tt_tile_sort),
+      cuda_graph_(cuda_graph), cuda_kernel_(cuda_kernel),
+      atomic_mode_(atomic_mode), cuda_streams_(cuda_streams),
+      cuda_chunk_(cuda_chunk), simd_(simd), persistent_(persistent),
+      nt_stores_(nt_stores), prefetch_distance_(prefetch_distance),
+      procedural_(procedural), verbosity_(verbosity),
       default_name_(name), default_kernel_(kernel),
       default_pattern_size_(pattern_size), default_delta_(delta),
       default_delta_gather_(delta_gather),
@@ -71,7 +87,9 @@ JSONParser::JSONParser(std::string filename, aligned_vector<double> &sparse,
 
       if ((kernel.compare("gather") != 0) && (kernel.compare("scatter") != 0) &&
           (kernel.compare("gs") != 0) && (kernel.compare("multigather") != 0) &&
-          (kernel.compare("multiscatter") != 0)) {
+          (kernel.compare("multiscatter") != 0) &&
+          (kernel.compare("gather-reduce") != 0) &&
+          (kernel.compare("scatter-add") != 0)) {
         throw std::invalid_argument("Invalid Kernel Type");
       }
 
@@ -198,58 +216,17 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
   aligned_vector<size_t> pattern;
   aligned_vector<size_t> pattern_gather;
   aligned_vector<size_t> pattern_scatter;
-
-  size_t pattern_size = (*data_json_ptr)[index]["pattern-size"];
-  size_t delta = (*data_json_ptr)[index]["delta"];
-  size_t delta_gather = (*data_json_ptr)[index]["delta-gather"];
-  size_t delta_scatter = (*data_json_ptr)[index]["delta-scatter"];
-  size_t boundary = (*data_json_ptr)[index]["boundary"];
-
-  if ((*data_json_ptr)[index].contains("pattern")) {
-    if (get_pattern_("pattern", pattern, delta, index) != 0)
-      exit(1);
-
-    if (pattern_size > 0)
-      if (truncate_pattern(pattern, pattern_size) != 0)
-        exit(1);
-
-    if (remap_pattern(pattern, boundary, this->size()) > boundary)
-       exit(1);
-
-    if (compress_)
-      compress_pattern(pattern);
-  }
-
-  if ((*data_json_ptr)[index].contains("pattern-gather")) {
-    if (get_pattern_("pattern-gather", pattern_gather, delta_gather,
-        index) != 0)
-      exit(1);
-
-    if (pattern_size > 0)
-      if (truncate_pattern(pattern_gather, pattern_size) != 0)
-        exit(1);
-
-    if (remap_pattern(pattern_gather, boundary, this->size()) > boundary)
-      exit(1);
-
-    if (compress_)
-      compress_pattern(pattern_gather);
-  }
-
-  if ((*data_json_ptr)[index].contains("pattern-scatter")) {
-    if (get_pattern_("pattern-scatter", pattern_scatter, delta_scatter,
-        index) != 0)
-      exit(1);
-
-    if (pattern_size > 0)
-      if (truncate_pattern(pattern_scatter, pattern_size) != 0)
-        exit(1);
-
-    if (remap_pattern(pattern_scatter, boundary, this->size()) > boundary)
-      exit(1);
-
-    if (compress_)
-      compress_pattern(pattern_scatter);
+  PatternDescriptor pattern_desc, pattern_gather_desc, pattern_scatter_desc;
+  size_t delta, delta_gather, delta_scatter;
+  get_patterns_(index, pattern, pattern_gather, pattern_scatter, pattern_desc,
+      pattern_gather_desc, pattern_scatter_desc, delta, delta_gather,
+      delta_scatter);
+
+  // The configs only get the descriptors under --procedural
+  if (!procedural_) {
+    pattern_desc = PatternDescriptor();
+    pattern_gather_desc = PatternDescriptor();
+    pattern_scatter_desc = PatternDescriptor();
   }
 
   std::unique_ptr<Spatter::ConfigurationBase> c;
@@ -262,7 +239,9 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
         dense_perthread, dev_dense, dense_size, delta, delta_gather,
         delta_scatter, (*data_json_ptr)[index]["seed"],
         (*data_json_ptr)[index]["wrap"], (*data_json_ptr)[index]["count"],
-        (*data_json_ptr)[index]["nruns"], aggregate_, verbosity_);
+        (*data_json_ptr)[index]["nruns"], aggregate_, verbosity_,
+        prefetch_distance_, pattern_desc, pattern_gather_desc,
+        pattern_scatter_desc);
 #ifdef USE_OPENMP
   else if (backend_.compare("openmp") == 0)
     c = std::make_unique<Spatter::Configuration<Spatter::OpenMP>>(index,
@@ -274,7 +253,9 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
         delta_scatter, (*data_json_ptr)[index]["seed"],
         (*data_json_ptr)[index]["wrap"], (*data_json_ptr)[index]["count"],
         omp_threads_, (*data_json_ptr)[index]["nruns"], aggregate_, atomic_,
-        atomic_fence_, dense_buffers_, verbosity_);
+        atomic_fence_, dense_buffers_, verbosity_, simd_, persistent_,
+        nt_stores_, prefetch_distance_, pattern_desc, pattern_gather_desc,
+        pattern_scatter_desc);
 #endif
 #ifdef USE_CUDA
   else if (backend_.compare("cuda") == 0)
@@ -287,7 +268,9 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
         delta_scatter, (*data_json_ptr)[index]["seed"],
         (*data_json_ptr)[index]["wrap"], (*data_json_ptr)[index]["count"],
         shared_mem_, (*data_json_ptr)[index]["local-work-size"],
-        (*data_json_ptr)[index]["nruns"], aggregate_, atomic_, verbosity_);
+        (*data_json_ptr)[index]["nruns"], aggregate_, atomic_, verbosity_,
+        cuda_graph_, cuda_kernel_, atomic_mode_, cuda_streams_, cuda_chunk_,
+        pattern_desc, pattern_gather_desc, pattern_scatter_desc);
 #endif
 #ifdef USE_TENSTORRENT
   else if (backend_.compare("tenstorrent") == 0)
@@ -299,7 +282,10 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
         dense_perthread, dev_dense, dense_size, delta, delta_gather,
         delta_scatter, (*data_json_ptr)[index]["seed"],
         (*data_json_ptr)[index]["wrap"], (*data_json_ptr)[index]["count"],
-        (*data_json_ptr)[index]["nruns"], aggregate_, verbosity_, 0);
+        (*data_json_ptr)[index]["nruns"], aggregate_, verbosity_, tt_cores_,
+        tt_dtype_, tt_memory_, tt_batch_, tt_devices_,
+        tt_tile_sort_, pattern_desc, pattern_gather_desc,
+        pattern_scatter_desc);
 #endif
   else {
     std::cerr << "Invalid Backend " << backend_ << std::endl;
@@ -309,12 +295,146 @@ std::unique_ptr<Spatter::ConfigurationBase> JSONParser::operator[](
   return c;
 }
 
-int JSONParser::get_pattern_(const std::string &pattern_key,
-    aligned_vector<size_t> &pattern, size_t &delta, const size_t index) {
+BufferPlan JSONParser::plan() {
   auto data_json_ptr = static_cast<json *>(data_.get());
-  if ((*data_json_ptr)[index][pattern_key].type() == json::value_t::string) {
-    std::string pattern_string =
-        (*data_json_ptr)[index][pattern_key].template get<std::string>();
+
+  generate_patterns_();
+
+  BufferPlan plan;
+  for (size_t index = 0; index < size_; ++index) {
+    aligned_vector<size_t> pattern;
+    aligned_vector<size_t> pattern_gather;
+    aligned_vector<size_t> pattern_scatter;
+    PatternDescriptor pattern_desc, pattern_gather_desc, pattern_scatter_desc;
+    size_t delta, delta_gather, delta_scatter;
+    get_patterns_(index, pattern, pattern_gather, pattern_scatter,
+        pattern_desc, pattern_gather_desc, pattern_scatter_desc, delta,
+        delta_gather, delta_scatter);
+
+    std::string kernel = (*data_json_ptr)[index]["kernel"];
+    std::transform(kernel.begin(), kernel.end(), kernel.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+    size_t count = (*data_json_ptr)[index]["count"];
+    size_t wrap = (*data_json_ptr)[index]["wrap"];
+
+    plan.add(kernel, pattern, pattern_gather, pattern_scatter, delta,
+        delta_gather, delta_scatter, count, wrap);
+  }
+
+  return plan;
+}
+
+void JSONParser::get_patterns_(const size_t index,
+    aligned_vector<size_t> &pattern, aligned_vector<size_t> &pattern_gather,
+    aligned_vector<size_t> &pattern_scatter, PatternDescriptor &pattern_desc,
+    PatternDescriptor &pattern_gather_desc,
+    PatternDescriptor &pattern_scatter_desc, size_t &delta,
+    size_t &delta_gather, size_t &delta_scatter) {
+  auto data_json_ptr = static_cast<json *>(data_.get());
+
+  delta = (*data_json_ptr)[index]["delta"];
+  delta_gather = (*data_json_ptr)[index]["delta-gather"];
+  delta_scatter = (*data_json_ptr)[index]["delta-scatter"];
+
+  auto assign = [&](const std::string &pattern_key,
+                    aligned_vector<size_t> &p, PatternDescriptor &descriptor,
+                    size_t &d) {
+    if (!(*data_json_ptr)[index].contains(pattern_key))
+      return;
+
+    const GeneratedPattern &generated = pattern_(index, pattern_key);
+    p = generated.pattern;
+    descriptor = generated.descriptor;
+    if (generated.sets_delta)
+      d = generated.delta;
+  };
+
+  assign("pattern", pattern, pattern_desc, delta);
+  assign("pattern-gather", pattern_gather, pattern_gather_desc, delta_gather);
+  assign(
+      "pattern-scatter", pattern_scatter, pattern_scatter_desc, delta_scatter);
+}
+
+size_t JSONParser::PatternKeyHash::operator()(const PatternKey &key) const {
+  size_t h = std::hash<json>()(*static_cast<const json *>(key.value));
+  h ^= key.pattern_size + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  h ^= key.boundary + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  return h;
+}
+
+bool JSONParser::PatternKeyEqual::operator()(
+    const PatternKey &a, const PatternKey &b) const {
+  return a.pattern_size == b.pattern_size && a.boundary == b.boundary &&
+      *static_cast<const json *>(a.value) == *static_cast<const json *>(b.value);
+}
+
+JSONParser::PatternKey JSONParser::pattern_key_(
+    const size_t index, const std::string &pattern_key) {
+  const json &config = (*static_cast<const json *>(data_.get()))[index];
+
+  return {&config[pattern_key], config["pattern-size"].get<size_t>(),
+      config["boundary"].get<size_t>()};
+}
+
+const JSONParser::GeneratedPattern &JSONParser::pattern_(
+    const size_t index, const std::string &pattern_key) {
+  const PatternKey key = pattern_key_(index, pattern_key);
+
+  auto found = patterns_.find(key);
+  if (found != patterns_.end())
+    return found->second;
+
+  GeneratedPattern &generated = patterns_[key];
+  if (generate_pattern_(index, pattern_key, generated) != 0)
+    exit(1);
+
+  return generated;
+}
+
+void JSONParser::generate_patterns_() {
+  const json &data = *static_cast<const json *>(data_.get());
+
+  // The first config using each distinct pattern generates it
+  struct Job {
+    size_t index;
+    std::string pattern_key;
+    GeneratedPattern *generated;
+  };
+  std::vector<Job> jobs;
+  for (size_t index = 0; index < size_; ++index)
+    for (const std::string pattern_key :
+        {"pattern", "pattern-gather", "pattern-scatter"}) {
+      if (!data[index].contains(pattern_key))
+        continue;
+
+      auto inserted =
+          patterns_.emplace(pattern_key_(index, pattern_key), GeneratedPattern());
+      if (inserted.second)
+        jobs.push_back({index, pattern_key, &inserted.first->second});
+    }
+
+  std::vector<int> failed(jobs.size(), 0);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (size_t j = 0; j < jobs.size(); ++j)
+    failed[j] =
+        generate_pattern_(jobs[j].index, jobs[j].pattern_key, *jobs[j].generated);
+
+  if (std::any_of(failed.begin(), failed.end(), [](int f) { return f != 0; }))
+    exit(1);
+}
+
+// Only reads the suite, so patterns can be generated concurrently
+int JSONParser::generate_pattern_(const size_t index,
+    const std::string &pattern_key, GeneratedPattern &generated) {
+  const json &config = (*static_cast<const json *>(data_.get()))[index];
+
+  size_t pattern_size = config["pattern-size"];
+  size_t boundary = config["boundary"];
+
+  if (config[pattern_key].type() == json::value_t::string) {
+    std::string pattern_string = config[pattern_key].get<std::string>();
     pattern_string.erase(
         std::remove(pattern_string.begin(), pattern_string.end(), '\"'),
         pattern_string.end());
@@ -322,11 +442,29 @@ int JSONParser::get_pattern_(const std::string &pattern_key,
     std::stringstream pattern_stream;
     pattern_stream << pattern_string;
 
-    return pattern_parser(pattern_stream, pattern, delta);
+    // Pattern strings that set a delta overwrite this
+    size_t delta = std::numeric_limits<size_t>::max();
+    if (pattern_parser(
+            pattern_stream, generated.pattern, delta, generated.descriptor) != 0)
+      return -1;
+
+    generated.sets_delta = delta != std::numeric_limits<size_t>::max();
+    generated.delta = delta;
   } else {
-    pattern = (*data_json_ptr)[index][pattern_key].template get<aligned_vector<size_t>>();
-    return 0;
+    generated.pattern = config[pattern_key].get<aligned_vector<size_t>>();
   }
+
+  if (pattern_size > 0)
+    if (truncate_pattern(generated.pattern, pattern_size) != 0)
+      return -1;
+
+  if (remap_pattern(generated.pattern, boundary, size_) > boundary)
+    return -1;
+
+  if (compress_)
+    compress_pattern(generated.pattern);
+
+  return 0;
 }
 
 bool JSONParser::file_exists_(const std::string &fpth) {
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -32,8 +33,14 @@ public:
       double *&dev_dense, size_t &dense_size, const std::string backend,
       const bool aggregate, const bool atomic, const bool atomic_fence,
       const bool compress, const bool dense_buffers, const size_t shared_mem,
-      const int nthreads, const unsigned long verbosity,
-      const std::string name = "", const std::string kernel = "gather",
+      const int nthreads, const int tt_cores, const std::string tt_dtype,
+      const std::string tt_memory, const bool tt_batch, const int tt_devices,
+      const bool tt_tile_sort, const bool cuda_graph,
+      const std::string cuda_kernel, const std::string atomic_mode,
+      const size_t cuda_streams, const size_t cuda_chunk,
+      const std::string simd, const bool persistent, const bool nt_stores,
+      const long int prefetch_distance, const bool procedural,
+      const unsigned long verbosity, const std::string name = "", const std::string kernel = "gather",
       const size_t pattern_size = 0, const size_t delta = 8,
       const size_t delta_gather = 8, const size_t delta_scatter = 8,
       const size_t boundary = 0, const long int seed = -1,
@@ -44,15 +51,63 @@ public:
 
   std::unique_ptr<Spatter::ConfigurationBase> operator[](const size_t index);
 
+  // Footprint of every config in the shared buffers, without building any
+  BufferPlan plan();
+
 private:
-  int get_pattern_(const std::string &pattern_key,
-      aligned_vector<size_t> &pattern, size_t &delta, const size_t index);
+  // Patterns, descriptors and deltas of config index, truncated, remapped
+  // and compressed
+  void get_patterns_(const size_t index, aligned_vector<size_t> &pattern,
+      aligned_vector<size_t> &pattern_gather,
+      aligned_vector<size_t> &pattern_scatter,
+      PatternDescriptor &pattern_desc, PatternDescriptor &pattern_gather_desc,
+      PatternDescriptor &pattern_scatter_desc, size_t &delta,
+      size_t &delta_gather, size_t &delta_scatter);
+
+  // A pattern as the configs get it: truncated, remapped and compressed
+  struct GeneratedPattern {
+    aligned_vector<size_t> pattern;
+    PatternDescriptor descriptor;
+    // Set if the pattern string overrides the delta of its config
+    bool sets_delta = false;
+    size_t delta = 0;
+  };
+
+  // A pattern of a config by its value in the suite, pattern size and
+  // boundary, which are all that its generation depends on
+  struct PatternKey {
+    const void *value; // nlohmann::json ptr
+    size_t pattern_size;
+    size_t boundary;
+  };
+  struct PatternKeyHash {
+    size_t operator()(const PatternKey &key) const;
+  };
+  struct PatternKeyEqual {
+    bool operator()(const PatternKey &a, const PatternKey &b) const;
+  };
+
+  PatternKey pattern_key_(const size_t index, const std::string &pattern_key);
+  // The pattern pattern_key of config index, generated the first time any
+  // config asks for it. Exits on invalid patterns.
+  const GeneratedPattern &pattern_(
+      const size_t index, const std::string &pattern_key);
+  // Generates every pattern of the suite, in parallel under OpenMP
+  void generate_patterns_();
+  int generate_pattern_(const size_t index, const std::string &pattern_key,
+      GeneratedPattern &generated);
   bool file_exists_(const std::string &fpth);
 
 private:
   std::unique_ptr<void, std::function<void(void *)>> data_; // nlohman::json ptr
   size_t size_;
 
+  // Generated patterns by their keys. Suites repeat patterns across configs
+  // that differ only in their deltas or counts.
+  std::unordered_map<PatternKey, GeneratedPattern, PatternKeyHash,
+      PatternKeyEqual>
+      patterns_;
+
   aligned_vector<double> &sparse;
   double *&dev_sparse;
   size_t &sparse_size;
@@ -78,6 +133,22 @@ private:
   const bool dense_buffers_;
   const size_t shared_mem_;
   const int omp_threads_;
+  const int tt_cores_;
+  const std::string tt_dtype_;
+  const std::string tt_memory_;
+  const bool tt_batch_;
+  const int tt_devices_;
+  const bool tt_tile_sort_;
+  const bool cuda_graph_;
+  const std::string cuda_kernel_;
+  const std::string atomic_mode_;
+  const size_t cuda_streams_;
+  const size_t cuda_chunk_;
+  const std::string simd_;
+  const bool persistent_;
+  const bool nt_stores_;
+  const long int prefetch_distance_;
+  const bool procedural_;
   const unsigned long verbosity_;
 
   std::string default_name_;
@@ -0,0 +1,180 @@
+/*!
+  \file Locality.cc
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Locality.hh"
+
+namespace Spatter {
+
+namespace {
+
+// Prefix sums over access times, marking the last access of every line
+class Fenwick {
+public:
+  explicit Fenwick(size_t n) : tree(n + 1, 0) {}
+
+  void add(size_t i, int v) {
+    for (++i; i < tree.size(); i += i & (~i + 1))
+      tree[i] += v;
+  }
+
+  // Sum of [0, i)
+  long sum(size_t i) const {
+    long s = 0;
+    for (; i > 0; i -= i & (~i + 1))
+      s += tree[i];
+    return s;
+  }
+
+private:
+  std::vector<int> tree;
+};
+
+size_t reuse_bucket(size_t distance) {
+  size_t k = 0;
+  while (distance) {
+    distance >>= 1;
+    ++k;
+  }
+  return k;
+}
+
+} // namespace
+
+PatternLocality analyze_locality(const std::string &name,
+    const size_t *pattern, size_t length, size_t delta, size_t count,
+    const LocalityModel &model) {
+  PatternLocality l;
+  l.name = name;
+  if (length == 0 || count == 0)
+    return l;
+
+  l.iterations =
+      std::min(count, std::max<size_t>(1, model.max_accesses / length));
+  const size_t accesses = l.iterations * length;
+
+  std::map<int64_t, size_t> strides;
+  for (size_t j = 1; j < length; ++j)
+    ++strides[static_cast<int64_t>(pattern[j] - pattern[j - 1])];
+  l.strides.assign(strides.begin(), strides.end());
+  std::stable_sort(l.strides.begin(), l.strides.end(),
+      [](const std::pair<int64_t, size_t> &a,
+          const std::pair<int64_t, size_t> &b) { return a.second > b.second; });
+  l.steps = length - 1;
+
+  Fenwick latest(accesses);
+  std::unordered_map<size_t, size_t> last_access;
+  std::unordered_set<size_t> pages;
+  std::vector<size_t> tile_slots(model.tile_slots, SIZE_MAX);
+  std::vector<size_t> iteration_lines(length), iteration_pages(length);
+  size_t lines_sum = 0, pages_sum = 0;
+
+  size_t t = 0;
+  for (size_t i = 0; i < l.iterations; ++i) {
+    for (size_t j = 0; j < length; ++j, ++t) {
+      const size_t index = pattern[j] + delta * i;
+      const size_t byte = index * model.element_size;
+      const size_t line = byte / model.line_bytes;
+      const size_t page = byte / model.page_bytes;
+      iteration_lines[j] = line;
+      iteration_pages[j] = page;
+      pages.insert(page);
+
+      auto last = last_access.find(line);
+      if (last == last_access.end()) {
+        ++l.cold;
+        last_access.emplace(line, t);
+      } else {
+        const size_t distance =
+            static_cast<size_t>(latest.sum(t) - latest.sum(last->second + 1));
+        const size_t bucket = reuse_bucket(distance);
+        if (l.reuse.size() <= bucket)
+          l.reuse.resize(bucket + 1, 0);
+        ++l.reuse[bucket];
+        latest.add(last->second, -1);
+        last->second = t;
+      }
+      latest.add(t, 1);
+
+      const size_t tile = index / model.tile_elements;
+      size_t &slot = tile_slots[tile % model.tile_slots];
+      if (slot == tile)
+        ++l.tile_hits;
+      slot = tile;
+    }
+
+    std::sort(iteration_lines.begin(), iteration_lines.end());
+    std::sort(iteration_pages.begin(), iteration_pages.end());
+    lines_sum += static_cast<size_t>(
+        std::unique(iteration_lines.begin(), iteration_lines.end()) -
+        iteration_lines.begin());
+    pages_sum += static_cast<size_t>(
+        std::unique(iteration_pages.begin(), iteration_pages.end()) -
+        iteration_pages.begin());
+  }
+
+  l.tile_accesses = accesses;
+  l.footprint_lines = last_access.size();
+  l.footprint_pages = pages.size();
+  l.lines_per_iteration =
+      static_cast<double>(lines_sum) / static_cast<double>(l.iterations);
+  l.pages_per_iteration =
+      static_cast<double>(pages_sum) / static_cast<double>(l.iterations);
+  return l;
+}
+
+std::ostream &operator<<(std::ostream &out, const PatternLocality &l) {
+  std::stringstream s;
+  s << std::setprecision(4);
+
+  s << "{'pattern': '" << l.name << "', 'iterations': " << l.iterations
+    << ", 'lines-per-iteration': " << l.lines_per_iteration
+    << ", 'pages-per-iteration': " << l.pages_per_iteration
+    << ", 'footprint-lines': " << l.footprint_lines
+    << ", 'footprint-pages': " << l.footprint_pages;
+
+  s << ", 'reuse-distance': {'cold': " << l.cold;
+  for (size_t k = 0; k < l.reuse.size(); ++k) {
+    if (!l.reuse[k])
+      continue;
+    if (k <= 1)
+      s << ", '" << k << "': ";
+    else
+      s << ", '" << (size_t(1) << (k - 1)) << "-" << ((size_t(1) << k) - 1)
+        << "': ";
+    s << l.reuse[k];
+  }
+  s << "}";
+
+  // The most frequent strides, as fractions of the steps
+  s << ", 'strides': {";
+  const size_t shown = std::min<size_t>(l.strides.size(), 4);
+  size_t other = l.steps;
+  for (size_t k = 0; k < shown; ++k) {
+    s << (k ? ", '" : "'") << l.strides[k].first << "': "
+      << static_cast<double>(l.strides[k].second) /
+            static_cast<double>(l.steps);
+    other -= l.strides[k].second;
+  }
+  if (other)
+    s << (shown ? ", " : "") << "'other': "
+      << static_cast<double>(other) / static_cast<double>(l.steps);
+  s << "}";
+
+  s << ", 'tt-tile-hit-rate': "
+    << (l.tile_accesses ? static_cast<double>(l.tile_hits) /
+                static_cast<double>(l.tile_accesses)
+                        : 0.0)
+    << "}";
+
+  return out << s.str();
+}
+
+} // namespace Spatter
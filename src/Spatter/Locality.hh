@@ -0,0 +1,70 @@
+/*!
+  \file Locality.hh
+*/
+
+#ifndef SPATTER_LOCALITY_HH
+#define SPATTER_LOCALITY_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Spatter {
+
+// Granularities the accesses are counted in
+struct LocalityModel {
+  size_t element_size = sizeof(double);
+  size_t line_bytes = 64;
+  size_t page_bytes = 4096;
+  // Sparse tiles of the TensTorrent kernels, held in a direct-mapped cache
+  // of tile_slots slots as in SparseTileCache (kernels/spatter_tile_cache.h)
+  size_t tile_elements = 32 * 32;
+  size_t tile_slots = 31;
+  // Iterations past this many accesses are not analyzed
+  size_t max_accesses = size_t(1) << 22;
+};
+
+// Locality of the indices a pattern touches over its iterations
+// (--analyze). Only the first iterations, up to max_accesses accesses,
+// are analyzed.
+struct PatternLocality {
+  std::string name; // the pattern, e.g. "pattern-gather"
+  size_t iterations = 0;
+
+  // Distinct cache lines and pages one iteration touches, on average
+  double lines_per_iteration = 0.0;
+  double pages_per_iteration = 0.0;
+
+  // Distinct lines and pages of all iterations analyzed
+  size_t footprint_lines = 0;
+  size_t footprint_pages = 0;
+
+  // Reuse distance of each line access: the distinct other lines touched
+  // since the line was last touched. reuse[0] counts distance 0, reuse[k]
+  // distances in [2^(k-1), 2^k). cold counts first touches.
+  size_t cold = 0;
+  std::vector<size_t> reuse;
+
+  // Element strides between consecutive indices of an iteration and how
+  // often each occurs, most frequent first
+  std::vector<std::pair<int64_t, size_t>> strides;
+  size_t steps = 0;
+
+  size_t tile_hits = 0;
+  size_t tile_accesses = 0;
+};
+
+// Analyzes the length indices of pattern, shifted by delta for each of count
+// iterations
+PatternLocality analyze_locality(const std::string &name,
+    const size_t *pattern, size_t length, size_t delta, size_t count,
+    const LocalityModel &model = LocalityModel());
+
+std::ostream &operator<<(std::ostream &out, const PatternLocality &locality);
+
+} // namespace Spatter
+
+#endif
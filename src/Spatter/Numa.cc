@@ -0,0 +1,120 @@
+/*!
+  \file Numa.cc
+*/
+
+#include "Numa.hh"
+
+#ifdef USE_NUMA
+#include <cstdint>
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Spatter {
+
+bool numa_mode(const std::string &name, NumaMode &mode) {
+  if (name.compare("off") == 0)
+    mode = NumaMode::Off;
+  else if (name.compare("touch") == 0)
+    mode = NumaMode::Touch;
+  else if (name.compare("interleave") == 0)
+    mode = NumaMode::Interleave;
+  else if (name.compare("bind") == 0)
+    mode = NumaMode::Bind;
+  else
+    return false;
+  return true;
+}
+
+bool numa_policies_available() {
+#ifdef USE_NUMA
+  return numa_available() != -1;
+#else
+  return false;
+#endif
+}
+
+int numa_nodes() {
+#ifdef USE_NUMA
+  if (numa_policies_available())
+    return numa_num_configured_nodes();
+#endif
+  return 1;
+}
+
+void numa_interleave(double *data, size_t n) {
+#ifdef USE_NUMA
+  if (!numa_policies_available() || n == 0)
+    return;
+
+  // mbind needs a page-aligned start; the aligned allocator only guarantees
+  // ALIGN bytes
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t first = start & ~(page_size - 1);
+  numa_interleave_memory(reinterpret_cast<void *>(first),
+      sizeof(double) * n + (start - first), numa_all_nodes_ptr);
+#else
+  (void)data;
+  (void)n;
+#endif
+}
+
+void numa_bind_thread(int t, int nthreads) {
+#ifdef USE_NUMA
+  if (!numa_policies_available())
+    return;
+  numa_run_on_node(static_cast<int>(
+      static_cast<long>(t) * numa_nodes() / (nthreads > 0 ? nthreads : 1)));
+  numa_set_localalloc();
+#else
+  (void)t;
+  (void)nthreads;
+#endif
+}
+
+int numa_thread_node() {
+#ifdef USE_NUMA
+  if (numa_policies_available()) {
+    int cpu = sched_getcpu();
+    if (cpu >= 0)
+      return numa_node_of_cpu(cpu);
+  }
+#endif
+  return -1;
+}
+
+std::vector<size_t> numa_page_nodes(const double *data, size_t n) {
+  std::vector<size_t> pages;
+#ifdef USE_NUMA
+  if (!numa_policies_available() || n == 0)
+    return pages;
+
+  // move_pages without target nodes only reports where each page lives
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+  const uintptr_t last = reinterpret_cast<uintptr_t>(data + n);
+
+  std::vector<void *> addresses;
+  for (uintptr_t page = first; page < last; page += page_size)
+    addresses.push_back(reinterpret_cast<void *>(page));
+
+  std::vector<int> status(addresses.size());
+  if (numa_move_pages(0, addresses.size(), addresses.data(), nullptr,
+          status.data(), 0) != 0)
+    return pages;
+
+  pages.resize(numa_nodes());
+  for (int node : status)
+    if (node >= 0 && static_cast<size_t>(node) < pages.size())
+      ++pages[node];
+#else
+  (void)data;
+  (void)n;
+#endif
+  return pages;
+}
+
+} // namespace Spatter
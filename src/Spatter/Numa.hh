@@ -0,0 +1,47 @@
+/*!
+  \file Numa.hh
+*/
+
+#ifndef SPATTER_NUMA_HH
+#define SPATTER_NUMA_HH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Spatter {
+
+// --numa placement of the sparse and dense buffers:
+//   Touch:      first touch along the kernels' iteration partition
+//   Interleave: pages round-robin over all nodes (needs libnuma)
+//   Bind:       first touch with each OpenMP thread bound to a node, so the
+//               pages stay local to the thread that uses them (needs libnuma)
+enum class NumaMode { Off, Touch, Interleave, Bind };
+
+// By --numa name: "off", "touch", "interleave" or "bind". false for others.
+bool numa_mode(const std::string &name, NumaMode &mode);
+
+// Whether this binary was built with libnuma and the system supports
+// NUMA policies
+bool numa_policies_available();
+
+// Nodes with memory, 1 without libnuma
+int numa_nodes();
+
+// Interleaves the pages of [data, data + n) over all nodes. Only pages not
+// yet touched are affected.
+void numa_interleave(double *data, size_t n);
+
+// Runs the calling thread on node (t * nodes / nthreads) and allocates its
+// memory there
+void numa_bind_thread(int t, int nthreads);
+
+// Node of the CPU the calling thread runs on, -1 if unknown
+int numa_thread_node();
+
+// Resident pages of [data, data + n) per node, empty if unknown
+std::vector<size_t> numa_page_nodes(const double *data, size_t n);
+
+} // namespace Spatter
+
+#endif
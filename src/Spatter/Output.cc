@@ -0,0 +1,232 @@
+/*!
+  \file Output.cc
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#ifdef USE_MPI
+#include "mpi.h"
+#endif
+
+#include "Output.hh"
+
+namespace Spatter {
+
+namespace {
+
+// A CSV field, quoted when it holds a separator or a quote
+std::string csv_field(const std::string &value) {
+  if (value.find_first_of(",\"\n ") == std::string::npos)
+    return value;
+
+  std::string quoted = "\"";
+  for (char c : value) {
+    if (c == '"')
+      quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+std::string csv_field(const nlohmann::json &value) {
+  if (value.is_string())
+    return csv_field(value.get<std::string>());
+  if (value.is_array()) {
+    // Patterns and run times as space-separated lists
+    std::stringstream list;
+    for (size_t i = 0; i < value.size(); ++i)
+      list << (i ? " " : "") << value[i].dump();
+    return csv_field(list.str());
+  }
+  if (value.is_null())
+    return "";
+  return value.dump();
+}
+
+} // namespace
+
+bool ResultOutput::open(const std::string &spec, std::string &error) {
+  const size_t colon = spec.find(':');
+  const std::string format = spec.substr(0, colon);
+  const std::string path =
+      (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+
+  if (format.compare("json") == 0)
+    format_ = Format::JSON;
+  else if (format.compare("csv") == 0)
+    format_ = Format::CSV;
+  if (format_ == Format::None || path.empty()) {
+    format_ = Format::None;
+    error = "--output takes json:<file> or csv:<file>";
+    return false;
+  }
+
+#ifdef USE_MPI
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank != 0)
+    return true;
+#endif
+
+  file_.open(path);
+  if (!file_) {
+    error = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+void ResultOutput::record(const ConfigurationBase &config) {
+  const std::vector<double> seconds = config.run_seconds();
+  const std::vector<long long> counters = config.counter_sums();
+
+  unsigned long long bytes = config.bytes_per_run();
+#ifdef USE_MPI
+  int rank = 0;
+  int ranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+  unsigned long long rank_bytes = bytes;
+  MPI_Reduce(&rank_bytes, &bytes, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0,
+      MPI_COMM_WORLD);
+  if (rank != 0)
+    return;
+#endif
+
+  nlohmann::json c;
+  c["id"] = config.id;
+  c["name"] = config.name;
+  c["kernel"] = config.kernel;
+  c["pattern"] = std::vector<size_t>(config.pattern.begin(), config.pattern.end());
+  c["pattern-gather"] = std::vector<size_t>(
+      config.pattern_gather.begin(), config.pattern_gather.end());
+  c["pattern-scatter"] = std::vector<size_t>(
+      config.pattern_scatter.begin(), config.pattern_scatter.end());
+  c["delta"] = config.delta;
+  c["delta-gather"] = config.delta_gather;
+  c["delta-scatter"] = config.delta_scatter;
+  c["count"] = config.count;
+  c["wrap"] = config.wrap;
+  c["seed"] = config.seed;
+  c["threads"] = config.omp_threads;
+#ifdef USE_MPI
+  c["ranks"] = ranks;
+#else
+  c["ranks"] = 1;
+#endif
+  c["aggregate"] = config.aggregate;
+  c["atomic"] = config.atomic;
+  c["index-width"] = config.index_width;
+  c["procedural"] = config.procedural;
+  c["prefetch-distance"] = config.prefetch_distance;
+
+  const Traffic traffic = config.traffic();
+  c["traffic"] = {{"payload", traffic.payload}, {"index", traffic.index},
+      {"read", traffic.reads}, {"write", traffic.writes}};
+
+  c["nruns"] = config.nruns;
+  c["runs"] = seconds.size();
+  c["bytes"] = bytes;
+  c["times"] = seconds;
+
+  const RunStatistics stats = run_statistics(seconds.data(), seconds.size());
+  c["min-time"] = stats.min;
+  c["median-time"] = stats.median;
+  c["mean-time"] = stats.mean;
+  c["stddev-time"] = stats.stddev;
+  c["ci95"] = stats.ci95;
+  c["bandwidth"] =
+      stats.min > 0.0 ? static_cast<double>(bytes) / stats.min / 1000000.0 : 0.0;
+  if (peak_bandwidth > 0.0)
+    c["peak-percent"] = 100.0 * c["bandwidth"].get<double>() / peak_bandwidth;
+
+  // Per timed run, as report_counters() prints them
+  nlohmann::json papi = nlohmann::json::object();
+  const std::vector<std::string> &events = counter_events();
+  for (size_t e = 0; e < events.size() && e < counters.size(); ++e)
+    papi[events[e]] = seconds.empty()
+        ? 0.0
+        : static_cast<double>(counters[e]) /
+            static_cast<double>(seconds.size());
+  c["papi"] = papi;
+
+  configs_.push_back(std::move(c));
+}
+
+void ResultOutput::record_corun(const ConfigurationBase &config,
+    const std::vector<size_t> &with, const double alone_seconds) {
+  auto c = std::find_if(configs_.rbegin(), configs_.rend(),
+      [&config](const nlohmann::json &r) { return r["id"] == config.id; });
+  if (c == configs_.rend())
+    return;
+
+  const double min_time =
+      *std::min_element(config.time_seconds.begin(), config.time_seconds.end());
+  (*c)["corun-with"] = with;
+  (*c)["corun-times"] = config.time_seconds;
+  (*c)["corun-min-time"] = min_time;
+  (*c)["corun-bandwidth"] =
+      static_cast<double>(config.bytes_per_run()) / min_time / 1000000.0;
+  (*c)["corun-slowdown"] = min_time / alone_seconds;
+}
+
+void ResultOutput::write() {
+  if (!file_.is_open())
+    return;
+
+  if (format_ == Format::JSON)
+    file_ << nlohmann::json{{"build", build}, {"configs", configs_}}.dump()
+          << std::endl;
+  else
+    write_csv();
+  file_.close();
+}
+
+// One row per config, the build information repeated on every row
+void ResultOutput::write_csv() {
+  std::vector<std::string> build_columns, columns;
+  for (auto it = build.begin(); it != build.end(); ++it)
+    if (!it.value().is_object())
+      build_columns.push_back(it.key());
+  if (!configs_.empty())
+    for (auto it = configs_[0].begin(); it != configs_[0].end(); ++it)
+      if (!it.value().is_object() || it.key().compare("traffic") == 0)
+        columns.push_back(it.key());
+  const std::vector<std::string> &events = counter_events();
+
+  std::vector<std::string> header(build_columns);
+  for (const std::string &column : columns)
+    if (column.compare("traffic") == 0)
+      for (const char *t : {"payload", "index", "read", "write"})
+        header.push_back(std::string("traffic-") + t);
+    else
+      header.push_back(column);
+  for (const std::string &event : events)
+    header.push_back(event);
+
+  for (size_t i = 0; i < header.size(); ++i)
+    file_ << (i ? "," : "") << csv_field(header[i]);
+  file_ << "\n";
+
+  for (const nlohmann::json &c : configs_) {
+    std::vector<std::string> row;
+    for (const std::string &column : build_columns)
+      row.push_back(csv_field(build[column]));
+    for (const std::string &column : columns)
+      if (column.compare("traffic") == 0)
+        for (const char *t : {"payload", "index", "read", "write"})
+          row.push_back(csv_field(c[column][t]));
+      else
+        row.push_back(csv_field(c[column]));
+    for (const std::string &event : events)
+      row.push_back(csv_field(c["papi"][event]));
+
+    for (size_t i = 0; i < row.size(); ++i)
+      file_ << (i ? "," : "") << row[i];
+    file_ << "\n";
+  }
+}
+
+} // namespace Spatter
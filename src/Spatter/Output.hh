@@ -0,0 +1,58 @@
+/*!
+  \file Output.hh
+*/
+
+#ifndef SPATTER_OUTPUT_HH
+#define SPATTER_OUTPUT_HH
+
+#include <fstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "Configuration.hh"
+
+namespace Spatter {
+
+// --output json:<file> or csv:<file>: the parameters and every run time of
+// each config, with the build, host and device information, for tools to
+// read instead of the text columns. Rank 0 writes the file once all
+// configs have run.
+class ResultOutput {
+public:
+  // Parses spec and opens its file, false with the reason in error if
+  // either fails
+  bool open(const std::string &spec, std::string &error);
+
+  bool enabled() const { return format_ != Format::None; }
+
+  // What print_build_info shows, filled in by main before the runs
+  nlohmann::json build = nlohmann::json::object();
+
+  // --stream peak in MB/s, summed over ranks, 0 without
+  double peak_bandwidth = 0.0;
+
+  // Adds config once its runs are done. Called on every rank: under MPI
+  // the run times are those of the slowest rank and the bytes the sum over
+  // ranks.
+  void record(const ConfigurationBase &config);
+
+  // --corun: adds the runs config made alongside the configs with, to its
+  // record, once the group has run
+  void record_corun(const ConfigurationBase &config,
+      const std::vector<size_t> &with, double alone_seconds);
+
+  void write();
+
+private:
+  void write_csv();
+
+  enum class Format { None, JSON, CSV };
+  Format format_ = Format::None;
+  std::ofstream file_;
+  nlohmann::json configs_ = nlohmann::json::array();
+};
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,75 @@
+/*!
+  \file PatternDescriptor.cc
+*/
+
+#include "PatternDescriptor.hh"
+
+namespace Spatter {
+
+size_t PatternDescriptor::size() const {
+  return segments.empty() ? 0
+                          : segments.back().offset + segments.back().length;
+}
+
+void PatternDescriptor::append(size_t base, int64_t stride, size_t length) {
+  if (length == 0)
+    return;
+
+  if (!segments.empty()) {
+    PatternSegment &last = segments.back();
+
+    // A single value takes the stride of whatever follows it
+    if (last.length == 1) {
+      int64_t step = static_cast<int64_t>(base - last.base);
+      if (length == 1 || step == stride) {
+        last.stride = step;
+        last.length += length;
+        return;
+      }
+    } else if (base ==
+            last.base + last.length * static_cast<size_t>(last.stride) &&
+        (length == 1 || stride == last.stride)) {
+      last.length += length;
+      return;
+    }
+  }
+
+  segments.push_back({size(), base, length == 1 ? 1 : stride, length});
+}
+
+void PatternDescriptor::truncate(size_t length) {
+  while (!segments.empty() && segments.back().offset >= length)
+    segments.pop_back();
+
+  if (!segments.empty() && size() > length)
+    segments.back().length = length - segments.back().offset;
+}
+
+bool PatternDescriptor::describes(
+    const size_t *pattern, size_t length) const {
+  if (segments.empty() || size() != length)
+    return false;
+
+  for (const PatternSegment &s : segments)
+    for (size_t k = 0; k < s.length; ++k)
+      if (pattern[s.offset + k] != s.base + k * static_cast<size_t>(s.stride))
+        return false;
+
+  return true;
+}
+
+const char *PatternDescriptor::name() const {
+  switch (kind) {
+  case Kind::Affine:
+    return "affine";
+  case Kind::Segmented:
+    return "segmented";
+  case Kind::Stencil:
+    return "stencil";
+  case Kind::None:
+    break;
+  }
+  return "none";
+}
+
+} // namespace Spatter
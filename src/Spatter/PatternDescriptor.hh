@@ -0,0 +1,57 @@
+/*!
+  \file PatternDescriptor.hh
+*/
+
+#ifndef SPATTER_PATTERNDESCRIPTOR_HH
+#define SPATTER_PATTERNDESCRIPTOR_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Spatter {
+
+// One affine run of a pattern:
+//   pattern[offset + k] = base + k * stride
+// for k < length. The stride is signed, the runs of a stencil step down.
+struct PatternSegment {
+  size_t offset;
+  size_t base;
+  int64_t stride;
+  size_t length;
+};
+
+// The closed form of a generated pattern as consecutive affine runs, which
+// kernels expand on the fly instead of loading indices (--procedural)
+//   affine:    UNIFORM, a single run
+//   segmented: MS1, one unit-stride run per gap
+//   stencil:   LAPLACIAN, runs of the offsets along each dimension
+// Patterns without one, like custom lists, have no segments.
+struct PatternDescriptor {
+  enum class Kind { None, Affine, Segmented, Stencil };
+
+  Kind kind = Kind::None;
+  std::vector<PatternSegment> segments;
+
+  bool empty() const { return segments.empty(); }
+
+  // Length of the pattern described
+  size_t size() const;
+
+  // Appends the run base, base + stride, ... of length values, extending the
+  // last run when it continues it
+  void append(size_t base, int64_t stride, size_t length);
+
+  // Keeps the first length values, like truncate_pattern
+  void truncate(size_t length);
+
+  // True if the runs expand to exactly the length values of pattern
+  bool describes(const size_t *pattern, size_t length) const;
+
+  // "affine", "segmented", "stencil" or "none"
+  const char *name() const;
+};
+
+} // namespace Spatter
+
+#endif
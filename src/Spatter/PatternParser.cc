@@ -4,8 +4,97 @@
 
 #include "PatternParser.hh"
 
+#include <limits>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace Spatter {
 
+namespace {
+
+// Open-addressing map from page to its compressed index, with linear
+// probing over a power-of-two table
+class PageMap {
+public:
+  explicit PageMap(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < 2 * expected)
+      capacity <<= 1;
+    keys.assign(capacity, empty);
+    values.resize(capacity);
+    mask = capacity - 1;
+  }
+
+  // The index of page, or inserts it with value when absent. Returns
+  // whether page was inserted.
+  bool insert(size_t page, size_t value, size_t &index) {
+    if (2 * (count + 1) > keys.size())
+      grow();
+
+    size_t slot = probe(page);
+    if (keys[slot] == page) {
+      index = values[slot];
+      return false;
+    }
+    keys[slot] = page;
+    values[slot] = index = value;
+    ++count;
+    return true;
+  }
+
+  // The index of a page already in the map
+  size_t find(size_t page) const { return values[probe(page)]; }
+
+  size_t size() const { return count; }
+
+private:
+  static constexpr size_t empty = std::numeric_limits<size_t>::max();
+
+  size_t probe(size_t page) const {
+    // Fibonacci hashing spreads the runs of neighbouring pages
+    size_t slot = (page * 0x9e3779b97f4a7c15ull) & mask;
+    while (keys[slot] != empty && keys[slot] != page)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  void grow() {
+    std::vector<size_t> old_keys, old_values;
+    old_keys.swap(keys);
+    old_values.swap(values);
+
+    keys.assign(2 * old_keys.size(), empty);
+    values.resize(keys.size());
+    mask = keys.size() - 1;
+    for (size_t i = 0; i < old_keys.size(); ++i)
+      if (old_keys[i] != empty) {
+        size_t slot = probe(old_keys[i]);
+        keys[slot] = old_keys[i];
+        values[slot] = old_values[i];
+      }
+  }
+
+  std::vector<size_t> keys;
+  std::vector<size_t> values;
+  size_t mask = 0;
+  size_t count = 0;
+};
+
+inline size_t pattern_page(size_t value) { return (value * 8) >> PAGE_BITS; }
+
+inline size_t compressed_value(size_t value, size_t page_index) {
+  size_t new_val = (page_index << PAGE_BITS) |
+      ((value * 8) & ((1l << PAGE_BITS) - 1l));
+  return new_val / 8;
+}
+
+// Patterns at least this long are compressed in parallel
+const size_t parallel_compress_length = 1 << 20;
+
+} // namespace
+
 size_t power(size_t base, size_t exp) {
   size_t result = 1;
   for (size_t i = 0; i < exp; ++i)
@@ -14,26 +103,57 @@ size_t power(size_t base, size_t exp) {
   return result;
 }
 
+// Pages are numbered in order of first use, and each value keeps its offset
+// within its page
 void compress_pattern(aligned_vector<size_t> &pattern) {
-  std::vector<long> pages;
-
   const size_t pattern_len = pattern.size();
-  for (size_t i = 0; i < pattern_len; i++) {
-    size_t page = (pattern[i] * 8) >> PAGE_BITS;
-    size_t page_index;
 
-    auto it = std::find(pages.begin(), pages.end(), page);
-    if (it != pages.end()) {
-      page_index = it - pages.begin();
-    } else {
-      page_index = pages.size();
-      pages.push_back(page);
+#ifdef USE_OPENMP
+  int nchunks = omp_get_max_threads();
+  if (pattern_len >= parallel_compress_length && nchunks > 1) {
+    // Pass one finds the pages each chunk uses first, in order. Merging
+    // those chunk by chunk numbers every page by its first use in the whole
+    // pattern, and pass two rewrites the chunks against the merged map.
+    std::vector<std::vector<size_t>> firsts(nchunks);
+    const size_t chunk = (pattern_len + nchunks - 1) / nchunks;
+
+#pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+    for (int c = 0; c < nchunks; ++c) {
+      const size_t begin = std::min(pattern_len, c * chunk);
+      const size_t end = std::min(pattern_len, begin + chunk);
+
+      PageMap seen(1024);
+      size_t unused;
+      for (size_t i = begin; i < end; ++i) {
+        size_t page = pattern_page(pattern[i]);
+        if (seen.insert(page, 0, unused))
+          firsts[c].push_back(page);
+      }
     }
 
-    size_t new_val = (page_index << PAGE_BITS) |
-        ((pattern[i] * 8) & ((1l << PAGE_BITS) - 1l));
-    new_val /= 8;
-    pattern[i] = new_val;
+    size_t unique = 0;
+    for (const std::vector<size_t> &pages : firsts)
+      unique += pages.size();
+
+    PageMap pages(unique);
+    size_t page_index;
+    for (const std::vector<size_t> &chunk_pages : firsts)
+      for (size_t page : chunk_pages)
+        pages.insert(page, pages.size(), page_index);
+
+#pragma omp parallel for schedule(static) num_threads(nchunks)
+    for (size_t i = 0; i < pattern_len; ++i)
+      pattern[i] =
+          compressed_value(pattern[i], pages.find(pattern_page(pattern[i])));
+    return;
+  }
+#endif
+
+  PageMap pages(1024);
+  for (size_t i = 0; i < pattern_len; i++) {
+    size_t page_index;
+    pages.insert(pattern_page(pattern[i]), pages.size(), page_index);
+    pattern[i] = compressed_value(pattern[i], page_index);
   }
 }
 
@@ -62,7 +182,8 @@ int generate_pattern_custom(std::string pattern_string,
 
 int generate_pattern_uniform(std::vector<std::string> args,
     aligned_vector<size_t> &pattern,
-    size_t &delta) {
+    size_t &delta,
+    PatternDescriptor &descriptor) {
   if ((args.size() != 2) && (args.size() != 3)) {
     std::cerr << "Parsing Error: Invalid UNIFORM Pattern "
                    "(UNIFORM:<length>:<stride>[:<delta|NR>])"
@@ -106,11 +227,15 @@ int generate_pattern_uniform(std::vector<std::string> args,
   for (int64_t i = 0; i < length; ++i)
     pattern.push_back(static_cast<size_t>(i * stride));
 
+  descriptor.kind = PatternDescriptor::Kind::Affine;
+  descriptor.append(0, stride, static_cast<size_t>(length));
+
   return 0;
 }
 
 int generate_pattern_ms1(std::vector<std::string> args,
-    aligned_vector<size_t> &pattern) {
+    aligned_vector<size_t> &pattern,
+    PatternDescriptor &descriptor) {
   if (args.size() != 3) {
     std::cerr << "Parsing Error: Invalid MS1 Pattern "
                 "(MS1:<length>:<gap_locations>:<gap(s)>)"
@@ -159,6 +284,8 @@ int generate_pattern_ms1(std::vector<std::string> args,
     return -1;
   }
 
+  descriptor.kind = PatternDescriptor::Kind::Segmented;
+
   int64_t val = -1;
   size_t gap_index = 0;
   for (size_t i = 0; i < static_cast<size_t>(length); ++i) {
@@ -172,6 +299,7 @@ int generate_pattern_ms1(std::vector<std::string> args,
       val++;
 
     pattern.push_back(static_cast<size_t>(val));
+    descriptor.append(static_cast<size_t>(val), 1, 1);
   }
 
   return 0;
@@ -179,7 +307,8 @@ int generate_pattern_ms1(std::vector<std::string> args,
 
 int generate_pattern_laplacian(std::vector<std::string> args,
     aligned_vector<size_t> &pattern,
-    size_t &delta) {
+    size_t &delta,
+    PatternDescriptor &descriptor) {
   if (args.size() != 3) {
     std::cerr << "Parsing Error: Invalid LAPLACIAN Pattern "
                   "(LAPLACIAN:<dimension>:<pseudo_order>:<problem_size>)"
@@ -241,6 +370,12 @@ int generate_pattern_laplacian(std::vector<std::string> args,
   for (size_t i = 0; i < pos_len; ++i)
     pattern[pos_len + 1 + i] = pos[i] + max;
 
+  // The offsets along each dimension are evenly spaced, so they merge into
+  // a few runs
+  descriptor.kind = PatternDescriptor::Kind::Stencil;
+  for (size_t value : pattern)
+    descriptor.append(value, 1, 1);
+
   delta = 1;
 
   return 0;
@@ -248,7 +383,10 @@ int generate_pattern_laplacian(std::vector<std::string> args,
 
 int pattern_parser(std::stringstream &pattern_string,
     aligned_vector<size_t> &pattern,
-    size_t &delta) {
+    size_t &delta,
+    PatternDescriptor &descriptor) {
+  descriptor = PatternDescriptor();
+
   std::string type, line;
   std::vector<std::string> args;
 
@@ -261,11 +399,11 @@ int pattern_parser(std::stringstream &pattern_string,
   std::regex rgx(CUSTOM_PATTERN);
 
   if (type.compare("UNIFORM") == 0)
-    ret = generate_pattern_uniform(args, pattern, delta);
+    ret = generate_pattern_uniform(args, pattern, delta, descriptor);
   else if (type.compare("MS1") == 0)
-    ret = generate_pattern_ms1(args, pattern);
+    ret = generate_pattern_ms1(args, pattern, descriptor);
   else if (type.compare("LAPLACIAN") == 0)
-    ret = generate_pattern_laplacian(args, pattern, delta);
+    ret = generate_pattern_laplacian(args, pattern, delta, descriptor);
   else if (std::regex_match(type.begin(), type.end(), rgx))
     ret = generate_pattern_custom(type, pattern);
   else
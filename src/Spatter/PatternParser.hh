@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "Configuration.hh"
+#include "PatternDescriptor.hh"
 #include "SpatterTypes.hh"
 
 #define CUSTOM_PATTERN "(^[0-9]+)(,[0-9]+)*$"
@@ -27,20 +28,26 @@ void compress_pattern(aligned_vector<size_t> &pattern);
 int generate_pattern_custom(std::string pattern_string,
     aligned_vector<size_t> &pattern);
 
+// The generators also describe the pattern they materialize
 int generate_pattern_uniform(std::vector<std::string> args,
     aligned_vector<size_t> &pattern,
-    size_t &delta);
+    size_t &delta,
+    PatternDescriptor &descriptor);
 
 int generate_pattern_ms1(std::vector<std::string> args,
-    aligned_vector<size_t> &pattern);
+    aligned_vector<size_t> &pattern,
+    PatternDescriptor &descriptor);
 
 int generate_pattern_laplacian(std::vector<std::string> args,
     aligned_vector<size_t> &pattern,
-    size_t &delta);
+    size_t &delta,
+    PatternDescriptor &descriptor);
 
+// descriptor is left empty for custom patterns
 int pattern_parser(std::stringstream &pattern_string,
     aligned_vector<size_t> &pattern,
-    size_t &delta);
+    size_t &delta,
+    PatternDescriptor &descriptor);
 
 size_t remap_pattern(aligned_vector<size_t> &pattern,
     size_t &boundary,
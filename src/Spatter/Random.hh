@@ -0,0 +1,65 @@
+/*!
+  \file Random.hh
+*/
+
+#ifndef SPATTER_RANDOM_HH
+#define SPATTER_RANDOM_HH
+
+#include <cstddef>
+#include <cstdint>
+
+// The generator is shared with the CUDA fill kernel
+#ifdef __CUDACC__
+#define SPATTER_HOST_DEVICE __host__ __device__
+#else
+#define SPATTER_HOST_DEVICE
+#endif
+
+namespace Spatter {
+
+// Counter-based buffer contents: element i of a buffer is a function of the
+// buffer's seed and i alone, so any thread or device can fill any range of
+// it and the result is the same for every split.
+
+// Buffers, each drawing from its own stream. The per-thread dense buffers
+// take DensePerThread + their thread.
+enum RandomStream : uint64_t {
+  Sparse,
+  SparseGather,
+  SparseScatter,
+  Dense,
+  DensePerThread
+};
+
+// The SplitMix64 finalizer, a bijective mix of a 64-bit word
+SPATTER_HOST_DEVICE inline uint64_t mix64(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Seed of stream within the run seeded with seed
+SPATTER_HOST_DEVICE inline uint64_t stream_seed(uint64_t seed, uint64_t stream) {
+  return mix64(seed ^ mix64(stream + 1));
+}
+
+// Element index of the stream seeded with seed, a whole number in
+// [0, 2^31) like rand_r()
+SPATTER_HOST_DEVICE inline double random_value(uint64_t seed, uint64_t index) {
+  return static_cast<double>(
+      mix64(seed + index * 0x9e3779b97f4a7c15ull) >> 33);
+}
+
+// Elements [begin, end) of a buffer of the stream seeded with seed
+inline void fill_random(
+    double *buf, size_t begin, size_t end, uint64_t seed) {
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+  for (size_t i = begin; i < end; ++i)
+    buf[i] = random_value(seed, i);
+}
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,170 @@
+/*!
+  \file RemoteSparse.cc
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+#include "Random.hh"
+#include "RemoteSparse.hh"
+
+namespace Spatter {
+
+namespace {
+
+std::unique_ptr<RemoteSparse> distributed;
+
+} // namespace
+
+RemoteSparse::RemoteSparse(size_t size, uint64_t seed) : size_(size) {
+#ifdef USE_MPI
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_);
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks_);
+#endif
+  const size_t ranks = static_cast<size_t>(ranks_);
+  block_ = std::max<size_t>(1, (size + ranks - 1) / ranks);
+  if (block_ > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    std::cerr << "--mpi-remote blocks of " << block_
+              << " elements exceed MPI displacements; use more ranks"
+              << std::endl;
+    exit(1);
+  }
+
+  displacements_.resize(ranks);
+  slots_.resize(ranks);
+
+#ifdef USE_MPI
+  MPI_Win_allocate(static_cast<MPI_Aint>(block_ * sizeof(double)),
+      sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &local_, &win_);
+
+  const size_t first = static_cast<size_t>(rank_) * block_;
+  for (size_t k = 0; k < block_; ++k)
+    local_[k] = random_value(seed, first + k);
+
+  // Rows are read and written within one passive epoch on every rank
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+  MPI_Win_sync(win_);
+  MPI_Barrier(MPI_COMM_WORLD);
+#else
+  (void)seed;
+#endif
+}
+
+RemoteSparse::~RemoteSparse() {
+#ifdef USE_MPI
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Win_unlock_all(win_);
+    MPI_Win_free(&win_);
+  }
+#endif
+}
+
+size_t RemoteSparse::first_iteration(size_t count) const {
+  return count * static_cast<size_t>(rank_) / static_cast<size_t>(ranks_);
+}
+
+void RemoteSparse::bucket_(const size_t *pattern, size_t n, size_t base) {
+  for (int r = 0; r < ranks_; ++r) {
+    displacements_[r].clear();
+    slots_[r].clear();
+  }
+
+  for (size_t j = 0; j < n; ++j) {
+    const size_t index = base + pattern[j];
+    const size_t owner = index / block_;
+    displacements_[owner].push_back(static_cast<int>(index - owner * block_));
+    slots_[owner].push_back(j);
+  }
+
+  staging_.resize(n);
+}
+
+void RemoteSparse::gather(
+    double *dense, const size_t *pattern, size_t n, size_t base) {
+  bucket_(pattern, n, base);
+
+#ifdef USE_MPI
+  size_t staged = 0;
+  for (int r = 0; r < ranks_; ++r) {
+    const std::vector<int> &d = displacements_[r];
+    if (d.empty())
+      continue;
+
+    // This rank's block is read in place
+    if (r == rank_) {
+      for (size_t k = 0; k < d.size(); ++k)
+        dense[slots_[r][k]] = local_[d[k]];
+      continue;
+    }
+
+    MPI_Datatype target;
+    MPI_Type_create_indexed_block(
+        static_cast<int>(d.size()), 1, d.data(), MPI_DOUBLE, &target);
+    MPI_Type_commit(&target);
+    MPI_Get(staging_.data() + staged, static_cast<int>(d.size()), MPI_DOUBLE,
+        r, 0, 1, target, win_);
+    MPI_Type_free(&target);
+    staged += d.size();
+  }
+  MPI_Win_flush_all(win_);
+
+  staged = 0;
+  for (int r = 0; r < ranks_; ++r) {
+    if (r == rank_)
+      continue;
+    for (size_t slot : slots_[r])
+      dense[slot] = staging_[staged++];
+  }
+#else
+  (void)dense;
+#endif
+}
+
+void RemoteSparse::scatter(
+    const double *dense, const size_t *pattern, size_t n, size_t base) {
+  bucket_(pattern, n, base);
+
+#ifdef USE_MPI
+  // Accumulates replace element by element, so the ranks' conflicting
+  // writes, this rank's own block included, each land whole
+  size_t staged = 0;
+  for (int r = 0; r < ranks_; ++r) {
+    const std::vector<int> &d = displacements_[r];
+    if (d.empty())
+      continue;
+
+    for (size_t slot : slots_[r])
+      staging_[staged++] = dense[slot];
+
+    MPI_Datatype target;
+    MPI_Type_create_indexed_block(
+        static_cast<int>(d.size()), 1, d.data(), MPI_DOUBLE, &target);
+    MPI_Type_commit(&target);
+    MPI_Accumulate(staging_.data() + staged - d.size(),
+        static_cast<int>(d.size()), MPI_DOUBLE, r, 0, 1, target, MPI_REPLACE,
+        win_);
+    MPI_Type_free(&target);
+  }
+  MPI_Win_flush_all(win_);
+#else
+  (void)dense;
+#endif
+}
+
+void distribute_sparse(size_t size, uint64_t seed) {
+  if (distributed && distributed->size() >= size)
+    return;
+
+  // The previous window is freed before the next is allocated
+  distributed.reset();
+  distributed = std::make_unique<RemoteSparse>(size, seed);
+}
+
+RemoteSparse *remote_sparse() { return distributed.get(); }
+
+} // namespace Spatter
@@ -0,0 +1,74 @@
+/*!
+  \file RemoteSparse.hh
+*/
+
+#ifndef SPATTER_REMOTESPARSE_HH
+#define SPATTER_REMOTESPARSE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_MPI
+#include "mpi.h"
+#endif
+
+namespace Spatter {
+
+// The sparse buffer of --mpi-remote, block-distributed over the ranks in an
+// MPI window. Rows are gathered with one MPI_Get and scattered with one
+// MPI_Accumulate per owning rank, all ranks scattering the same indices.
+// Only built with MPI.
+class RemoteSparse {
+public:
+  // Distributes size elements, element i being the one a local sparse of
+  // stream seed would hold
+  RemoteSparse(size_t size, uint64_t seed);
+  ~RemoteSparse();
+
+  RemoteSparse(const RemoteSparse &) = delete;
+  RemoteSparse &operator=(const RemoteSparse &) = delete;
+
+  size_t size() const { return size_; }
+
+  // Iteration this rank starts from among count, so each rank begins in its
+  // own block and walks through the others
+  size_t first_iteration(size_t count) const;
+
+  // dense[j] = sparse[base + pattern[j]] for j < n
+  void gather(double *dense, const size_t *pattern, size_t n, size_t base);
+  // sparse[base + pattern[j]] = dense[j] for j < n
+  void scatter(const double *dense, const size_t *pattern, size_t n,
+      size_t base);
+
+private:
+  // Buckets the indices of a row by the rank owning them
+  void bucket_(const size_t *pattern, size_t n, size_t base);
+
+  size_t size_;
+  size_t block_;
+  int rank_ = 0;
+  int ranks_ = 1;
+  double *local_ = nullptr;
+
+  // Per owning rank, the displacements a row reads in its block and the
+  // dense slots they belong to
+  std::vector<std::vector<int>> displacements_;
+  std::vector<std::vector<size_t>> slots_;
+  std::vector<double> staging_;
+
+#ifdef USE_MPI
+  MPI_Win win_;
+#endif
+};
+
+// Distributes a sparse buffer of size elements for --mpi-remote, replacing
+// any smaller one. Collective over all ranks.
+void distribute_sparse(size_t size, uint64_t seed);
+
+// The distributed sparse buffer, nullptr unless --mpi-remote
+RemoteSparse *remote_sparse();
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,170 @@
+/*!
+  \file SharedWindows.cc
+*/
+
+#include "SharedWindows.hh"
+
+#ifdef USE_MPI
+#include <cstdint>
+#include <vector>
+
+#include "mpi.h"
+#endif
+
+namespace Spatter {
+
+#ifdef USE_MPI
+namespace {
+
+struct Window {
+  char *data; // this rank's buffer
+  size_t span;
+  MPI_Win win;
+};
+
+std::vector<Window> windows;
+bool armed = false;
+size_t armed_offset = 0;
+
+MPI_Comm node_comm() {
+  static MPI_Comm node = MPI_COMM_NULL;
+  if (node == MPI_COMM_NULL)
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+        MPI_INFO_NULL, &node);
+  return node;
+}
+
+} // namespace
+#endif
+
+bool shared_mode(const std::string &name, SharedMode &mode) {
+  if (name.compare("off") == 0)
+    mode = SharedMode::Off;
+  else if (name.compare("sparse") == 0)
+    mode = SharedMode::Sparse;
+  else if (name.compare("all") == 0)
+    mode = SharedMode::All;
+  else
+    return false;
+  return true;
+}
+
+bool shared_windows_available() {
+#ifdef USE_MPI
+  return true;
+#else
+  return false;
+#endif
+}
+
+int node_rank() {
+#ifdef USE_MPI
+  int rank = 0;
+  MPI_Comm_rank(node_comm(), &rank);
+  return rank;
+#else
+  return 0;
+#endif
+}
+
+int node_ranks() {
+#ifdef USE_MPI
+  int size = 1;
+  MPI_Comm_size(node_comm(), &size);
+  return size;
+#else
+  return 1;
+#endif
+}
+
+void arm_shared_window(size_t offset) {
+#ifdef USE_MPI
+  armed = true;
+  armed_offset = offset;
+#else
+  (void)offset;
+#endif
+}
+
+void *shared_window_alloc(size_t bytes) {
+#ifdef USE_MPI
+  if (!armed)
+    return nullptr;
+  armed = false;
+
+  // The node's first rank allocates all of the window, with room to align
+  // it to a cache line
+  constexpr size_t align = 64;
+  const size_t rank = static_cast<size_t>(node_rank());
+  const size_t ranks = static_cast<size_t>(node_ranks());
+  const size_t window_bytes = bytes + armed_offset * (ranks - 1) + align;
+
+  void *base = nullptr;
+  MPI_Win win;
+  MPI_Win_allocate_shared(
+      static_cast<MPI_Aint>(rank == 0 ? window_bytes : 0), 1, MPI_INFO_NULL,
+      node_comm(), &base, &win);
+
+  MPI_Aint size;
+  int disp_unit;
+  MPI_Win_shared_query(win, 0, &size, &disp_unit, &base);
+  // Ranks load and store the window directly, synchronized by
+  // shared_window_fence()
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+  const uintptr_t first =
+      (reinterpret_cast<uintptr_t>(base) + align - 1) & ~(align - 1);
+  char *data = reinterpret_cast<char *>(first) + armed_offset * rank;
+  windows.push_back(
+      {data, bytes + armed_offset * (ranks - 1 - rank), win});
+  return data;
+#else
+  (void)bytes;
+  return nullptr;
+#endif
+}
+
+bool shared_window_free(void *p) {
+#ifdef USE_MPI
+  for (auto w = windows.begin(); w != windows.end(); ++w) {
+    if (w->data != p)
+      continue;
+
+    // Windows still held at exit go with the process
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized) {
+      MPI_Win_unlock_all(w->win);
+      MPI_Win_free(&w->win);
+    }
+    windows.erase(w);
+    return true;
+  }
+#else
+  (void)p;
+#endif
+  return false;
+}
+
+size_t shared_window_span(const void *p) {
+#ifdef USE_MPI
+  for (const Window &w : windows)
+    if (w.data == p)
+      return w.span;
+#else
+  (void)p;
+#endif
+  return 0;
+}
+
+void shared_window_fence() {
+#ifdef USE_MPI
+  for (const Window &w : windows)
+    MPI_Win_sync(w.win);
+  MPI_Barrier(node_comm());
+  for (const Window &w : windows)
+    MPI_Win_sync(w.win);
+#endif
+}
+
+} // namespace Spatter
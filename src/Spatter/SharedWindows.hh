@@ -0,0 +1,51 @@
+/*!
+  \file SharedWindows.hh
+*/
+
+#ifndef SPATTER_SHAREDWINDOWS_HH
+#define SPATTER_SHAREDWINDOWS_HH
+
+#include <cstddef>
+#include <string>
+
+namespace Spatter {
+
+// --mpi-shared buffers, allocated once per node in an MPI shared memory
+// window (MPI_Win_allocate_shared) rather than once per rank:
+//   Sparse: sparse
+//   All:    sparse and sparse_gather
+enum class SharedMode { Off, Sparse, All };
+
+// By --mpi-shared name: "off", "sparse" or "all". false for others.
+bool shared_mode(const std::string &name, SharedMode &mode);
+
+// Whether this binary was built with MPI
+bool shared_windows_available();
+
+// This rank among the ranks of its node, and their number. 0 and 1 without
+// MPI.
+int node_rank();
+int node_ranks();
+
+// Makes the next aligned_allocator allocation a window shared by the ranks
+// of this node, each of which must make the same allocation. The buffer of
+// node rank r starts r * offset bytes into the window, so the ranks overlap
+// in all but their first offset bytes.
+void arm_shared_window(size_t offset);
+
+// bytes of the armed window for this rank, nullptr if none is armed
+void *shared_window_alloc(size_t bytes);
+
+// Frees the window of p, with the node's other ranks, if
+// shared_window_alloc returned it. false otherwise.
+bool shared_window_free(void *p);
+
+// Bytes of the window of p from p to its end, 0 if p is not a window
+size_t shared_window_span(const void *p);
+
+// Waits for the node's ranks, making the windows each wrote visible to all
+void shared_window_fence();
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,259 @@
+/*!
+  \file SimdKernels.cc
+*/
+
+#include "SimdKernels.hh"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SPATTER_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+#define SPATTER_SIMD_SVE 1
+#include <arm_sve.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#endif
+
+namespace Spatter {
+
+namespace {
+
+void scalar_gather(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; ++j)
+    dst[j] = src[idx[j]];
+}
+
+void scalar_scatter(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; ++j)
+    dst[idx[j]] = src[j];
+}
+
+#ifdef SPATTER_SIMD_X86
+// x86 has no non-temporal gather or scatter, but MOVNTI streams single
+// 64-bit elements and is part of baseline x86-64
+inline void stream_double(double *dst, double value) {
+  long long bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  _mm_stream_si64(reinterpret_cast<long long *>(dst), bits);
+}
+
+void scalar_gather_nt(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; ++j)
+    stream_double(dst + j, src[idx[j]]);
+}
+
+void scalar_scatter_nt(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; ++j)
+    stream_double(dst + idx[j], src[j]);
+}
+#else
+// Without streaming stores the regular kernels stand in
+constexpr SimdRowKernel scalar_gather_nt = scalar_gather;
+constexpr SimdRowKernel scalar_scatter_nt = scalar_scatter;
+#endif
+
+#ifdef SPATTER_SIMD_X86
+// The x86 kernels are compiled for their ISA with target attributes, so the
+// rest of the build keeps its baseline flags
+__attribute__((target("avx2"))) void avx2_gather(
+    double *dst, const double *src, const uint32_t *idx, size_t n) {
+  // The masked forms take an explicit zero source, which also breaks the
+  // dependency on the previous destination register
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  size_t j = 0;
+  for (; j + 4 <= n; j += 4) {
+    __m128i vindex = _mm_loadu_si128(reinterpret_cast<const __m128i *>(idx + j));
+    _mm256_storeu_pd(dst + j,
+        _mm256_mask_i32gather_pd(_mm256_setzero_pd(), src, vindex, all, 8));
+  }
+  for (; j < n; ++j)
+    dst[j] = src[idx[j]];
+}
+
+// The vector streaming stores need an aligned destination, so the head of
+// the row up to it is streamed element by element
+__attribute__((target("avx2"))) void avx2_gather_nt(
+    double *dst, const double *src, const uint32_t *idx, size_t n) {
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  size_t j = 0;
+  for (; j < n && (reinterpret_cast<uintptr_t>(dst + j) & 31); ++j)
+    stream_double(dst + j, src[idx[j]]);
+  for (; j + 4 <= n; j += 4) {
+    __m128i vindex = _mm_loadu_si128(reinterpret_cast<const __m128i *>(idx + j));
+    _mm256_stream_pd(dst + j,
+        _mm256_mask_i32gather_pd(_mm256_setzero_pd(), src, vindex, all, 8));
+  }
+  for (; j < n; ++j)
+    stream_double(dst + j, src[idx[j]]);
+}
+
+__attribute__((target("avx512f"))) void avx512_gather(
+    double *dst, const double *src, const uint32_t *idx, size_t n) {
+  size_t j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256i vindex =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + j));
+    _mm512_storeu_pd(dst + j,
+        _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, vindex, src, 8));
+  }
+  for (; j < n; ++j)
+    dst[j] = src[idx[j]];
+}
+
+__attribute__((target("avx512f"))) void avx512_gather_nt(
+    double *dst, const double *src, const uint32_t *idx, size_t n) {
+  size_t j = 0;
+  for (; j < n && (reinterpret_cast<uintptr_t>(dst + j) & 63); ++j)
+    stream_double(dst + j, src[idx[j]]);
+  for (; j + 8 <= n; j += 8) {
+    __m256i vindex =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + j));
+    _mm512_stream_pd(dst + j,
+        _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, vindex, src, 8));
+  }
+  for (; j < n; ++j)
+    stream_double(dst + j, src[idx[j]]);
+}
+
+// Lanes are written in order, so duplicate indices keep the last value like
+// the scalar loop
+__attribute__((target("avx512f"))) void avx512_scatter(
+    double *dst, const double *src, const uint32_t *idx, size_t n) {
+  size_t j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256i vindex =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(idx + j));
+    _mm512_i32scatter_pd(dst, vindex, _mm512_loadu_pd(src + j), 8);
+  }
+  for (; j < n; ++j)
+    dst[idx[j]] = src[j];
+}
+#endif
+
+#ifdef SPATTER_SIMD_SVE
+// The 32-bit indices are widened into the 64-bit lanes by the load
+void sve_gather(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; j += svcntd()) {
+    svbool_t pg = svwhilelt_b64(j, n);
+    svuint64_t vindex = svld1uw_u64(pg, idx + j);
+    svst1_f64(pg, dst + j, svld1_gather_u64index_f64(pg, src, vindex));
+  }
+}
+
+void sve_scatter(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; j += svcntd()) {
+    svbool_t pg = svwhilelt_b64(j, n);
+    svuint64_t vindex = svld1uw_u64(pg, idx + j);
+    svst1_scatter_u64index_f64(pg, dst, vindex, svld1_f64(pg, src + j));
+  }
+}
+
+void sve_gather_nt(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; j += svcntd()) {
+    svbool_t pg = svwhilelt_b64(j, n);
+    svuint64_t vindex = svld1uw_u64(pg, idx + j);
+    svstnt1_f64(pg, dst + j, svld1_gather_u64index_f64(pg, src, vindex));
+  }
+}
+
+// The non-temporal scatter is SVE2 only
+#ifdef __ARM_FEATURE_SVE2
+void sve_scatter_nt(double *dst, const double *src, const uint32_t *idx,
+    size_t n) {
+  for (size_t j = 0; j < n; j += svcntd()) {
+    svbool_t pg = svwhilelt_b64(j, n);
+    svuint64_t vindex = svld1uw_u64(pg, idx + j);
+    svstnt1_scatter_u64index_f64(pg, dst, vindex, svld1_f64(pg, src + j));
+  }
+}
+#else
+constexpr SimdRowKernel sve_scatter_nt = sve_scatter;
+#endif
+#endif
+
+const SimdKernels scalar_kernels = {SimdIsa::Scalar, "scalar",
+    scalar_gather, scalar_scatter, scalar_gather_nt, scalar_scatter_nt};
+#ifdef SPATTER_SIMD_X86
+// AVX2 has no scatter instruction
+const SimdKernels avx2_kernels = {SimdIsa::AVX2, "AVX2", avx2_gather,
+    scalar_scatter, avx2_gather_nt, scalar_scatter_nt};
+const SimdKernels avx512_kernels = {SimdIsa::AVX512, "AVX-512", avx512_gather,
+    avx512_scatter, avx512_gather_nt, scalar_scatter_nt};
+#endif
+#ifdef SPATTER_SIMD_SVE
+const SimdKernels sve_kernels = {SimdIsa::SVE, "SVE", sve_gather, sve_scatter,
+    sve_gather_nt, sve_scatter_nt};
+#endif
+
+} // namespace
+
+void simd_store_fence() {
+#ifdef SPATTER_SIMD_X86
+  _mm_sfence();
+#endif
+}
+
+const SimdKernels *simd_kernels(SimdIsa isa) {
+  switch (isa) {
+  case SimdIsa::Scalar:
+    return &scalar_kernels;
+  case SimdIsa::AVX2:
+#ifdef SPATTER_SIMD_X86
+    if (__builtin_cpu_supports("avx2"))
+      return &avx2_kernels;
+#endif
+    return nullptr;
+  case SimdIsa::AVX512:
+#ifdef SPATTER_SIMD_X86
+    if (__builtin_cpu_supports("avx512f"))
+      return &avx512_kernels;
+#endif
+    return nullptr;
+  case SimdIsa::SVE:
+#ifdef SPATTER_SIMD_SVE
+    if (getauxval(AT_HWCAP) & HWCAP_SVE)
+      return &sve_kernels;
+#endif
+    return nullptr;
+  }
+  return nullptr;
+}
+
+const SimdKernels &simd_kernels_best() {
+  static const SimdKernels *best = [] {
+    for (SimdIsa isa : {SimdIsa::SVE, SimdIsa::AVX512, SimdIsa::AVX2})
+      if (const SimdKernels *kernels = simd_kernels(isa))
+        return kernels;
+    return &scalar_kernels;
+  }();
+  return *best;
+}
+
+const SimdKernels *simd_kernels(const std::string &name) {
+  if (name.compare("auto") == 0)
+    return &simd_kernels_best();
+  if (name.compare("scalar") == 0)
+    return simd_kernels(SimdIsa::Scalar);
+  if (name.compare("avx2") == 0)
+    return simd_kernels(SimdIsa::AVX2);
+  if (name.compare("avx512") == 0)
+    return simd_kernels(SimdIsa::AVX512);
+  if (name.compare("sve") == 0)
+    return simd_kernels(SimdIsa::SVE);
+  return nullptr;
+}
+
+} // namespace Spatter
@@ -0,0 +1,51 @@
+/*!
+  \file SimdKernels.hh
+*/
+
+#ifndef SPATTER_SIMDKERNELS_HH
+#define SPATTER_SIMDKERNELS_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Spatter {
+
+// Instruction sets with hand-written gather/scatter kernels
+enum class SimdIsa { Scalar, AVX2, AVX512, SVE };
+
+// One pattern row with 32-bit indices:
+//   gather:  dst[j] = src[idx[j]]
+//   scatter: dst[idx[j]] = src[j]
+// for j < n. Indices must be below 2^31 for the x86 kernels.
+typedef void (*SimdRowKernel)(
+    double *dst, const double *src, const uint32_t *idx, size_t n);
+
+struct SimdKernels {
+  SimdIsa isa;
+  const char *name;
+  SimdRowKernel gather;
+  SimdRowKernel scatter;
+  // Non-temporal stores for the written side (--nt-stores). Callers issue
+  // simd_store_fence() once the thread is done with them.
+  SimdRowKernel gather_nt;
+  SimdRowKernel scatter_nt;
+};
+
+// Orders the calling thread's non-temporal stores before later stores
+void simd_store_fence();
+
+// The kernels for isa, or nullptr if this binary or CPU lacks it
+const SimdKernels *simd_kernels(SimdIsa isa);
+
+// The widest instruction set the CPU supports, detected once via
+// CPUID or HWCAP. Scalar if none of the others are available.
+const SimdKernels &simd_kernels_best();
+
+// By --simd name: "auto" (the best), "scalar", "avx2", "avx512" or "sve".
+// nullptr for other names and unsupported instruction sets.
+const SimdKernels *simd_kernels(const std::string &name);
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,71 @@
+/*!
+  \file Statistics.cc
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Statistics.hh"
+
+namespace Spatter {
+
+namespace {
+
+// Two-sided 95% quantile of Student's t for the given degrees of freedom,
+// rounded up past 30
+double t95(size_t dof) {
+  static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+      2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+      2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056,
+      2.052, 2.048, 2.045, 2.042};
+  if (dof <= 30)
+    return table[dof - 1];
+  if (dof <= 40)
+    return 2.042;
+  if (dof <= 60)
+    return 2.021;
+  if (dof <= 120)
+    return 2.000;
+  return 1.980;
+}
+
+} // namespace
+
+RunStatistics run_statistics(const double *seconds, size_t runs) {
+  RunStatistics stats;
+  stats.runs = runs;
+  if (runs == 0)
+    return stats;
+
+  std::vector<double> sorted(seconds, seconds + runs);
+  std::sort(sorted.begin(), sorted.end());
+  stats.min = sorted.front();
+  stats.median = (runs % 2) ? sorted[runs / 2]
+                            : (sorted[runs / 2 - 1] + sorted[runs / 2]) / 2.0;
+
+  double sum = 0.0;
+  for (double s : sorted)
+    sum += s;
+  stats.mean = sum / static_cast<double>(runs);
+  if (runs < 2)
+    return stats;
+
+  double squares = 0.0;
+  for (double s : sorted)
+    squares += (s - stats.mean) * (s - stats.mean);
+  stats.stddev = std::sqrt(squares / static_cast<double>(runs - 1));
+
+  if (stats.mean > 0.0)
+    stats.ci95 = t95(runs - 1) * stats.stddev /
+        std::sqrt(static_cast<double>(runs)) / stats.mean;
+  return stats;
+}
+
+std::ostream &operator<<(std::ostream &out, const RunStatistics &stats) {
+  return out << "runs: " << stats.runs << " min " << stats.min << " median "
+             << stats.median << " mean " << stats.mean << " stddev "
+             << stats.stddev << " ci95 " << stats.ci95;
+}
+
+} // namespace Spatter
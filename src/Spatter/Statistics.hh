@@ -0,0 +1,30 @@
+/*!
+  \file Statistics.hh
+*/
+
+#ifndef SPATTER_STATISTICS_HH
+#define SPATTER_STATISTICS_HH
+
+#include <cstddef>
+#include <ostream>
+
+namespace Spatter {
+
+// Spread of the times of a config's timed runs
+struct RunStatistics {
+  size_t runs = 0;
+  double min = 0.0;
+  double median = 0.0;
+  double mean = 0.0;
+  double stddev = 0.0; // sample standard deviation
+  // Half-width of the 95% confidence interval of the mean, over the mean
+  double ci95 = 0.0;
+};
+
+RunStatistics run_statistics(const double *seconds, size_t runs);
+
+std::ostream &operator<<(std::ostream &out, const RunStatistics &stats);
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,205 @@
+/*!
+  \file Stream.cc
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "AlignedAllocator.hh"
+#include "CacheFlush.hh"
+#include "Stream.hh"
+#include "Threads.hh"
+#include "Timer.hh"
+
+namespace Spatter {
+
+size_t stream_elements(size_t sharers) {
+  sharers = std::max<size_t>(sharers, 1);
+  size_t bytes =
+      std::max(4 * last_level_cache_bytes() / sharers, size_t(64) << 20);
+
+  // The three arrays of every sharer in at most half of memory
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long page_bytes = sysconf(_SC_PAGESIZE);
+  if (pages > 0 && page_bytes > 0)
+    bytes = std::min(bytes,
+        static_cast<size_t>(pages) * static_cast<size_t>(page_bytes) / 2 /
+            (3 * sharers));
+  return bytes / sizeof(double);
+}
+
+StreamBaseline host_stream(size_t n, int threads, int runs) {
+  std::vector<double, aligned_allocator<double, 64>> va(n), vb(n), vc(n);
+  double *a = va.data(), *b = vb.data(), *c = vc.data();
+  const double scalar = 3.0;
+
+  // First touched by the threads that stream them
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+  {
+#ifdef USE_OPENMP
+    pin_thread(omp_get_thread_num());
+#pragma omp for schedule(static)
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      a[i] = 1.0;
+      b[i] = 2.0;
+      c[i] = 0.0;
+    }
+  }
+
+  double copy = std::numeric_limits<double>::max();
+  double triad = std::numeric_limits<double>::max();
+  for (int run = 0; run < runs; ++run) {
+    Timer timer;
+    timer.start();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+    for (size_t i = 0; i < n; ++i)
+      c[i] = a[i];
+    timer.stop();
+    copy = std::min(copy, timer.seconds());
+
+    timer.clear();
+    timer.start();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+    for (size_t i = 0; i < n; ++i)
+      a[i] = b[i] + scalar * c[i];
+    timer.stop();
+    triad = std::min(triad, timer.seconds());
+  }
+
+  StreamBaseline baseline;
+  const double bytes = static_cast<double>(n * sizeof(double));
+  baseline.copy = 2.0 * bytes / copy / 1000000.0;
+  baseline.triad = 3.0 * bytes / triad / 1000000.0;
+  return baseline;
+}
+
+#ifdef USE_TENSTORRENT
+double tt_stream_copy(TensTorrentDevice &device, size_t n, int runs) {
+  // Identity tiles, delta one tile: the gather reader's contiguous copy
+  const uint32_t tile = 32 * 32;
+  n = (n + tile - 1) / tile * tile;
+  const size_t bytes = n * device.element_size();
+
+  std::vector<uint32_t> pattern(tile);
+  for (uint32_t i = 0; i < tile; ++i)
+    pattern[i] = i;
+  AffinePattern affine;
+  affine.valid = true;
+  affine.stride = 1;
+
+  try {
+    auto src = device.allocate_buffer(bytes);
+    auto dst = device.allocate_buffer(bytes);
+    auto pattern_buffer = device.allocate_buffer(tile * sizeof(uint32_t));
+    device.writeBuffer(pattern_buffer, pattern);
+
+    // The first launch compiles the program
+    if (!device.executeGatherKernel(src, dst, pattern_buffer,
+            static_cast<uint32_t>(n), tile, tile, nullptr, affine))
+      return 0.0;
+
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < runs; ++run) {
+      Timer timer;
+      timer.start();
+      if (!device.executeGatherKernel(src, dst, pattern_buffer,
+              static_cast<uint32_t>(n), tile, tile, nullptr, affine))
+        return 0.0;
+      timer.stop();
+      best = std::min(best, timer.seconds());
+    }
+    return 2.0 * static_cast<double>(bytes) / best / 1000000.0;
+  } catch (const std::exception &) {
+    return 0.0;
+  }
+}
+#endif
+
+std::string stream_cache_path() {
+  const char *xdg = std::getenv("XDG_CACHE_HOME");
+  const char *home = std::getenv("HOME");
+  std::string dir;
+  if (xdg && *xdg)
+    dir = xdg;
+  else if (home && *home)
+    dir = std::string(home) + "/.cache";
+  else
+    return "";
+  return dir + "/spatter/stream.json";
+}
+
+namespace {
+
+nlohmann::json read_cache(const std::string &path) {
+  std::ifstream file(path);
+  if (!file)
+    return nlohmann::json::object();
+  nlohmann::json cache = nlohmann::json::parse(file, nullptr, false);
+  return cache.is_object() ? cache : nlohmann::json::object();
+}
+
+} // namespace
+
+bool load_stream_baseline(const std::string &key, StreamBaseline &baseline) {
+  const std::string path = stream_cache_path();
+  if (path.empty())
+    return false;
+
+  const nlohmann::json cache = read_cache(path);
+  auto entry = cache.find(key);
+  if (entry == cache.end() || !entry->is_object() ||
+      !entry->value("copy", nlohmann::json()).is_number())
+    return false;
+
+  baseline.copy = (*entry)["copy"].get<double>();
+  baseline.triad = entry->value("triad", 0.0);
+  baseline.cached = true;
+  return baseline.copy > 0.0;
+}
+
+bool save_stream_baseline(
+    const std::string &key, const StreamBaseline &baseline) {
+  const std::string path = stream_cache_path();
+  if (path.empty())
+    return false;
+
+  // The cache directory and spatter/ in it, if missing
+  const std::string dir = path.substr(0, path.rfind('/'));
+  mkdir(dir.substr(0, dir.rfind('/')).c_str(), 0755);
+  mkdir(dir.c_str(), 0755);
+
+  nlohmann::json cache = read_cache(path);
+  cache[key] = {{"copy", baseline.copy}, {"triad", baseline.triad}};
+
+  // Written aside and renamed over, so concurrent runs never read half a
+  // file
+  const std::string tmp = path + "." + std::to_string(getpid());
+  {
+    std::ofstream file(tmp);
+    if (!file)
+      return false;
+    file << cache.dump(2) << std::endl;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace Spatter
@@ -0,0 +1,53 @@
+/*!
+  \file Stream.hh
+*/
+
+#ifndef SPATTER_STREAM_HH
+#define SPATTER_STREAM_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#ifdef USE_TENSTORRENT
+#include "TensTorrentBackend.hh"
+#endif
+
+namespace Spatter {
+
+// STREAM copy and triad bandwidth of a backend, in MB/s as STREAM counts
+// it (16 and 24 bytes an element), the peak --stream reports configs
+// against
+struct StreamBaseline {
+  double copy = 0.0;
+  double triad = 0.0; // 0 on backends without a triad
+  bool cached = false; // read from the host's cache rather than measured
+
+  double peak() const { return std::max(copy, triad); }
+};
+
+// Doubles per array for each of sharers processes streaming at once,
+// STREAM's rule of at least 4x the last level cache between them
+size_t stream_elements(size_t sharers = 1);
+
+// c = a and a = b + s * c over n doubles on threads OpenMP threads, the
+// fastest of runs of each
+StreamBaseline host_stream(size_t n, int threads, int runs);
+
+#ifdef USE_TENSTORRENT
+// MB/s of a DRAM to DRAM copy of n elements, the contiguous gather's plain
+// tile copy, the fastest of runs. 0 if the kernel fails.
+double tt_stream_copy(TensTorrentDevice &device, size_t n, int runs);
+#endif
+
+// The host's cached baselines, by key, in
+// $XDG_CACHE_HOME/spatter/stream.json (~/.cache/spatter by default).
+// false if the key is not cached or the cache can't be written.
+std::string stream_cache_path();
+bool load_stream_baseline(const std::string &key, StreamBaseline &baseline);
+bool save_stream_baseline(
+    const std::string &key, const StreamBaseline &baseline);
+
+} // namespace Spatter
+
+#endif
@@ -0,0 +1,174 @@
+/*!
+  \file Sweep.cc
+*/
+
+#include <sstream>
+
+#include "Sweep.hh"
+
+namespace Spatter {
+
+namespace {
+
+// Sweeps past this many configs are almost certainly a typo
+const size_t max_sweep_size = 1000000;
+
+// A number or 2^k, false on anything else
+bool parse_number(const std::string &text, size_t &value, bool &power) {
+  power = text.compare(0, 2, "2^") == 0;
+  const std::string digits = power ? text.substr(2) : text;
+  if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos)
+    return false;
+
+  try {
+    value = std::stoul(digits);
+  } catch (const std::exception &) {
+    return false;
+  }
+  if (power) {
+    if (value >= 64)
+      return false;
+    value = size_t(1) << value;
+  }
+  return true;
+}
+
+bool parse_item(const std::string &item, std::vector<std::string> &values,
+    std::string &error) {
+  const size_t dots = item.find("..");
+  size_t first = 0, last = 0;
+  bool first_power = false, last_power = false;
+  if (dots == std::string::npos) {
+    if (!parse_number(item, first, first_power)) {
+      error = "invalid number " + item;
+      return false;
+    }
+    values.push_back(std::to_string(first));
+    return true;
+  }
+
+  std::string end = item.substr(dots + 2);
+  size_t factor = 1, step = 1;
+  const size_t op = end.find_first_of("x+");
+  if (op != std::string::npos) {
+    bool power = false;
+    size_t by = 0;
+    if (!parse_number(end.substr(op + 1), by, power) || by == 0 ||
+        (end[op] == 'x' && by < 2)) {
+      error = "invalid step in " + item;
+      return false;
+    }
+    (end[op] == 'x' ? factor : step) = by;
+    end = end.substr(0, op);
+  }
+
+  if (!parse_number(item.substr(0, dots), first, first_power) ||
+      !parse_number(end, last, last_power) || first > last) {
+    error = "invalid range " + item;
+    return false;
+  }
+  if (op == std::string::npos && first_power && last_power)
+    factor = 2;
+  if (factor > 1 && first == 0) {
+    error = "geometric range " + item + " cannot start at 0";
+    return false;
+  }
+
+  for (size_t v = first; v <= last && values.size() <= max_sweep_size;) {
+    values.push_back(std::to_string(v));
+    const size_t next = (factor > 1) ? v * factor : v + step;
+    if (next <= v)
+      break;
+    v = next;
+  }
+  return true;
+}
+
+} // namespace
+
+bool parse_sweep(
+    const std::string &spec, std::vector<SweepAxis> &axes, std::string &error) {
+  axes.clear();
+
+  std::stringstream axis_specs(spec);
+  std::string axis_spec;
+  while (std::getline(axis_specs, axis_spec, ';')) {
+    if (axis_spec.empty())
+      continue;
+
+    const size_t equals = axis_spec.find('=');
+    SweepAxis axis;
+    axis.name = axis_spec.substr(0, equals);
+    if (equals == std::string::npos ||
+        (axis.name.compare("kernel") != 0 && axis.name.compare("threads") != 0 &&
+            axis.name.compare("tt-cores") != 0 &&
+            axis.name.compare("delta") != 0 && axis.name.compare("count") != 0 &&
+            axis.name.compare("wrap") != 0)) {
+      error = "--sweep varies kernel, threads, tt-cores, delta, count or "
+              "wrap, not " + axis_spec;
+      return false;
+    }
+    for (const SweepAxis &other : axes)
+      if (other.name.compare(axis.name) == 0) {
+        error = "--sweep lists " + axis.name + " twice";
+        return false;
+      }
+
+    std::stringstream items(axis_spec.substr(equals + 1));
+    std::string item;
+    while (std::getline(items, item, ',')) {
+      if (axis.name.compare("kernel") == 0)
+        axis.values.push_back(item);
+      else if (!parse_item(item, axis.values, error))
+        return false;
+    }
+    if (axis.values.empty()) {
+      error = "--sweep gives " + axis.name + " no values";
+      return false;
+    }
+    axes.push_back(axis);
+  }
+
+  if (axes.empty()) {
+    error = "--sweep needs at least one name=values";
+    return false;
+  }
+
+  size_t size = 1;
+  for (const SweepAxis &axis : axes) {
+    size *= axis.values.size();
+    if (size > max_sweep_size) {
+      error = "--sweep has more than " + std::to_string(max_sweep_size) +
+          " configs";
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t sweep_size(const std::vector<SweepAxis> &axes) {
+  size_t size = 1;
+  for (const SweepAxis &axis : axes)
+    size *= axis.values.size();
+  return size;
+}
+
+std::vector<std::string> sweep_point(
+    const std::vector<SweepAxis> &axes, size_t i) {
+  std::vector<std::string> point(axes.size());
+  for (size_t a = axes.size(); a-- > 0;) {
+    point[a] = axes[a].values[i % axes[a].values.size()];
+    i /= axes[a].values.size();
+  }
+  return point;
+}
+
+std::string sweep_name(const std::vector<SweepAxis> &axes, size_t i) {
+  const std::vector<std::string> point = sweep_point(axes, i);
+  std::string name;
+  for (size_t a = 0; a < axes.size(); ++a)
+    name += (a ? " " : "") + axes[a].name + "=" + point[a];
+  return name;
+}
+
+} // namespace Spatter
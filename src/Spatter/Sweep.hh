@@ -0,0 +1,39 @@
+/*!
+  \file Sweep.hh
+*/
+
+#ifndef SPATTER_SWEEP_HH
+#define SPATTER_SWEEP_HH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Spatter {
+
+// One parameter --sweep varies and the values it takes
+struct SweepAxis {
+  std::string name; // kernel, threads, tt-cores, delta, count or wrap
+  std::vector<std::string> values;
+};
+
+// Parses a --sweep spec, name=item,item,...;name=..., into its axes. An
+// item is a value or a range: a..b steps by 1, a..bxF multiplies by F and
+// a..b+S steps by S. Numbers may be written 2^k, and 2^a..2^b doubles.
+// false, with the reason in error, on invalid specs.
+bool parse_sweep(
+    const std::string &spec, std::vector<SweepAxis> &axes, std::string &error);
+
+// Configs of the sweep, every combination of the axes' values
+size_t sweep_size(const std::vector<SweepAxis> &axes);
+
+// The value of each axis at combination i, the last axis varying fastest
+std::vector<std::string> sweep_point(
+    const std::vector<SweepAxis> &axes, size_t i);
+
+// "name=value name=value ..." of combination i
+std::string sweep_name(const std::vector<SweepAxis> &axes, size_t i);
+
+} // namespace Spatter
+
+#endif
@@ -1,4 +1,4 @@
-/*!w
+/*!
   \file TensTorrentBackend.cc
 */
 
@@ -6,14 +6,18 @@
 
 #ifdef USE_TENSTORRENT
 
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <set>
 #include "AlignedAllocator.hh"
 #include <algorithm>
+#include <numeric>
 #include <tt-metalium/bfloat16.hpp>
 #include <tt-metalium/tensor_accessor_args.hpp>
 #include <tt-metalium/work_split.hpp>
+#include <tt-metalium/tt_metal.hpp>
+#include <tt-metalium/allocator.hpp>
 
 using namespace tt::tt_metal;
 
@@ -46,14 +50,93 @@ public:
 // Global debug stream instance
 static TTDebugStream tt_debug;
 
-TensTorrentDevice::TensTorrentDevice(int device_id, int num_cores) 
+bool parse_tt_dtype(const std::string& name, TTDataType& dtype) {
+    if (name == "bf16") {
+        dtype = TTDataType::BF16;
+    } else if (name == "fp32") {
+        dtype = TTDataType::FP32;
+    } else if (name == "u32") {
+        dtype = TTDataType::U32;
+    } else if (name == "u64-as-2xu32") {
+        dtype = TTDataType::U64_AS_2XU32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+AffinePattern detect_affine_pattern(const aligned_vector<size_t>& pattern) {
+    AffinePattern affine;
+    if (pattern.empty() || pattern[0] > UINT32_MAX) {
+        return affine;
+    }
+    size_t stride = pattern.size() > 1 && pattern[1] >= pattern[0] ?
+        pattern[1] - pattern[0] : 0;
+    for (size_t i = 1; i < pattern.size(); ++i) {
+        if (pattern[i] != pattern[0] + stride * i) {
+            return affine;
+        }
+    }
+    if (stride > UINT32_MAX) {
+        return affine;
+    }
+    affine.valid = true;
+    affine.base = static_cast<uint32_t>(pattern[0]);
+    affine.stride = static_cast<uint32_t>(stride);
+    return affine;
+}
+
+TensTorrentDevice::TensTorrentDevice(int device_id, int num_cores, const std::string& dtype) 
     : device_id_(device_id), initialized_(false), device_(nullptr), command_queue_(nullptr), num_cores_(num_cores) {
+    configure(num_cores, dtype);
 }
 
 TensTorrentDevice::~TensTorrentDevice() {
     cleanup();
 }
 
+// Open devices by id. Cleared from an atexit handler registered after the
+// first device is open, so devices close before TT-Metal's own statics go.
+static std::map<int, std::shared_ptr<TensTorrentDevice>> shared_devices;
+
+static void close_shared_devices() {
+    shared_devices.clear();
+}
+
+std::shared_ptr<TensTorrentDevice> TensTorrentDevice::shared(int device_id) {
+    auto it = shared_devices.find(device_id);
+    if (it != shared_devices.end()) {
+        return it->second;
+    }
+    auto device = std::make_shared<TensTorrentDevice>(device_id);
+    if (!device->initialize()) {
+        return nullptr;
+    }
+    if (shared_devices.empty()) {
+        std::atexit(close_shared_devices);
+    }
+    shared_devices[device_id] = device;
+    return device;
+}
+
+void TensTorrentDevice::configure(int num_cores, const std::string& dtype) {
+    if (!parse_tt_dtype(dtype, dtype_)) {
+        throw std::invalid_argument("Invalid TensTorrent data type " + dtype);
+    }
+    switch (dtype_) {
+        case TTDataType::BF16:         element_size_ = sizeof(bfloat16); break;
+        case TTDataType::FP32:         element_size_ = sizeof(float); break;
+        case TTDataType::U32:          element_size_ = sizeof(uint32_t); break;
+        case TTDataType::U64_AS_2XU32: element_size_ = 2 * sizeof(uint32_t); break;
+    }
+    num_cores_ = num_cores;
+    // The program cache keys on the grid and element size, so programs
+    // built under other settings stay valid
+    if (device_) {
+        discover_cores();
+    }
+}
+
 void TensTorrentDevice::discover_cores() {
     // Get the actual compute grid size from the device
     compute_grid_size_ = device_->compute_with_storage_grid_size();
@@ -118,6 +201,12 @@ bool TensTorrentDevice::initialize() {
 }
 
 void TensTorrentDevice::cleanup() {
+    // Cached programs and buffers hold device resources and must go before
+    // the device
+    program_cache_.clear();
+    buffer_sizes_.clear();
+    buffer_pool_.clear();
+    cache_stats_buffer_.reset();
     if (device_) {
         CloseDevice(device_);
         device_ = nullptr;
@@ -126,9 +215,31 @@ void TensTorrentDevice::cleanup() {
     initialized_ = false;
 }
 
+tt::DataFormat TensTorrentDevice::data_format() const {
+    // Data-movement kernels only look at the page size, the format just has
+    // to match the element width
+    switch (dtype_) {
+        case TTDataType::FP32: return tt::DataFormat::Float32;
+        case TTDataType::U32:
+        case TTDataType::U64_AS_2XU32: return tt::DataFormat::UInt32;
+        default: return tt::DataFormat::Float16_b;
+    }
+}
+
+double TensTorrentDevice::stored_value(double value) const {
+    // Same conversions as write_buffer
+    switch (dtype_) {
+        case TTDataType::BF16: return static_cast<double>(bfloat16(static_cast<float>(value)).to_float());
+        case TTDataType::FP32: return static_cast<double>(static_cast<float>(value));
+        case TTDataType::U32: return static_cast<double>(static_cast<uint32_t>(value));
+        case TTDataType::U64_AS_2XU32: return static_cast<double>(static_cast<uint64_t>(value));
+    }
+    return value;
+}
+
 // Helper function to pretty-print buffer configuration
 void print_buffer_config(const InterleavedBufferConfig& config) {
-    uint32_t num_tiles = config.size / (32 * 32 * 2);  // 2KB per tile
+    uint32_t num_tiles = config.size / config.page_size;  // one tile per page
     
     tt_debug << "buffer config:" << std::endl; 
     tt_debug << "  Buffer size: " << config.size << " bytes (" 
@@ -158,9 +269,9 @@ std::shared_ptr<tt::tt_metal::Buffer> TensTorrentDevice::allocate_buffer(size_t
     // Check if this is a potentially problematic size
     bool is_power_of_2 = (aligned_size & (aligned_size - 1)) == 0;
     
-    // Always use TILE_SIZE_BYTES as page_size for DRAM buffers
+    // Always use one tile as page_size for DRAM buffers
     // This matches the TT-Metal examples (loopback, vecadd_multi_core)
-    size_t page_size = TILE_SIZE_BYTES;
+    size_t page_size = tile_size_bytes();
     
     InterleavedBufferConfig config{
         .device = device_,
@@ -170,100 +281,216 @@ std::shared_ptr<tt::tt_metal::Buffer> TensTorrentDevice::allocate_buffer(size_t
     };
     
     
+    // Reuse a pooled buffer nobody else holds
+    for (const auto& pooled : buffer_pool_) {
+        if (pooled.use_count() == 1 && pooled->size() == aligned_size &&
+            pooled->page_size() == page_size && pooled->buffer_type() == type) {
+            buffer_sizes_.erase(pooled.get());
+            tt_debug << "[TensTorrent] Reusing pooled buffer of " << aligned_size
+                      << " bytes" << std::endl;
+            return pooled;
+        }
+    }
+    
     print_buffer_config(config);
 
-    auto buffer = CreateBuffer(config);
+    std::shared_ptr<tt::tt_metal::Buffer> buffer;
+    try {
+        buffer = CreateBuffer(config);
+    } catch (const std::exception&) {
+        // Out of memory with idle buffers of other sizes in the pool, free
+        // them and try once more
+        auto idle = std::remove_if(buffer_pool_.begin(), buffer_pool_.end(),
+            [this](const std::shared_ptr<tt::tt_metal::Buffer>& pooled) {
+                if (pooled.use_count() != 1) {
+                    return false;
+                }
+                buffer_sizes_.erase(pooled.get());
+                return true;
+            });
+        if (idle == buffer_pool_.end()) {
+            throw;
+        }
+        buffer_pool_.erase(idle, buffer_pool_.end());
+        buffer = CreateBuffer(config);
+    }
+    buffer_pool_.push_back(buffer);
     return buffer;
 
 }
 
-void TensTorrentDevice::write_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
-                                     const std::vector<double>& data, bool blocking) {
-    tt_debug << "[DEBUG] write_buffer(double) called with " << data.size() << " elements" << std::endl;
-    if (!initialized_) {
-        throw std::runtime_error("TensTorrent device not initialized");
+size_t TensTorrentDevice::l1_working_set_capacity() const {
+    // L1 buffers are allocated from the top of each bank and circular
+    // buffers from the bottom, leave room for the kernels' CBs
+    size_t bank_size = device_->allocator()->get_bank_size(BufferType::L1);
+    size_t num_banks = device_->allocator()->get_num_banks(BufferType::L1);
+    if (bank_size <= L1_CB_RESERVE_BYTES) {
+        return 0;
     }
-    
-    if (!buffer) {
-        throw std::runtime_error("Invalid buffer pointer in write_buffer");
+    return (bank_size - L1_CB_RESERVE_BYTES) * num_banks;
+}
+
+tt::tt_metal::BufferType TensTorrentDevice::working_set_buffer_type(
+    const std::string& memory, size_t working_set_bytes) const {
+    if (memory == "dram") {
+        return BufferType::DRAM;
     }
     
-    if (data.empty()) {
+    size_t capacity = l1_working_set_capacity();
+    bool fits = working_set_bytes <= capacity;
+    tt_debug << "[TensTorrent] Working set " << working_set_bytes << " bytes, L1 capacity "
+              << capacity << " bytes" << std::endl;
+    
+    if (memory == "l1" && !fits) {
+        throw std::runtime_error("Working set of " + std::to_string(working_set_bytes) +
+            " bytes does not fit in L1 (" + std::to_string(capacity) + " bytes)");
+    }
+    return fits ? BufferType::L1 : BufferType::DRAM;
+}
+
+template <typename T, typename ValueAt>
+void TensTorrentDevice::write_staged(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                                     size_t first_page, size_t count, ValueAt value_at) {
+    const size_t page_size = buffer->page_size();
+    const size_t values_per_page = page_size / sizeof(T);
+    const size_t num_pages = (count + values_per_page - 1) / values_per_page;
+    if (num_pages * page_size > buffer->size()) {
+        throw std::runtime_error("Data size exceeds buffer size");
+    }
+    if (first_page >= num_pages) {
         return;
     }
     
-    buffer_sizes_[buffer] = data.size();
-    
-    size_t tile_elements = TILE_SIZE_BYTES / sizeof(bfloat16);
-    size_t aligned_size = ((data.size() + tile_elements - 1) / tile_elements) * tile_elements;
-    
-    // Create vector with exact aligned size (no extra padding)
-    // This matches TT-Metal examples which don't add extra padding
-    std::vector<bfloat16> tt_data(aligned_size);
-    
-    // Copy actual data
-    for (size_t i = 0; i < data.size(); ++i) {
-        tt_data[i] = bfloat16(static_cast<float>(data[i]));
+    // Convert one chunk of pages at a time, the last page is zero padded
+    const size_t pages_per_chunk = std::max<size_t>(1, STAGING_BYTES / page_size);
+    std::vector<T> staging(std::min(pages_per_chunk, num_pages - first_page) * values_per_page);
+    for (size_t page = first_page; page < num_pages; page += pages_per_chunk) {
+        size_t chunk_pages = std::min(pages_per_chunk, num_pages - page);
+        size_t first = page * values_per_page;
+        size_t chunk_values = chunk_pages * values_per_page;
+        for (size_t i = 0; i < chunk_values; ++i) {
+            staging[i] = first + i < count ? value_at(first + i) : static_cast<T>(0.0f);
+        }
+        EnqueueWriteSubBuffer(*command_queue_, buffer, static_cast<const void*>(staging.data()),
+            BufferRegion(page * page_size, chunk_pages * page_size), true);
     }
-    
-    // Zero out padding
-    for (size_t i = data.size(); i < aligned_size; ++i) {
-        tt_data[i] = bfloat16(0.0f);
+}
+
+template <typename T, typename Store>
+void TensTorrentDevice::read_staged(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                                    size_t count, Store store) {
+    const size_t page_size = buffer->page_size();
+    const size_t values_per_page = page_size / sizeof(T);
+    const size_t num_pages = (count + values_per_page - 1) / values_per_page;
+    if (num_pages == 0) {
+        return;
     }
     
-    if (tt_data.empty() || !tt_data.data()) {
-        throw std::runtime_error("Invalid converted data for TT-Metal buffer write");
+    const size_t pages_per_chunk = std::max<size_t>(1, STAGING_BYTES / page_size);
+    std::vector<T> staging(std::min(pages_per_chunk, num_pages) * values_per_page);
+    for (size_t page = 0; page < num_pages; page += pages_per_chunk) {
+        size_t chunk_pages = std::min(pages_per_chunk, num_pages - page);
+        size_t first = page * values_per_page;
+        EnqueueReadSubBuffer(*command_queue_, buffer, static_cast<void*>(staging.data()),
+            BufferRegion(page * page_size, chunk_pages * page_size), true);
+        size_t chunk_values = std::min(chunk_pages * values_per_page, count - first);
+        for (size_t i = 0; i < chunk_values; ++i) {
+            store(first + i, staging[i]);
+        }
+    }
+}
+
+void TensTorrentDevice::write_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                                     const double* data, size_t count) {
+    if (!initialized_) {
+        throw std::runtime_error("TensTorrent device not initialized");
     }
     
-    tt_debug << "[DEBUG] About to call EnqueueWriteBuffer(BFloat16) with " << tt_data.size() << " elements" << std::endl;
-    tt_debug << "[DEBUG] Buffer address: 0x" << std::hex << buffer->address() << std::dec 
-              << ", Buffer size: " << buffer->size() << " bytes" << std::endl;
-    tt_debug << "[DEBUG] Data vector address: " << std::hex << (void*)tt_data.data() << std::dec 
-              << ", Data size in bytes: " << (tt_data.size() * sizeof(bfloat16)) << std::endl;
+    if (!buffer) {
+        throw std::runtime_error("Invalid buffer pointer in write_buffer");
+    }
     
-    // Verify data size doesn't exceed buffer size
-    size_t data_bytes = tt_data.size() * sizeof(bfloat16);
-    if (data_bytes > buffer->size()) {
-        std::cerr << "ERROR: Data size (" << data_bytes << " bytes) exceeds buffer size (" 
-                  << buffer->size() << " bytes)" << std::endl;
-        throw std::runtime_error("Data size exceeds buffer size");
+    if (count == 0) {
+        return;
     }
     
-    try {
-        // Always use blocking write to ensure data is copied before vector goes out of scope
-        EnqueueWriteBuffer(*command_queue_, buffer, tt_data, true);
-        // Add explicit finish to ensure write completes
-        Finish(*command_queue_);
-    } catch (const std::exception& e) {
-        std::cerr << "ERROR: EnqueueWriteBuffer failed: " << e.what() << std::endl;
-        std::cerr << "  Buffer type: " << (buffer->buffer_type() == BufferType::DRAM ? "DRAM" : "L1") << std::endl;
-        std::cerr << "  Buffer size: " << buffer->size() << " bytes" << std::endl;
-        std::cerr << "  Data size: " << data_bytes << " bytes" << std::endl;
-        throw;
+    buffer_sizes_[buffer.get()] = count;
+    
+    // Convert to the device element type on the way through the staging
+    // buffer
+    switch (dtype_) {
+        case TTDataType::BF16:
+            write_staged<bfloat16>(buffer, 0, count, [data](size_t i) {
+                return bfloat16(static_cast<float>(data[i]));
+            });
+            break;
+        case TTDataType::FP32:
+            write_staged<float>(buffer, 0, count, [data](size_t i) {
+                return static_cast<float>(data[i]);
+            });
+            break;
+        case TTDataType::U32:
+            write_staged<uint32_t>(buffer, 0, count, [data](size_t i) {
+                return static_cast<uint32_t>(data[i]);
+            });
+            break;
+        case TTDataType::U64_AS_2XU32:
+            // Little-endian word order, low word first
+            write_staged<uint64_t>(buffer, 0, count, [data](size_t i) {
+                return static_cast<uint64_t>(data[i]);
+            });
+            break;
     }
-    tt_debug << "[DEBUG] EnqueueWriteBuffer(BFloat16) execution successful" << std::endl;
 }
 
-void TensTorrentDevice::read_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
-                                    std::vector<double>& data, bool blocking) {
+void TensTorrentDevice::read_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                                    double* data, size_t count) {
     if (!initialized_) {
         throw std::runtime_error("TensTorrent device not initialized");
     }
     
-    std::vector<bfloat16> tt_data;
-    EnqueueReadBuffer(*command_queue_, buffer, tt_data, blocking);
-    
-    size_t original_size = tt_data.size();
-    if (buffer_sizes_.find(buffer) != buffer_sizes_.end()) {
-        original_size = buffer_sizes_[buffer];
+    switch (dtype_) {
+        case TTDataType::BF16:
+            read_staged<bfloat16>(buffer, count, [data](size_t i, bfloat16 value) {
+                data[i] = static_cast<double>(value.to_float());
+            });
+            break;
+        case TTDataType::FP32:
+            read_staged<float>(buffer, count, [data](size_t i, float value) {
+                data[i] = static_cast<double>(value);
+            });
+            break;
+        case TTDataType::U32:
+            read_staged<uint32_t>(buffer, count, [data](size_t i, uint32_t value) {
+                data[i] = static_cast<double>(value);
+            });
+            break;
+        case TTDataType::U64_AS_2XU32:
+            read_staged<uint64_t>(buffer, count, [data](size_t i, uint64_t value) {
+                data[i] = static_cast<double>(value);
+            });
+            break;
     }
-    
-    data.clear();
-    data.reserve(original_size);
-    
-    for (size_t i = 0; i < std::min(original_size, tt_data.size()); ++i) {
-        data.push_back(static_cast<double>(tt_data[i].to_float()));
+}
+
+size_t TensTorrentDevice::logical_size(std::shared_ptr<tt::tt_metal::Buffer> buffer) const {
+    size_t size = buffer->size() / element_size_;
+    auto it = buffer_sizes_.find(buffer.get());
+    if (it != buffer_sizes_.end()) {
+        size = std::min(it->second, size);
     }
+    return size;
+}
+
+void TensTorrentDevice::write_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
+                                     const std::vector<double>& data, bool blocking) {
+    write_buffer(buffer, data.data(), data.size());
+}
+
+void TensTorrentDevice::read_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
+                                    std::vector<double>& data, bool blocking) {
+    data.resize(logical_size(buffer));
+    read_buffer(buffer, data.data(), data.size());
 }
 
 void TensTorrentDevice::writeBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
@@ -273,191 +500,284 @@ void TensTorrentDevice::writeBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer
     }
     
     // Store the original size for later reads
-    buffer_sizes_[buffer] = data.size();
+    buffer_sizes_[buffer.get()] = data.size();
     
-    // Align data to tile boundary with zero padding
-    constexpr size_t elements_per_tile = 32 * 32; // 1024 elements per tile
-    size_t aligned_size = ((data.size() + elements_per_tile - 1) / elements_per_tile) * elements_per_tile;
-    
-    std::vector<uint32_t> aligned_data = data;
-    aligned_data.resize(aligned_size, 0); // Pad with zeros
-    
-    tt_debug << "[DEBUG] About to call EnqueueWriteBuffer(uint32_t) with " << aligned_data.size() << " elements" << std::endl;
-    tt_debug << "[DEBUG] Buffer address: 0x" << std::hex << buffer->address() << std::dec 
-              << ", Buffer size: " << buffer->size() << " bytes" << std::endl;
-    EnqueueWriteBuffer(*command_queue_, buffer, aligned_data, blocking);
-    tt_debug << "[DEBUG] EnqueueWriteBuffer(uint32_t) execution successful" << std::endl;
+    // Whole pages go straight from data, only the zero padded last page is
+    // staged; a page holds page_size() / 4 indices
+    const size_t values_per_page = buffer->page_size() / sizeof(uint32_t);
+    const size_t full_pages = data.size() / values_per_page;
+    if (full_pages > 0) {
+        EnqueueWriteSubBuffer(*command_queue_, buffer, static_cast<const void*>(data.data()),
+            BufferRegion(0, full_pages * buffer->page_size()), blocking);
+    }
+    write_staged<uint32_t>(buffer, full_pages, data.size(), [&data](size_t i) {
+        return data[i];
+    });
 }
 
 void TensTorrentDevice::writeBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
                                     const aligned_vector<double>& data, bool blocking) {
-    tt_debug << "[DEBUG] writeBuffer(aligned_vector<double>) called with " << data.size() << " elements" << std::endl;
-    // Convert aligned_vector<double> to std::vector<double> and use existing method
-    std::vector<double> std_data(data.begin(), data.end());
-    write_buffer(buffer, std_data, blocking);
+    write_buffer(buffer, data.data(), data.size());
 }
 
 void TensTorrentDevice::writeBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
                                     const aligned_vector<size_t>& data, bool blocking) {
-    tt_debug << "[DEBUG] writeBuffer(aligned_vector<size_t>) called with " << data.size() << " elements" << std::endl;
-    // Convert aligned_vector<size_t> to std::vector<uint32_t> for TT-Metal
-    std::vector<uint32_t> uint32_data;
-    uint32_data.reserve(data.size());
-    for (size_t val : data) {
-        uint32_data.push_back(static_cast<uint32_t>(val));
-    }
-    writeBuffer(buffer, uint32_data, blocking);
+    if (!initialized_) {
+        throw std::runtime_error("TensTorrent device not initialized");
+    }
+    buffer_sizes_[buffer.get()] = data.size();
+    // Narrowed to uint32_t on the way through the staging buffer
+    write_staged<uint32_t>(buffer, 0, data.size(), [&data](size_t i) {
+        return static_cast<uint32_t>(data[i]);
+    });
 }
 
 void TensTorrentDevice::readBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
                                    aligned_vector<double>& data, bool blocking) {
-    // Use existing read_buffer and convert result to aligned_vector
-    std::vector<double> std_data;
-    read_buffer(buffer, std_data, blocking);
+    data.resize(logical_size(buffer));
+    read_buffer(buffer, data.data(), data.size());
+}
+
+TensTorrentDevice::CachedProgram& TensTorrentDevice::get_cached_program(
+    const ProgramSpec& spec,
+    uint32_t num_elements,
+    uint32_t pattern_length) {
+    
+    // Key on everything that is baked into the compiled program: kernel sources
+    // and defines, core grid, per-core work split, L1 layout and DRAM buffer
+    // layout (compile-time TensorAccessor args)
+    std::string kernel_names;
+    std::vector<uint32_t> layout = {
+        static_cast<uint32_t>(effective_grid_size_.x),
+        static_cast<uint32_t>(effective_grid_size_.y),
+        num_elements,
+        pattern_length,
+        spec.elements_per_unit,
+        static_cast<uint32_t>(spec.num_l1_buffers)
+    };
+    for (const auto& [cb_index, num_tiles] : spec.cb_tiles) {
+        layout.push_back(cb_index);
+        layout.push_back(num_tiles);
+    }
+    for (const auto& kernel : spec.kernels) {
+        kernel_names += kernel.name + ";";
+        layout.push_back(static_cast<uint32_t>(kernel.processor));
+        for (const auto& buffer : kernel.dram_buffers) {
+            layout.push_back(buffer->address());
+            layout.push_back(static_cast<uint32_t>(buffer->size()));
+        }
+    }
+    layout.insert(layout.end(), spec.work_offsets.begin(), spec.work_offsets.end());
+    // Every kernel is built for the device element size
+    std::map<std::string, std::string> defines = spec.defines;
+    defines["ELEM_BYTES"] = std::to_string(element_size_);
+    ProgramKey key{kernel_names, defines, layout};
     
-    // Copy to aligned_vector
-    data.clear();
-    data.reserve(std_data.size());
-    for (double val : std_data) {
-        data.push_back(val);
+    auto it = program_cache_.find(key);
+    if (it != program_cache_.end()) {
+        return *it->second;
+    }
+    
+    auto cached = std::make_unique<CachedProgram>();
+    cached->program = CreateProgram();
+    
+    // Use the effective grid size based on --tt-cores parameter
+    auto core_grid = effective_grid_size_;
+    
+    constexpr bool row_major = true;
+    CoreRangeSet all_cores;
+    
+    if (spec.work_offsets.empty()) {
+        // Split work across cores in units of elements_per_unit elements, so that
+        // kernels that own whole output tiles never share one with another core
+        uint32_t num_units = (num_elements + spec.elements_per_unit - 1) / spec.elements_per_unit;
+        auto [num_cores, cores, core_group_1, core_group_2, 
+              units_per_core_group_1, units_per_core_group_2] = 
+            split_work_to_cores(core_grid, num_units, row_major);
+        all_cores = cores;
+        
+        // Record the contiguous range of elements handled by each core
+        uint32_t start_element = 0;
+        auto work_groups = {
+            std::make_pair(core_group_1, units_per_core_group_1),
+            std::make_pair(core_group_2, units_per_core_group_2)
+        };
+        
+        for (const auto& [group, units_per_core] : work_groups) {
+            for (const auto& range : group.ranges()) {
+                for (const auto& core : range) {
+                    uint32_t end_element = std::min(
+                        start_element + units_per_core * spec.elements_per_unit, num_elements);
+                    cached->work.push_back({core, start_element, end_element - start_element});
+                    start_element = end_element;
+                }
+            }
+        }
+    } else {
+        // Ranges were decided by the caller, one core per range
+        uint32_t num_ranges = static_cast<uint32_t>(spec.work_offsets.size() - 1);
+        all_cores = num_cores_to_corerangeset(num_ranges, core_grid, row_major);
+        auto cores = corerange_to_cores(all_cores, std::nullopt, row_major);
+        for (uint32_t i = 0; i < num_ranges; ++i) {
+            cached->work.push_back({cores[i], spec.work_offsets[i],
+                                    spec.work_offsets[i + 1] - spec.work_offsets[i]});
+        }
+    }
+    
+    // Debug output for multi-core analysis
+    tt_debug << "[TensTorrent " << kernel_names << "] Building program:" << std::endl;
+    tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
+    tt_debug << "  - Device grid size: " << compute_grid_size_.x << "x" << compute_grid_size_.y 
+              << " = " << (compute_grid_size_.x * compute_grid_size_.y) << " cores" << std::endl;
+    tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
+              << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
+    tt_debug << "  - Cores actually used: " << cached->work.size() << std::endl;
+    tt_debug << "  - Elements to process: " << num_elements << std::endl;
+    tt_debug << "  - Elements per work unit: " << spec.elements_per_unit << std::endl;
+    
+    // Tile-sized L1 scratch buffers (shared across all cores)
+    InterleavedBufferConfig l1_config{
+        .device = device_,
+        .size = tile_size_bytes(),
+        .page_size = tile_size_bytes(),
+        .buffer_type = tt::tt_metal::BufferType::L1
+    };
+    for (size_t i = 0; i < spec.num_l1_buffers; ++i) {
+        cached->l1_buffers.push_back(CreateBuffer(l1_config));
+    }
+    
+    // Per-core circular buffers, used to pass tiles between reader and writer
+    // kernels and as local tile slots
+    for (const auto& [cb_index, num_tiles] : spec.cb_tiles) {
+        CircularBufferConfig cb_config = CircularBufferConfig(
+            num_tiles * tile_size_bytes(), {{cb_index, data_format()}})
+            .set_page_size(cb_index, tile_size_bytes());
+        CreateCircularBuffer(cached->program, all_cores, cb_config);
+    }
+    
+    // Create each kernel on all cores
+    for (const auto& kernel : spec.kernels) {
+        // Compile-time arguments, one TensorAccessor per DRAM buffer
+        std::vector<uint32_t> compile_time_args;
+        for (const auto& buffer : kernel.dram_buffers) {
+            TensorAccessorArgs(*buffer).append_to(compile_time_args);
+        }
+        
+        cached->kernel_ids.push_back(CreateKernel(
+            cached->program,
+            std::string(KERNEL_DIR) + kernel.name + ".cpp",
+            all_cores,
+            DataMovementConfig{
+                .processor = kernel.processor,
+                .noc = kernel.noc,
+                .compile_args = compile_time_args,
+                .defines = defines
+            }
+        ));
+    }
+    
+    cached->cache_stats = defines.count("CACHE_STATS") > 0;
+    
+    // JIT compile now so that the first timed run doesn't pay for it
+    detail::CompileProgram(device_, cached->program);
+    
+    auto& result = *cached;
+    program_cache_.emplace(std::move(key), std::move(cached));
+    return result;
+}
+
+void TensTorrentDevice::launch_program(CachedProgram& cached, LaunchMode mode) {
+    if (mode == LaunchMode::CompileOnly) {
+        return;
+    }
+    // cache_stats() sums the pages written by the last program launched
+    cache_stats_pages_ = cached.cache_stats ? static_cast<uint32_t>(cached.work.size()) : 0;
+    EnqueueProgram(*command_queue_, cached.program, false);
+    if (mode == LaunchMode::Blocking) {
+        Finish(*command_queue_);
     }
 }
+
 bool TensTorrentDevice::executeGatherKernel(
     std::shared_ptr<tt::tt_metal::Buffer> src_buffer,
     std::shared_ptr<tt::tt_metal::Buffer> dst_buffer,
     std::shared_ptr<tt::tt_metal::Buffer> pattern_buffer,
     uint32_t num_elements,
     uint32_t delta,
-    uint32_t pattern_length) {
+    uint32_t pattern_length,
+    std::shared_ptr<tt::tt_metal::Buffer> element_order,
+    const AffinePattern& affine,
+    LaunchMode mode) {
     
     if (!initialized_) {
         return false;
     }
     
     try {
-        Program gather_program = CreateProgram();
-        
-        // Tile size constants
-        constexpr uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-        
-        // Use the effective grid size based on --tt-cores parameter
-        auto core_grid = effective_grid_size_;
-        
-        // Split work across cores
-        constexpr bool row_major = true;
-        auto [num_cores, all_cores, core_group_1, core_group_2, 
-              elements_per_core_group_1, elements_per_core_group_2] = 
-            split_work_to_cores(core_grid, num_elements, row_major);
-        
-        // Debug output for multi-core analysis
-        tt_debug << "[TensTorrent Gather] Multi-core debug info:" << std::endl;
-        tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
-        tt_debug << "  - Device grid size: " << compute_grid_size_.x << "x" << compute_grid_size_.y 
-                  << " = " << (compute_grid_size_.x * compute_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
-                  << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Core grid passed to split_work: " << core_grid.x << "x" << core_grid.y 
-                  << " = " << (core_grid.x * core_grid.y) << " cores" << std::endl;
-        tt_debug << "  - Cores actually used: " << num_cores << std::endl;
-        tt_debug << "  - Elements to process: " << num_elements << std::endl;
-        tt_debug << "  - Elements per core (group 1): " << elements_per_core_group_1 << std::endl;
-        tt_debug << "  - Elements per core (group 2): " << elements_per_core_group_2 << std::endl;
-        tt_debug << "  - Number of cores in group 1: " << core_group_1.num_cores() << std::endl;
-        tt_debug << "  - Number of cores in group 2: " << core_group_2.num_cores() << std::endl;
-        
-        // Additional debug for crash investigation
-        bool is_power_of_2 = (num_elements & (num_elements - 1)) == 0;
-        if (is_power_of_2) {
-            tt_debug << "  ⚠ WARNING: Size is exact power of 2!" << std::endl;
-        }
-        
-        // Check buffer sizes
-        size_t pattern_bytes = num_elements * sizeof(uint32_t);
-        size_t sparse_bytes = num_elements * sizeof(bfloat16);
-        size_t dense_bytes = num_elements * sizeof(bfloat16);
-        tt_debug << "  - Buffer sizes:" << std::endl;
-        tt_debug << "    - Pattern: " << pattern_bytes << " bytes (" << pattern_bytes/1024 << " KB)" << std::endl;
-        tt_debug << "    - Sparse: " << sparse_bytes << " bytes (" << sparse_bytes/1024 << " KB)" << std::endl;
-        tt_debug << "    - Dense: " << dense_bytes << " bytes (" << dense_bytes/1024 << " KB)" << std::endl;
-        tt_debug << "    - Total DRAM: " << (pattern_bytes + sparse_bytes + dense_bytes) << " bytes (" 
-                  << (pattern_bytes + sparse_bytes + dense_bytes)/1024 << " KB)" << std::endl;
-        
-        // Create L1 buffers on all cores
-        InterleavedBufferConfig l1_pattern_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_sparse_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_dense_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        // Allocate the L1 buffers (shared across all cores)
-        auto l1_pattern_buffer = CreateBuffer(l1_pattern_config);
-        auto l1_sparse_buffer = CreateBuffer(l1_sparse_config);
-        auto l1_dense_buffer = CreateBuffer(l1_dense_config);
-        
-        // Compile-time arguments
-        std::vector<uint32_t> compile_time_args;
-        TensorAccessorArgs(*src_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*dst_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_buffer).append_to(compile_time_args);
-        
-        // Create kernel on all cores
-        KernelHandle gather_kernel_id = CreateKernel(
-            gather_program,
-            "/storage/tt/tt-spatter/src/Spatter/kernels/gather_kernel.cpp",
-            all_cores,  // Run on all cores instead of single core
-            DataMovementConfig{
-                .processor = DataMovementProcessor::RISCV_0,
-                .noc = NOC::RISCV_0_default,
-                .compile_args = compile_time_args
-            }
-        );
-        
-        // Set runtime arguments per core
-        uint32_t start_element = 0;
-        auto work_groups = {
-            std::make_pair(core_group_1, elements_per_core_group_1),
-            std::make_pair(core_group_2, elements_per_core_group_2)
+        // Reader on RISCV_0/NOC0 gathers output tiles into CB_DATA, fetching
+        // sparse tiles into a ring of L1 slots with several reads in flight. Writer on RISCV_1/NOC1 drains CB_DATA to dense.
+        // Work is split on output tile boundaries.
+        ProgramSpec spec;
+        spec.kernels = {
+            {"gather_reader_kernel", {src_buffer, pattern_buffer},
+             DataMovementProcessor::RISCV_0, NOC::RISCV_0_default},
+            {"dense_writer_kernel", {dst_buffer},
+             DataMovementProcessor::RISCV_1, NOC::RISCV_1_default}
         };
-        
-        for (const auto& [group, elements_per_core] : work_groups) {
-            for (const auto& range : group.ranges()) {
-                for (const auto& core : range) {
-                    const std::vector<uint32_t> runtime_args = {
-                        l1_pattern_buffer->address(),    // arg0: pattern L1 buffer
-                        l1_sparse_buffer->address(),     // arg1: sparse L1 buffer  
-                        l1_dense_buffer->address(),      // arg2: dense L1 buffer
-                        start_element,                   // arg3: start element for this core
-                        elements_per_core,               // arg4: number of elements for this core
-                        delta,                           // arg5: delta
-                        pattern_length,                  // arg6: pattern length
-                        src_buffer->address(),           // arg7: sparse DRAM buffer
-                        dst_buffer->address(),           // arg8: dense DRAM buffer
-                        pattern_buffer->address()        // arg9: pattern DRAM buffer
-                    };
-                    
-                    SetRuntimeArgs(gather_program, gather_kernel_id, core, runtime_args);
-                    start_element += elements_per_core;
-                }
+        uint32_t pattern_slots = pattern_l1_slots(pattern_length);
+        spec.cb_tiles = {{CB_DATA, 2}, {CB_GATHER_PATTERN, pattern_slots}};
+        spec.defines = {{"NUM_GATHER_PATTERN_SLOTS", std::to_string(pattern_slots)}};
+        spec.elements_per_unit = TILE_WIDTH * TILE_HEIGHT;
+        
+        // Tile-sorted order: the reader fills whole blocks of output tiles in
+        // list order, double buffered, and cores split on block boundaries
+        if (element_order) {
+            spec.kernels[0].dram_buffers.push_back(element_order);
+            spec.cb_tiles[CB_DATA] = 2 * GATHER_ORDER_BLOCK_TILES;
+            spec.cb_tiles[CB_GATHER_LIST] = ELEMENT_LIST_SLOTS;
+            spec.defines["ELEMENT_LIST"] = "1";
+            spec.defines["ELEMENT_LIST_SLOTS"] = std::to_string(ELEMENT_LIST_SLOTS);
+            spec.defines["PERMUTED_OUTPUT"] = "1";
+            spec.defines["OUTPUT_BLOCK_TILES"] = std::to_string(GATHER_ORDER_BLOCK_TILES);
+            spec.elements_per_unit = GATHER_ORDER_BLOCK_TILES * TILE_ELEMENTS;
+        }
+        // Affine patterns are computed in the kernel and a contiguous one is
+        // a plain tile copy
+        if (!element_order &&
+            add_affine_pattern(spec, affine, delta, pattern_length, CB_GATHER_PATTERN)) {
+            spec.defines["CONTIGUOUS_SOURCE"] = "1";
+            spec.defines["SOURCE_BASE_TILE"] = std::to_string(affine.base / TILE_ELEMENTS);
+        }
+        size_sparse_slots(spec, MAX_GATHER_SPARSE_SLOTS);
+        add_cache_stats(spec, 0);
+        
+        CachedProgram& cached = get_cached_program(spec, num_elements, pattern_length);
+        
+        // Only the runtime arguments are refreshed per run
+        for (const auto& work : cached.work) {
+            std::vector<uint32_t> reader_args = {
+                work.start,                      // arg0: start element for this core
+                work.count,                      // arg1: number of elements for this core
+                delta,                           // arg2: delta
+                pattern_length,                  // arg3: pattern length
+                src_buffer->address(),           // arg4: sparse DRAM buffer
+                pattern_buffer->address()        // arg5: pattern DRAM buffer
+            };
+            if (element_order) {
+                reader_args.push_back(element_order->address()); // arg6: gather order
             }
+            append_cache_stats_args(reader_args, cached, work);
+            const std::vector<uint32_t> writer_args = {
+                work.start,                      // arg0: start element for this core
+                work.count,                      // arg1: number of elements for this core
+                dst_buffer->address()            // arg2: dense DRAM buffer
+            };
+            
+            SetRuntimeArgs(cached.program, cached.kernel_ids[0], work.core, reader_args);
+            SetRuntimeArgs(cached.program, cached.kernel_ids[1], work.core, writer_args);
         }
         
-        EnqueueProgram(*command_queue_, gather_program, false);
-        Finish(*command_queue_);
+        launch_program(cached, mode);
         
         return true;
         
@@ -472,119 +792,76 @@ bool TensTorrentDevice::executeScatterKernel(
     std::shared_ptr<tt::tt_metal::Buffer> pattern_buffer,
     uint32_t num_elements,
     uint32_t delta,
-    uint32_t pattern_length) {
+    uint32_t pattern_length,
+    const ScatterPartition& partition,
+    const AffinePattern& affine,
+    LaunchMode mode) {
     
-    if (!initialized_ || !src_buffer || !dst_buffer || !pattern_buffer) {
+    if (!initialized_ || !src_buffer || !dst_buffer || !pattern_buffer ||
+        !partition.element_list) {
         return false;
     }
     
     try {
-        Program scatter_program = CreateProgram();
-        
-        // Tile size constants
-        constexpr uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-        
-        // Use the effective grid size based on --tt-cores parameter
-        auto core_grid = effective_grid_size_;
-        
-        // Split work across cores
-        constexpr bool row_major = true;
-        auto [num_cores, all_cores, core_group_1, core_group_2, 
-              elements_per_core_group_1, elements_per_core_group_2] = 
-            split_work_to_cores(core_grid, num_elements, row_major);
-        
-        // Debug output for multi-core analysis
-        tt_debug << "[TensTorrent Scatter] Multi-core debug info:" << std::endl;
-        tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
-        tt_debug << "  - Device grid size: " << compute_grid_size_.x << "x" << compute_grid_size_.y 
-                  << " = " << (compute_grid_size_.x * compute_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
-                  << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Core grid passed to split_work: " << core_grid.x << "x" << core_grid.y 
-                  << " = " << (core_grid.x * core_grid.y) << " cores" << std::endl;
-        tt_debug << "  - Cores actually used: " << num_cores << std::endl;
-        tt_debug << "  - Elements to process: " << num_elements << std::endl;
-        tt_debug << "  - Elements per core (group 1): " << elements_per_core_group_1 << std::endl;
-        tt_debug << "  - Elements per core (group 2): " << elements_per_core_group_2 << std::endl;
-        tt_debug << "  - Number of cores in group 1: " << core_group_1.num_cores() << std::endl;
-        tt_debug << "  - Number of cores in group 2: " << core_group_2.num_cores() << std::endl;
-        
-        // Create L1 buffers on all cores
-        InterleavedBufferConfig l1_pattern_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_dense_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
+        // Reader on RISCV_0/NOC0 streams dense values into CB_DATA in element
+        // list order, writer on RISCV_1/NOC1 scatters them into sparse with
+        // read-modify-write of whole sparse tiles. Each core owns the
+        // destination tiles of its range of the list.
+        ProgramSpec spec;
+        spec.kernels = {
+            {"gather_reader_kernel", {src_buffer, pattern_buffer, partition.element_list},
+             DataMovementProcessor::RISCV_0, NOC::RISCV_0_default},
+            {"scatter_writer_kernel", {dst_buffer, pattern_buffer, partition.element_list},
+             DataMovementProcessor::RISCV_1, NOC::RISCV_1_default}
         };
-        
-        InterleavedBufferConfig l1_sparse_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        // Allocate the L1 buffers (shared across all cores)
-        auto l1_pattern_buffer = CreateBuffer(l1_pattern_config);
-        auto l1_dense_buffer = CreateBuffer(l1_dense_config);
-        auto l1_sparse_buffer = CreateBuffer(l1_sparse_config);
-        
-        // Compile-time arguments
-        std::vector<uint32_t> compile_time_args;
-        TensorAccessorArgs(*src_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*dst_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_buffer).append_to(compile_time_args);
-        
-        // Create kernel on all cores
-        KernelHandle scatter_kernel_id = CreateKernel(
-            scatter_program,
-            "/storage/tt/tt-spatter/src/Spatter/kernels/scatter_kernel.cpp",
-            all_cores,  // Run on all cores instead of single core
-            DataMovementConfig{
-                .processor = DataMovementProcessor::RISCV_0,
-                .noc = NOC::RISCV_0_default,
-                .compile_args = compile_time_args
-            }
-        );
-        
-        // Set runtime arguments per core
-        uint32_t start_element = 0;
-        auto work_groups = {
-            std::make_pair(core_group_1, elements_per_core_group_1),
-            std::make_pair(core_group_2, elements_per_core_group_2)
-        };
-        
-        for (const auto& [group, elements_per_core] : work_groups) {
-            for (const auto& range : group.ranges()) {
-                for (const auto& core : range) {
-                    const std::vector<uint32_t> runtime_args = {
-                        l1_pattern_buffer->address(),   // arg0: pattern L1 buffer
-                        l1_dense_buffer->address(),     // arg1: dense L1 buffer (source)
-                        l1_sparse_buffer->address(),    // arg2: sparse L1 buffer (destination)
-                        start_element,                  // arg3: start element for this core
-                        elements_per_core,              // arg4: number of elements for this core
-                        delta,                          // arg5: delta
-                        pattern_length,                 // arg6: pattern length
-                        src_buffer->address(),          // arg7: dense DRAM buffer (source)
-                        dst_buffer->address(),          // arg8: sparse DRAM buffer (destination)
-                        pattern_buffer->address()       // arg9: pattern DRAM buffer
-                    };
-                    
-                    SetRuntimeArgs(scatter_program, scatter_kernel_id, core, runtime_args);
-                    start_element += elements_per_core;
-                }
-            }
+        uint32_t pattern_slots = pattern_l1_slots(pattern_length);
+        spec.cb_tiles = {{CB_DATA, 2},
+                         {CB_SCATTER_SCRATCH, 1}, {CB_SCATTER_PATTERN, pattern_slots},
+                         {CB_GATHER_LIST, ELEMENT_LIST_SLOTS},
+                         {CB_SCATTER_LIST, ELEMENT_LIST_SLOTS}};
+        spec.defines = {{"NUM_SCATTER_PATTERN_SLOTS", std::to_string(pattern_slots)},
+                        {"ELEMENT_LIST", "1"},
+                        {"ELEMENT_LIST_SLOTS", std::to_string(ELEMENT_LIST_SLOTS)},
+                        {"DIRECT_SOURCE", "1"}};
+        spec.work_offsets = partition.core_offsets;
+        // For a contiguous pattern the element list is the identity and every
+        // core owns whole tiles, so both sides move whole tiles
+        if (add_affine_pattern(spec, affine, delta, pattern_length, CB_SCATTER_PATTERN)) {
+            spec.defines["CONTIGUOUS_PATTERN"] = "1";
+            spec.defines["CONTIGUOUS_SOURCE"] = "1";
+            spec.defines["SOURCE_BASE_TILE"] = "0";
+        }
+        size_sparse_slots(spec, MAX_GATHER_SPARSE_SLOTS);
+        add_cache_stats(spec, 0);
+        
+        CachedProgram& cached = get_cached_program(spec, num_elements, pattern_length);
+        
+        for (const auto& work : cached.work) {
+            std::vector<uint32_t> reader_args = {
+                work.start,                     // arg0: start list position for this core
+                work.count,                     // arg1: number of elements for this core
+                0,                              // arg2: delta (unused, DIRECT_SOURCE)
+                pattern_length,                 // arg3: pattern length
+                src_buffer->address(),          // arg4: dense DRAM buffer (source)
+                pattern_buffer->address(),      // arg5: pattern DRAM buffer (unused)
+                partition.element_list->address() // arg6: element list DRAM buffer
+            };
+            append_cache_stats_args(reader_args, cached, work);
+            const std::vector<uint32_t> writer_args = {
+                work.start,                     // arg0: start list position for this core
+                work.count,                     // arg1: number of elements for this core
+                delta,                          // arg2: delta
+                pattern_length,                 // arg3: pattern length
+                dst_buffer->address(),          // arg4: sparse DRAM buffer (destination)
+                pattern_buffer->address(),      // arg5: pattern DRAM buffer
+                partition.element_list->address() // arg6: element list DRAM buffer
+            };
+            
+            SetRuntimeArgs(cached.program, cached.kernel_ids[0], work.core, reader_args);
+            SetRuntimeArgs(cached.program, cached.kernel_ids[1], work.core, writer_args);
         }
         
-        EnqueueProgram(*command_queue_, scatter_program, false);
-        Finish(*command_queue_);
+        launch_program(cached, mode);
         
         return true;
         
@@ -602,128 +879,71 @@ bool TensTorrentDevice::executeGatherScatterKernel(
     uint32_t num_elements,
     uint32_t delta_gather,
     uint32_t delta_scatter,
-    uint32_t pattern_length) {
+    uint32_t pattern_length,
+    const ScatterPartition& partition,
+    LaunchMode mode) {
     
     if (!initialized_ || !sparse_gather_buffer || !sparse_scatter_buffer || 
-        !pattern_gather_buffer || !pattern_scatter_buffer) {
+        !pattern_gather_buffer || !pattern_scatter_buffer || !partition.element_list) {
         return false;
     }
     
     try {
-        Program gather_scatter_program = CreateProgram();
-        
-        // Tile size constants
-        constexpr uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-        
-        // Use the effective grid size based on --tt-cores parameter
-        auto core_grid = effective_grid_size_;
-        
-        // Split work across cores
-        constexpr bool row_major = true;
-        auto [num_cores, all_cores, core_group_1, core_group_2, 
-              elements_per_core_group_1, elements_per_core_group_2] = 
-            split_work_to_cores(core_grid, num_elements, row_major);
-        
-        // Debug output for multi-core analysis
-        tt_debug << "[TensTorrent Gather-Scatter] Multi-core debug info:" << std::endl;
-        tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
-        tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
-                  << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Cores actually used: " << num_cores << std::endl;
-        tt_debug << "  - Elements to process: " << num_elements << std::endl;
-        tt_debug << "  - Elements per core (group 1): " << elements_per_core_group_1 << std::endl;
-        tt_debug << "  - Elements per core (group 2): " << elements_per_core_group_2 << std::endl;
-        
-        // Create L1 buffers on all cores (need 4 buffers for gather-scatter)
-        InterleavedBufferConfig l1_pattern_gather_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_pattern_scatter_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
+        // The gather reader packs sparse_gather values into CB_DATA tiles in
+        // element list order, which the scatter writer on RISCV_1/NOC1 stores
+        // into the sparse_scatter tiles owned by its core
+        ProgramSpec spec;
+        spec.kernels = {
+            {"gather_reader_kernel",
+             {sparse_gather_buffer, pattern_gather_buffer, partition.element_list},
+             DataMovementProcessor::RISCV_0, NOC::RISCV_0_default},
+            {"scatter_writer_kernel",
+             {sparse_scatter_buffer, pattern_scatter_buffer, partition.element_list},
+             DataMovementProcessor::RISCV_1, NOC::RISCV_1_default}
         };
-        
-        InterleavedBufferConfig l1_sparse_gather_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_sparse_scatter_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        // Allocate the L1 buffers (shared across all cores)
-        auto l1_pattern_gather_buffer = CreateBuffer(l1_pattern_gather_config);
-        auto l1_pattern_scatter_buffer = CreateBuffer(l1_pattern_scatter_config);
-        auto l1_sparse_gather_buffer = CreateBuffer(l1_sparse_gather_config);
-        auto l1_sparse_scatter_buffer = CreateBuffer(l1_sparse_scatter_config);
-        
-        // Compile-time arguments for all 4 TensorAccessors
-        std::vector<uint32_t> compile_time_args;
-        TensorAccessorArgs(*sparse_gather_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*sparse_scatter_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_gather_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_scatter_buffer).append_to(compile_time_args);
-        
-        // Create kernel on all cores
-        KernelHandle gather_scatter_kernel_id = CreateKernel(
-            gather_scatter_program,
-            "/storage/tt/tt-spatter/src/Spatter/kernels/gather_scatter_kernel.cpp",
-            all_cores,  // Run on all cores
-            DataMovementConfig{
-                .processor = DataMovementProcessor::RISCV_0,
-                .noc = NOC::RISCV_0_default,
-                .compile_args = compile_time_args,
-                .defines = {}
-            }
-        );
-        
-        // Set runtime arguments for each core
-        uint32_t start_element = 0;
-        
-        // Set runtime args for group 1 cores
-        for (auto& group : {core_group_1, core_group_2}) {
-            uint32_t elements_per_core = (group == core_group_1) ? 
-                elements_per_core_group_1 : elements_per_core_group_2;
-                
-            for (const auto& range : group.ranges()) {
-                for (const auto& core : range) {
-                    const std::vector<uint32_t> runtime_args = {
-                        l1_pattern_gather_buffer->address(),   // arg0: pattern_gather L1 buffer
-                        l1_pattern_scatter_buffer->address(),  // arg1: pattern_scatter L1 buffer
-                        l1_sparse_gather_buffer->address(),    // arg2: sparse_gather L1 buffer (source)
-                        l1_sparse_scatter_buffer->address(),   // arg3: sparse_scatter L1 buffer (destination)
-                        start_element,                         // arg4: start element for this core
-                        elements_per_core,                     // arg5: number of elements for this core
-                        delta_gather,                          // arg6: delta_gather
-                        delta_scatter,                         // arg7: delta_scatter
-                        pattern_length,                        // arg8: pattern length
-                        sparse_gather_buffer->address(),      // arg9: sparse_gather buffer (DRAM)
-                        sparse_scatter_buffer->address(),     // arg10: sparse_scatter buffer (DRAM)
-                        pattern_gather_buffer->address(),     // arg11: pattern_gather buffer (DRAM)
-                        pattern_scatter_buffer->address()     // arg12: pattern_scatter buffer (DRAM)
-                    };
-                    
-                    SetRuntimeArgs(gather_scatter_program, gather_scatter_kernel_id, core, runtime_args);
-                    start_element += elements_per_core;
-                }
-            }
+        // Both patterns share the L1 pattern budget
+        uint32_t pattern_slots = pattern_l1_slots(pattern_length, 2);
+        spec.cb_tiles = {{CB_DATA, 2},
+                         {CB_SCATTER_SCRATCH, 1}, {CB_GATHER_PATTERN, pattern_slots},
+                         {CB_SCATTER_PATTERN, pattern_slots},
+                         {CB_GATHER_LIST, ELEMENT_LIST_SLOTS},
+                         {CB_SCATTER_LIST, ELEMENT_LIST_SLOTS}};
+        spec.defines = {{"NUM_GATHER_PATTERN_SLOTS", std::to_string(pattern_slots)},
+                        {"NUM_SCATTER_PATTERN_SLOTS", std::to_string(pattern_slots)},
+                        {"ELEMENT_LIST", "1"},
+                        {"ELEMENT_LIST_SLOTS", std::to_string(ELEMENT_LIST_SLOTS)}};
+        spec.work_offsets = partition.core_offsets;
+        size_sparse_slots(spec, MAX_GATHER_SPARSE_SLOTS);
+        add_cache_stats(spec, 0);
+        
+        CachedProgram& cached = get_cached_program(spec, num_elements, pattern_length);
+        
+        for (const auto& work : cached.work) {
+            std::vector<uint32_t> reader_args = {
+                work.start,                            // arg0: start list position for this core
+                work.count,                            // arg1: number of elements for this core
+                delta_gather,                          // arg2: delta_gather
+                pattern_length,                        // arg3: pattern length
+                sparse_gather_buffer->address(),      // arg4: sparse_gather buffer (DRAM)
+                pattern_gather_buffer->address(),     // arg5: pattern_gather buffer (DRAM)
+                partition.element_list->address()     // arg6: element list buffer (DRAM)
+            };
+            append_cache_stats_args(reader_args, cached, work);
+            const std::vector<uint32_t> writer_args = {
+                work.start,                            // arg0: start list position for this core
+                work.count,                            // arg1: number of elements for this core
+                delta_scatter,                         // arg2: delta_scatter
+                pattern_length,                        // arg3: pattern length
+                sparse_scatter_buffer->address(),     // arg4: sparse_scatter buffer (DRAM)
+                pattern_scatter_buffer->address(),    // arg5: pattern_scatter buffer (DRAM)
+                partition.element_list->address()     // arg6: element list buffer (DRAM)
+            };
+            
+            SetRuntimeArgs(cached.program, cached.kernel_ids[0], work.core, reader_args);
+            SetRuntimeArgs(cached.program, cached.kernel_ids[1], work.core, writer_args);
         }
         
-        // Execute the program
-        EnqueueProgram(*command_queue_, gather_scatter_program, false);
-        Finish(*command_queue_);
+        launch_program(cached, mode);
         return true;
         
     } catch (const std::exception& e) {
@@ -742,7 +962,8 @@ bool TensTorrentDevice::executeMultiGatherKernel(
     uint32_t count,
     uint32_t wrap,
     uint32_t pattern_length,
-    uint32_t sparse_size_elements) {
+    uint32_t sparse_size_elements,
+    LaunchMode mode) {
     
     if (!initialized_ || !sparse_buffer || !dense_buffer || 
         !pattern_buffer || !pattern_gather_buffer) {
@@ -750,127 +971,39 @@ bool TensTorrentDevice::executeMultiGatherKernel(
     }
     
     try {
-        Program multi_gather_program = CreateProgram();
-        
-        // Tile size constants
-        constexpr uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-        
-        // Use the effective grid size based on --tt-cores parameter
-        auto core_grid = effective_grid_size_;
-        
-        // Split work across cores
-        constexpr bool row_major = true;
-        auto [num_cores, all_cores, core_group_1, core_group_2, 
-              elements_per_core_group_1, elements_per_core_group_2] = 
-            split_work_to_cores(core_grid, num_elements, row_major);
-        
-        // Debug output for multi-core analysis
-        tt_debug << "[TensTorrent Multi-Gather] Multi-core debug info:" << std::endl;
-        tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
-        tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
-                  << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Cores actually used: " << num_cores << std::endl;
-        tt_debug << "  - Elements to process: " << num_elements << std::endl;
-        tt_debug << "  - Elements per core (group 1): " << elements_per_core_group_1 << std::endl;
-        tt_debug << "  - Elements per core (group 2): " << elements_per_core_group_2 << std::endl;
-        
-        // Create L1 buffers on all cores (need 4 buffers for multi-gather)
-        InterleavedBufferConfig l1_pattern_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_pattern_gather_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_sparse_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_dense_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        // Allocate L1 buffers
-        auto l1_pattern_buffer = CreateBuffer(l1_pattern_config);
-        auto l1_pattern_gather_buffer = CreateBuffer(l1_pattern_gather_config);
-        auto l1_sparse_buffer = CreateBuffer(l1_sparse_config);
-        auto l1_dense_buffer = CreateBuffer(l1_dense_config);
-        
-        // Compile-time arguments for TensorAccessors
-        std::vector<uint32_t> compile_time_args;
-        TensorAccessorArgs(*pattern_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_gather_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*sparse_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*dense_buffer).append_to(compile_time_args);
-        
-        // Path to the kernel source
-        std::string kernel_path = "/storage/tt/tt-spatter/src/Spatter/kernels/multi_gather_kernel.cpp";
-        
-        // Create kernel on all cores
-        KernelHandle multi_gather_kernel_id = CreateKernel(
-            multi_gather_program,
-            kernel_path,
-            all_cores,
-            DataMovementConfig{
-                .processor = DataMovementProcessor::RISCV_0,
-                .noc = NOC::RISCV_0_default,
-                .compile_args = compile_time_args,
-                .defines = {}
-            }
-        );
-        
-        // Set runtime arguments per core
-        uint32_t start_element = 0;
-        auto work_groups = {
-            std::make_pair(core_group_1, elements_per_core_group_1),
-            std::make_pair(core_group_2, elements_per_core_group_2)
-        };
-        
-        for (const auto& [group, elements_per_core] : work_groups) {
-            for (const auto& range : group.ranges()) {
-                for (const auto& core : range) {
-                    uint32_t end_element = std::min(start_element + elements_per_core, num_elements);
-                    
-                    const std::vector<uint32_t> runtime_args = {
-                        l1_pattern_buffer->address(),        // arg0: pattern L1 buffer
-                        l1_pattern_gather_buffer->address(), // arg1: pattern_gather L1 buffer
-                        l1_sparse_buffer->address(),         // arg2: sparse L1 buffer
-                        l1_dense_buffer->address(),          // arg3: dense L1 buffer
-                        start_element,                       // arg4: start element for this core
-                        end_element,                         // arg5: end element for this core
-                        pattern_length,                      // arg6: pattern length
-                        delta,                               // arg7: delta
-                        count,                               // arg8: count (iterations)
-                        wrap,                                // arg9: wrap parameter
-                        sparse_size_elements,                // arg10: sparse buffer size
-                        pattern_buffer->address(),           // arg11: pattern DRAM buffer
-                        pattern_gather_buffer->address(),    // arg12: pattern_gather DRAM buffer
-                        sparse_buffer->address(),            // arg13: sparse DRAM buffer
-                        dense_buffer->address()              // arg14: dense DRAM buffer
-                    };
-                    
-                    SetRuntimeArgs(multi_gather_program, multi_gather_kernel_id, core, runtime_args);
-                    start_element = end_element;
-                }
-            }
+        ProgramSpec spec;
+        spec.kernels = {{"multi_gather_kernel", {pattern_buffer, pattern_gather_buffer, sparse_buffer, dense_buffer}}};
+        spec.num_l1_buffers = 4;
+        size_sparse_slots(spec, MAX_MULTI_GATHER_SPARSE_SLOTS);
+        add_cache_stats(spec, 0);
+        
+        CachedProgram& cached = get_cached_program(spec, num_elements, pattern_length);
+        const auto& l1 = cached.l1_buffers;
+        
+        for (const auto& work : cached.work) {
+            std::vector<uint32_t> runtime_args = {
+                l1[0]->address(),                    // arg0: pattern L1 buffer
+                l1[1]->address(),                    // arg1: pattern_gather L1 buffer
+                0,                                   // arg2: reserved (sparse tiles in c_0)
+                l1[3]->address(),                    // arg3: dense L1 buffer
+                work.start,                          // arg4: start element for this core
+                work.start + work.count,             // arg5: end element for this core
+                pattern_length,                      // arg6: pattern length
+                delta,                               // arg7: delta
+                count,                               // arg8: count (iterations)
+                wrap,                                // arg9: wrap parameter
+                sparse_size_elements,                // arg10: sparse buffer size
+                pattern_buffer->address(),           // arg11: pattern DRAM buffer
+                pattern_gather_buffer->address(),    // arg12: pattern_gather DRAM buffer
+                sparse_buffer->address(),            // arg13: sparse DRAM buffer
+                dense_buffer->address()              // arg14: dense DRAM buffer
+            };
+            append_cache_stats_args(runtime_args, cached, work);
+            
+            SetRuntimeArgs(cached.program, cached.kernel_ids[0], work.core, runtime_args);
         }
         
-        // Execute the program
-        EnqueueProgram(*command_queue_, multi_gather_program, false);
-        Finish(*command_queue_);
+        launch_program(cached, mode);
         return true;
         
     } catch (const std::exception& e) {
@@ -889,7 +1022,8 @@ bool TensTorrentDevice::executeMultiScatterKernel(
     uint32_t count,
     uint32_t wrap,
     uint32_t pattern_length,
-    uint32_t sparse_size_elements) {
+    uint32_t sparse_size_elements,
+    LaunchMode mode) {
     
     if (!initialized_ || !sparse_buffer || !dense_buffer || 
         !pattern_buffer || !pattern_scatter_buffer) {
@@ -897,127 +1031,36 @@ bool TensTorrentDevice::executeMultiScatterKernel(
     }
     
     try {
-        Program multi_scatter_program = CreateProgram();
-        
-        // Tile size constants
-        constexpr uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-        
-        // Use the effective grid size based on --tt-cores parameter
-        auto core_grid = effective_grid_size_;
-        
-        // Split work across cores
-        constexpr bool row_major = true;
-        auto [num_cores, all_cores, core_group_1, core_group_2, 
-              elements_per_core_group_1, elements_per_core_group_2] = 
-            split_work_to_cores(core_grid, num_elements, row_major);
-        
-        // Debug output for multi-core analysis
-        tt_debug << "[TensTorrent Multi-Scatter] Multi-core debug info:" << std::endl;
-        tt_debug << "  - Requested cores (--tt-cores): " << num_cores_ << std::endl;
-        tt_debug << "  - Effective grid size: " << effective_grid_size_.x << "x" << effective_grid_size_.y 
-                  << " = " << (effective_grid_size_.x * effective_grid_size_.y) << " cores" << std::endl;
-        tt_debug << "  - Cores actually used: " << num_cores << std::endl;
-        tt_debug << "  - Elements to process: " << num_elements << std::endl;
-        tt_debug << "  - Elements per core (group 1): " << elements_per_core_group_1 << std::endl;
-        tt_debug << "  - Elements per core (group 2): " << elements_per_core_group_2 << std::endl;
-        
-        // Create L1 buffers on all cores (need 4 buffers for multi-scatter)
-        InterleavedBufferConfig l1_pattern_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_pattern_scatter_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_sparse_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        InterleavedBufferConfig l1_dense_config{
-            .device = device_,
-            .size = tile_size_bytes,
-            .page_size = tile_size_bytes,
-            .buffer_type = tt::tt_metal::BufferType::L1
-        };
-        
-        // Allocate L1 buffers
-        auto l1_pattern_buffer = CreateBuffer(l1_patter`````n_config);
-        auto l1_pattern_scatter_buffer = CreateBuffer(l1_pattern_scatter_config);
-        auto l1_sparse_buffer = CreateBuffer(l1_sparse_config);
-        auto l1_dense_buffer = CreateBuffer(l1_dense_config);
-        
-        // Compile-time arguments for TensorAccessors
-        std::vector<uint32_t> compile_time_args;
-        TensorAccessorArgs(*pattern_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*pattern_scatter_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*sparse_buffer).append_to(compile_time_args);
-        TensorAccessorArgs(*dense_buffer).append_to(compile_time_args);
-        
-        // Path to the kernel source
-        std::string kernel_path = "/storage/tt/tt-spatter/src/Spatter/kernels/multi_scatter_kernel.cpp";
-        
-        // Create kernel on all cores
-        KernelHandle multi_scatter_kernel_id = CreateKernel(
-            multi_scatter_program,
-            kernel_path,
-            all_cores,
-            DataMovementConfig{
-                .processor = DataMovementProcessor::RISCV_0,
-                .noc = NOC::RISCV_0_default,
-                .compile_args = compile_time_args,
-                .defines = {}
-            }
-        );
-        
-        // Set runtime arguments per core
-        uint32_t start_element = 0;
-        auto work_groups = {
-            std::make_pair(core_group_1, elements_per_core_group_1),
-            std::make_pair(core_group_2, elements_per_core_group_2)
-        };
-        
-        for (const auto& [group, elements_per_core] : work_groups) {
-            for (const auto& range : group.ranges()) {
-                for (const auto& core : range) {
-                    uint32_t end_element = std::min(start_element + elements_per_core, num_elements);
-                    
-                    const std::vector<uint32_t> runtime_args = {
-                        l1_pattern_buffer->address(),        // arg0: pattern L1 buffer
-                        l1_pattern_scatter_buffer->address(), // arg1: pattern_scatter L1 buffer
-                        l1_sparse_buffer->address(),         // arg2: sparse L1 buffer
-                        l1_dense_buffer->address(),          // arg3: dense L1 buffer
-                        start_element,                       // arg4: start element for this core
-                        end_element,                         // arg5: end element for this core
-                        pattern_length,                      // arg6: pattern length
-                        delta,                               // arg7: delta
-                        count,                               // arg8: count (iterations)
-                        wrap,                                // arg9: wrap parameter
-                        sparse_size_elements,                // arg10: sparse buffer size
-                        pattern_buffer->address(),           // arg11: pattern DRAM buffer
-                        pattern_scatter_buffer->address(),   // arg12: pattern_scatter DRAM buffer
-                        sparse_buffer->address(),            // arg13: sparse DRAM buffer
-                        dense_buffer->address()              // arg14: dense DRAM buffer
-                    };
-                    
-                    SetRuntimeArgs(multi_scatter_program, multi_scatter_kernel_id, core, runtime_args);
-                    start_element = end_element;
-                }
-            }
+        ProgramSpec spec;
+        spec.kernels = {{"multi_scatter_kernel", {pattern_buffer, pattern_scatter_buffer, sparse_buffer, dense_buffer}}};
+        spec.num_l1_buffers = 4;
+        
+        CachedProgram& cached = get_cached_program(spec, num_elements, pattern_length);
+        const auto& l1 = cached.l1_buffers;
+        
+        for (const auto& work : cached.work) {
+            const std::vector<uint32_t> runtime_args = {
+                l1[0]->address(),                    // arg0: pattern L1 buffer
+                l1[1]->address(),                    // arg1: pattern_scatter L1 buffer
+                l1[2]->address(),                    // arg2: sparse L1 buffer
+                l1[3]->address(),                    // arg3: dense L1 buffer
+                work.start,                          // arg4: start element for this core
+                work.start + work.count,             // arg5: end element for this core
+                pattern_length,                      // arg6: pattern length
+                delta,                               // arg7: delta
+                count,                               // arg8: count (iterations)
+                wrap,                                // arg9: wrap parameter
+                sparse_size_elements,                // arg10: sparse buffer size
+                pattern_buffer->address(),           // arg11: pattern DRAM buffer
+                pattern_scatter_buffer->address(),   // arg12: pattern_scatter DRAM buffer
+                sparse_buffer->address(),            // arg13: sparse DRAM buffer
+                dense_buffer->address()              // arg14: dense DRAM buffer
+            };
+            
+            SetRuntimeArgs(cached.program, cached.kernel_ids[0], work.core, runtime_args);
         }
         
-        // Execute the program
-        EnqueueProgram(*command_queue_, multi_scatter_program, false);
-        Finish(*command_queue_);
+        launch_program(cached, mode);
         return true;
         
     } catch (const std::exception& e) {
@@ -1051,8 +1094,190 @@ void TensTorrentDevice::compile_kernels() {
 
 // Method removed - duplicated functionality with initializeGatherProgram
 
+TensTorrentDevice::ScatterPartition TensTorrentDevice::partition_scatter_targets(
+    const aligned_vector<size_t>& pattern,
+    uint32_t delta,
+    uint32_t num_elements) {
+    
+    ScatterPartition partition;
+    const size_t pattern_length = pattern.size();
+    auto dst_tile = [&](uint32_t j) -> size_t {
+        return (pattern[j % pattern_length] + static_cast<size_t>(delta) * (j / pattern_length)) /
+            TILE_ELEMENTS;
+    };
+    
+    // Counting sort of elements by destination tile. It is stable, so the
+    // elements that hit one tile keep their order and the last write to a
+    // location still wins as in the serial backend.
+    size_t num_tiles = 0;
+    for (uint32_t j = 0; j < num_elements; ++j) {
+        num_tiles = std::max(num_tiles, dst_tile(j) + 1);
+    }
+    std::vector<uint32_t> tile_offsets(num_tiles + 1, 0);
+    for (uint32_t j = 0; j < num_elements; ++j) {
+        tile_offsets[dst_tile(j) + 1]++;
+    }
+    std::partial_sum(tile_offsets.begin(), tile_offsets.end(), tile_offsets.begin());
+    
+    std::vector<uint32_t> element_list(num_elements);
+    std::vector<uint32_t> next(tile_offsets.begin(), tile_offsets.end() - 1);
+    for (uint32_t j = 0; j < num_elements; ++j) {
+        element_list[next[dst_tile(j)]++] = j;
+    }
+    
+    // Hand out whole tiles in order, moving to the next core once the current
+    // one holds its share of the elements
+    const size_t max_cores = effective_grid_size_.x * effective_grid_size_.y;
+    partition.core_offsets.push_back(0);
+    for (size_t t = 0; t < num_tiles; ++t) {
+        uint32_t end = tile_offsets[t + 1];
+        size_t share = static_cast<size_t>(num_elements) * partition.core_offsets.size() / max_cores;
+        if (end > partition.core_offsets.back() && end >= share &&
+            partition.core_offsets.size() < max_cores) {
+            partition.core_offsets.push_back(end);
+        }
+    }
+    if (partition.core_offsets.size() == 1 || partition.core_offsets.back() != num_elements) {
+        partition.core_offsets.push_back(num_elements);
+    }
+    
+    tt_debug << "[TensTorrent] Scatter targets: " << num_tiles << " tiles over "
+              << (partition.core_offsets.size() - 1) << " cores" << std::endl;
+    
+    partition.element_list = allocate_buffer(
+        std::max<size_t>(1, element_list.size()) * sizeof(uint32_t));
+    writeBuffer(partition.element_list, element_list);
+    
+    return partition;
+}
+
+std::shared_ptr<tt::tt_metal::Buffer> TensTorrentDevice::tile_sorted_gather_order(
+    const aligned_vector<size_t>& pattern,
+    uint32_t delta,
+    uint32_t num_elements) {
+    
+    const size_t pattern_length = pattern.size();
+    auto src_tile = [&](uint32_t j) -> size_t {
+        return (pattern[j % pattern_length] + static_cast<size_t>(delta) * (j / pattern_length)) /
+            TILE_ELEMENTS;
+    };
+    
+    // Within each block the output positions are ordered by the sparse tile
+    // they read, ties keep output order
+    const uint32_t block_elements = GATHER_ORDER_BLOCK_TILES * TILE_ELEMENTS;
+    std::vector<uint32_t> order(num_elements);
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<size_t> tiles(block_elements);
+    for (uint32_t block_start = 0; block_start < num_elements; block_start += block_elements) {
+        uint32_t block_end = std::min(num_elements, block_start + block_elements);
+        for (uint32_t j = block_start; j < block_end; ++j) {
+            tiles[j - block_start] = src_tile(j);
+        }
+        std::stable_sort(order.begin() + block_start, order.begin() + block_end,
+            [&](uint32_t a, uint32_t b) {
+                return tiles[a - block_start] < tiles[b - block_start];
+            });
+    }
+    
+    auto order_buffer = allocate_buffer(std::max<size_t>(1, order.size()) * sizeof(uint32_t));
+    writeBuffer(order_buffer, order);
+    return order_buffer;
+}
+
+void TensTorrentDevice::size_sparse_slots(ProgramSpec& spec, uint32_t max_slots) const {
+    // Give the sparse tile slots whatever the program's other circular
+    // buffers leave of the per-core L1 budget
+    size_t used_bytes = 0;
+    for (const auto& [cb_index, num_tiles] : spec.cb_tiles) {
+        if (cb_index != CB_SPARSE_SLOTS) {
+            used_bytes += num_tiles * tile_size_bytes();
+        }
+    }
+    size_t free_tiles = used_bytes < L1_CB_RESERVE_BYTES ?
+        (L1_CB_RESERVE_BYTES - used_bytes) / tile_size_bytes() : 0;
+    uint32_t slots = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(free_tiles, max_slots)));
+    spec.cb_tiles[CB_SPARSE_SLOTS] = slots;
+    spec.defines["NUM_SPARSE_SLOTS"] = std::to_string(slots);
+}
+
+bool TensTorrentDevice::add_affine_pattern(ProgramSpec& spec, const AffinePattern& affine,
+                                           uint32_t delta, uint32_t pattern_length,
+                                           uint32_t pattern_cb) const {
+    if (!affine.valid || pattern_length == 0) {
+        return false;
+    }
+    spec.cb_tiles.erase(pattern_cb);
+    spec.defines["AFFINE_PATTERN"] = "1";
+    spec.defines["PATTERN_BASE"] = std::to_string(affine.base) + "u";
+    spec.defines["PATTERN_STRIDE"] = std::to_string(affine.stride) + "u";
+    spec.defines["PATTERN_LENGTH"] = std::to_string(pattern_length) + "u";
+    spec.defines["PATTERN_DELTA"] = std::to_string(delta) + "u";
+    return affine.stride == 1 && delta == pattern_length &&
+        affine.base % TILE_ELEMENTS == 0;
+}
+
+void TensTorrentDevice::enable_cache_stats() {
+    if (cache_stats_buffer_) {
+        return;
+    }
+    // One page per core of the full grid
+    size_t num_pages = compute_grid_size_.x * compute_grid_size_.y;
+    InterleavedBufferConfig config{
+        .device = device_,
+        .size = num_pages * CACHE_STATS_PAGE_BYTES,
+        .page_size = CACHE_STATS_PAGE_BYTES,
+        .buffer_type = tt::tt_metal::BufferType::DRAM
+    };
+    cache_stats_buffer_ = CreateBuffer(config);
+}
+
+TensTorrentDevice::CacheStats TensTorrentDevice::cache_stats() {
+    CacheStats stats;
+    if (!cache_stats_buffer_ || cache_stats_pages_ == 0) {
+        return stats;
+    }
+    std::vector<uint32_t> words;
+    EnqueueReadBuffer(*command_queue_, cache_stats_buffer_, words, true);
+    const size_t words_per_page = CACHE_STATS_PAGE_BYTES / sizeof(uint32_t);
+    for (size_t page = 0; page < cache_stats_pages_; ++page) {
+        stats.hits += words[page * words_per_page];
+        stats.misses += words[page * words_per_page + 1];
+    }
+    return stats;
+}
+
+void TensTorrentDevice::add_cache_stats(ProgramSpec& spec, size_t kernel_index) const {
+    if (!cache_stats_buffer_) {
+        return;
+    }
+    spec.kernels[kernel_index].dram_buffers.push_back(cache_stats_buffer_);
+    spec.defines["CACHE_STATS"] = "1";
+    spec.defines["CACHE_STATS_PAGE_BYTES"] = std::to_string(CACHE_STATS_PAGE_BYTES);
+}
+
+void TensTorrentDevice::append_cache_stats_args(std::vector<uint32_t>& args,
+                                                const CachedProgram& cached,
+                                                const CoreWork& work) const {
+    if (!cached.cache_stats) {
+        return;
+    }
+    args.push_back(cache_stats_buffer_->address());
+    args.push_back(static_cast<uint32_t>(&work - cached.work.data()));
+}
+
+uint32_t TensTorrentDevice::pattern_l1_slots(uint32_t pattern_length, uint32_t num_patterns) const {
+    // Keep the whole pattern resident when it fits in its share of the L1
+    // budget, otherwise stream it through as many slots as fit
+    size_t indices_per_tile = tile_size_bytes() / sizeof(uint32_t);
+    size_t pattern_tiles = (pattern_length + indices_per_tile - 1) / indices_per_tile;
+    size_t max_slots = PATTERN_L1_BYTES / num_patterns / tile_size_bytes();
+    return static_cast<uint32_t>(std::max<size_t>(1, std::min(pattern_tiles, max_slots)));
+}
+
 size_t TensTorrentDevice::align_to_tile_size(size_t size) const {
-    return ((size + TILE_SIZE_BYTES - 1) / TILE_SIZE_BYTES) * TILE_SIZE_BYTES;
+    const size_t tile_size = tile_size_bytes();
+    return ((size + tile_size - 1) / tile_size) * tile_size;
 }
 
 // Conversion methods removed - conversion handled directly in write_buffer/read_buffer
@@ -1063,8 +1288,7 @@ void check_tt_error(const std::string& operation) {
     // This function is a placeholder for any additional error checking
 }
 
-size_t calculate_buffer_size(size_t num_elements) {
-    const size_t element_size = sizeof(bfloat16);
+size_t calculate_buffer_size(size_t num_elements, size_t element_size) {
     const size_t tile_size = 32 * 32 * element_size;
     size_t total_size = num_elements * element_size;
     
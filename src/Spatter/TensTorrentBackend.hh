@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <tuple>
 #include <tt-metalium/host_api.hpp>
 #include <tt-metalium/device.hpp>
 #include <tt-metalium/work_split.hpp>
@@ -25,11 +26,42 @@ using aligned_vector = std::vector<T, aligned_allocator<T, 64>>;
 
 namespace Spatter {
 
+// Element type stored in device buffers, selected with --tt-dtype
+enum class TTDataType {
+    BF16,          // bfloat16 (default)
+    FP32,          // float
+    U32,           // uint32_t
+    U64_AS_2XU32   // uint64_t, moved as two uint32_t words
+};
+
+// Parse a --tt-dtype name, returns false for unknown names
+bool parse_tt_dtype(const std::string& name, TTDataType& dtype);
+
+// A pattern of the form pattern[i] = base + stride * i, which the gather and
+// scatter kernels can take as compile-time constants
+struct AffinePattern {
+    bool valid = false;
+    uint32_t base = 0;
+    uint32_t stride = 0;
+};
+
+// Detects an affine pattern, valid is false for any other pattern
+AffinePattern detect_affine_pattern(const aligned_vector<size_t>& pattern);
+
 class TensTorrentDevice {
 public:
-    TensTorrentDevice(int device_id = 0, int num_cores = 0);
+    TensTorrentDevice(int device_id = 0, int num_cores = 0,
+                      const std::string& dtype = "bf16");
     ~TensTorrentDevice();
     
+    // Process-wide device for device_id, opened on first use and kept open
+    // so a suite of configs pays for device open once. Returns nullptr if
+    // the device fails to initialize.
+    static std::shared_ptr<TensTorrentDevice> shared(int device_id);
+    // Core limit (--tt-cores) and element type (--tt-dtype) for the buffers
+    // and programs that follow
+    void configure(int num_cores, const std::string& dtype);
+    
     // Device management
     bool initialize();
     void cleanup();
@@ -39,12 +71,37 @@ public:
     void discover_cores();
     std::vector<CoreCoord> get_active_cores() const { return active_cores_; }
     
-    // Memory management
+    // Element layout
+    TTDataType dtype() const { return dtype_; }
+    size_t element_size() const { return element_size_; }
+    size_t tile_size_bytes() const { return TILE_ELEMENTS * element_size_; }
+    tt::DataFormat data_format() const;
+    // A host value as it reads back after a round trip through the device
+    double stored_value(double value) const;
+    
+    // Memory management. Buffers come from a pool: one that is no longer
+    // referenced outside the pool is handed out again for the same size,
+    // type and page size.
     std::shared_ptr<tt::tt_metal::Buffer> allocate_buffer(size_t size_bytes, 
                                                           tt::tt_metal::BufferType type = tt::tt_metal::BufferType::DRAM);
-    // Method removed - use allocate_buffer directly
+    // Buffer type for a working set: "dram", "l1" (throws if it doesn't fit)
+    // or "auto" (L1 when it fits). L1 buffers are interleaved over the L1
+    // banks of all cores.
+    tt::tt_metal::BufferType working_set_buffer_type(const std::string& memory,
+                                                     size_t working_set_bytes) const;
+    size_t l1_working_set_capacity() const;
     
-    // Data transfer
+    // Data transfer. Values are converted to and from the device element
+    // type through a host staging buffer of at most STAGING_BYTES, so no
+    // full-size copy of the data is made; index writes of whole pages are
+    // sent straight from the caller's vector.
+    void write_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                      const double* data, size_t count);
+    // Reads the first count values of the buffer into data
+    void read_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                     double* data, size_t count);
+    // Number of values last written to the buffer
+    size_t logical_size(std::shared_ptr<tt::tt_metal::Buffer> buffer) const;
     void write_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
                       const std::vector<double>& data, bool blocking = true);
     void read_buffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
@@ -60,14 +117,45 @@ public:
     void writeBuffer(std::shared_ptr<tt::tt_metal::Buffer> buffer, 
                      const aligned_vector<size_t>& data, bool blocking = true);
     
-    // Kernel execution - only keep working methods
+    // Tile ownership for scatter targets. Elements are grouped by the sparse
+    // tile they write and each core gets a run of whole tiles, so no two
+    // cores read-modify-write the same tile.
+    struct ScatterPartition {
+        std::shared_ptr<tt::tt_metal::Buffer> element_list;  // DRAM, element ids by tile
+        std::vector<uint32_t> core_offsets;                   // core i owns [offsets[i], offsets[i + 1])
+    };
+    ScatterPartition partition_scatter_targets(
+        const aligned_vector<size_t>& pattern,
+        uint32_t delta,
+        uint32_t num_elements);
+    
+    // Gather order that groups each block of GATHER_ORDER_BLOCK_TILES output
+    // tiles by source tile, so random patterns fetch every sparse tile once
+    // per block. Uploaded to DRAM, for executeGatherKernel.
+    std::shared_ptr<tt::tt_metal::Buffer> tile_sorted_gather_order(
+        const aligned_vector<size_t>& pattern,
+        uint32_t delta,
+        uint32_t num_elements);
+    
+    // How an execute*Kernel call launches its program
+    enum class LaunchMode {
+        Blocking,    // enqueue and wait for completion
+        Async,       // enqueue only, the caller calls sync()
+        CompileOnly  // build and compile the program without enqueueing it
+    };
+    
+    // Kernel execution - programs are built and compiled on first use and
+    // cached, later calls only update runtime args.
     bool executeGatherKernel(
         std::shared_ptr<tt::tt_metal::Buffer> src_buffer,
         std::shared_ptr<tt::tt_metal::Buffer> dst_buffer,
         std::shared_ptr<tt::tt_metal::Buffer> pattern_buffer,
         uint32_t num_elements,
         uint32_t delta,
-        uint32_t pattern_length = 0);
+        uint32_t pattern_length = 0,
+        std::shared_ptr<tt::tt_metal::Buffer> element_order = nullptr,
+        const AffinePattern& affine = AffinePattern(),
+        LaunchMode mode = LaunchMode::Blocking);
         
     bool executeScatterKernel(
         std::shared_ptr<tt::tt_metal::Buffer> src_buffer,
@@ -75,7 +163,10 @@ public:
         std::shared_ptr<tt::tt_metal::Buffer> pattern_buffer,
         uint32_t num_elements,
         uint32_t delta,
-        uint32_t pattern_length);
+        uint32_t pattern_length,
+        const ScatterPartition& partition,
+        const AffinePattern& affine = AffinePattern(),
+        LaunchMode mode = LaunchMode::Blocking);
         
     bool executeGatherScatterKernel(
         std::shared_ptr<tt::tt_metal::Buffer> sparse_gather_buffer,
@@ -85,7 +176,9 @@ public:
         uint32_t num_elements,
         uint32_t delta_gather,
         uint32_t delta_scatter,
-        uint32_t pattern_length);
+        uint32_t pattern_length,
+        const ScatterPartition& partition,
+        LaunchMode mode = LaunchMode::Blocking);
         
     bool executeMultiGatherKernel(
         std::shared_ptr<tt::tt_metal::Buffer> sparse_buffer,
@@ -97,7 +190,8 @@ public:
         uint32_t count,
         uint32_t wrap,
         uint32_t pattern_length,
-        uint32_t sparse_size_elements);
+        uint32_t sparse_size_elements,
+        LaunchMode mode = LaunchMode::Blocking);
         
     bool executeMultiScatterKernel(
         std::shared_ptr<tt::tt_metal::Buffer> sparse_buffer,
@@ -109,7 +203,18 @@ public:
         uint32_t count,
         uint32_t wrap,
         uint32_t pattern_length,
-        uint32_t sparse_size_elements);
+        uint32_t sparse_size_elements,
+        LaunchMode mode = LaunchMode::Blocking);
+    
+    // Sparse tile cache hit and miss counts. Once enabled, programs built
+    // afterwards have each core write its counts to a DRAM stats buffer;
+    // cache_stats() sums them for the last program launched.
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    void enable_cache_stats();
+    CacheStats cache_stats();
     
     // Device information
     std::string get_device_info() const;
@@ -131,34 +236,122 @@ private:
     std::vector<CoreCoord> active_cores_;
     CoreCoord compute_grid_size_;
     CoreCoord effective_grid_size_;  // Limited by user's --tt-cores parameter
+    TTDataType dtype_;
+    size_t element_size_;            // bytes per element on the device
     
-    // Single-kernel programs (created on-demand like loopback example)
+    // One data-movement kernel of a program. dram_buffers are appended as
+    // compile-time TensorAccessor args in order.
+    struct KernelSpec {
+        std::string name;
+        std::vector<std::shared_ptr<tt::tt_metal::Buffer>> dram_buffers;
+        tt::tt_metal::DataMovementProcessor processor = tt::tt_metal::DataMovementProcessor::RISCV_0;
+        tt::tt_metal::NOC noc = tt::tt_metal::NOC::RISCV_0_default;
+    };
     
-    // Single-kernel handles (created on-demand like loopback example)
+    // Everything that is baked into a compiled program
+    struct ProgramSpec {
+        std::vector<KernelSpec> kernels;
+        size_t num_l1_buffers = 0;                  // tile-sized L1 scratch buffers
+        std::map<uint32_t, uint32_t> cb_tiles;      // circular buffer index -> tiles
+        std::map<std::string, std::string> defines; // shared by all kernels
+        uint32_t elements_per_unit = 1;             // granularity of the per-core work split
+        std::vector<uint32_t> work_offsets;         // explicit per-core ranges, replaces the split
+    };
     
-    // Removed legacy kernel handles
+    struct CoreWork {
+        CoreCoord core;
+        uint32_t start;
+        uint32_t count;
+    };
     
-    // Single-kernel approach - no lazy initialization needed
+    struct CachedProgram {
+        tt::tt_metal::Program program;
+        std::vector<tt::tt_metal::KernelHandle> kernel_ids;  // same order as ProgramSpec::kernels
+        std::vector<std::shared_ptr<tt::tt_metal::Buffer>> l1_buffers;
+        std::vector<CoreWork> work;
+        bool cache_stats = false;  // cores write CACHE_STATS pages
+    };
     
-    // Buffer size tracking for reads
-    std::map<std::shared_ptr<tt::tt_metal::Buffer>, size_t> buffer_sizes_;
+    // Compiled program cache, keyed on (kernels, defines, core grid, DRAM
+    // buffer layout, element count, pattern length, L1 layout)
+    using ProgramKey = std::tuple<std::string, std::map<std::string, std::string>,
+                                  std::vector<uint32_t>>;
+    std::map<ProgramKey, std::unique_ptr<CachedProgram>> program_cache_;
+    
+    // Buffer size tracking for reads, pooled buffers live as long as the device
+    std::map<const tt::tt_metal::Buffer*, size_t> buffer_sizes_;
+    std::vector<std::shared_ptr<tt::tt_metal::Buffer>> buffer_pool_;
+    
+    // Cache stats buffer, CACHE_STATS_PAGE_BYTES per core, and the number of
+    // pages the last launched program wrote
+    std::shared_ptr<tt::tt_metal::Buffer> cache_stats_buffer_;
+    uint32_t cache_stats_pages_ = 0;
     
     // Helper methods
     void compile_kernels();
+    CachedProgram& get_cached_program(
+        const ProgramSpec& spec,
+        uint32_t num_elements,
+        uint32_t pattern_length);
+    void launch_program(CachedProgram& cached, LaunchMode mode);
     // Single-kernel approach - no complex initialization needed
         
     size_t align_to_tile_size(size_t size) const;
+    // Pattern tiles to allocate per core for one of num_patterns patterns
+    uint32_t pattern_l1_slots(uint32_t pattern_length, uint32_t num_patterns = 1) const;
+    // Sizes the CB_SPARSE_SLOTS tiles (NUM_SPARSE_SLOTS) from the L1 the
+    // spec's other circular buffers leave free, at most max_slots
+    void size_sparse_slots(ProgramSpec& spec, uint32_t max_slots) const;
+    // Bakes an affine pattern into the spec's defines in place of the
+    // pattern tiles in pattern_cb, returns whether it is a contiguous run of
+    // whole tiles (stride 1, no reuse, tile aligned base)
+    bool add_affine_pattern(ProgramSpec& spec, const AffinePattern& affine,
+                            uint32_t delta, uint32_t pattern_length,
+                            uint32_t pattern_cb) const;
+    // Adds the stats buffer to a kernel of the spec when stats are enabled,
+    // and its runtime args (address, page) for one core
+    void add_cache_stats(ProgramSpec& spec, size_t kernel_index) const;
+    void append_cache_stats_args(std::vector<uint32_t>& args,
+                                 const CachedProgram& cached,
+                                 const CoreWork& work) const;
+    
+    // Blocking writes of value_at(i) (as T) for i < count from first_page
+    // on, and reads of the first count values into store(i, value), one
+    // staging chunk at a time
+    template <typename T, typename ValueAt>
+    void write_staged(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                      size_t first_page, size_t count, ValueAt value_at);
+    template <typename T, typename Store>
+    void read_staged(std::shared_ptr<tt::tt_metal::Buffer> buffer,
+                     size_t count, Store store);
     
     // Constants
     static constexpr size_t TILE_WIDTH = 32;
     static constexpr size_t TILE_HEIGHT = 32;
-    static constexpr size_t TILE_SIZE_BYTES = TILE_WIDTH * TILE_HEIGHT * sizeof(bfloat16);
+    static constexpr size_t TILE_ELEMENTS = TILE_WIDTH * TILE_HEIGHT;
     static constexpr size_t DRAM_ALIGNMENT = 64; // Blackhole requires 64B alignment
+    static constexpr size_t STAGING_BYTES = 4 * 1024 * 1024; // host staging per transfer chunk
+    static constexpr uint32_t MAX_GATHER_SPARSE_SLOTS = 31; // gather reader ring, slot mask is 32 bits
+    static constexpr uint32_t MAX_MULTI_GATHER_SPARSE_SLOTS = 64; // multi_gather direct-mapped cache
+    static constexpr size_t CACHE_STATS_PAGE_BYTES = 64; // per-core stats page, DRAM aligned
+    // Circular buffers shared by the reader/writer kernels
+    static constexpr uint32_t CB_SPARSE_SLOTS = 0;     // sparse tile slots (reader ring, multi_gather cache)
+    static constexpr uint32_t CB_DATA = 1;             // reader -> writer data tiles
+    static constexpr uint32_t CB_SCATTER_SCRATCH = 2;  // scatter writer read-modify-write tile
+    static constexpr uint32_t CB_GATHER_PATTERN = 3;   // gather reader pattern tiles
+    static constexpr uint32_t CB_SCATTER_PATTERN = 4;  // scatter writer pattern tiles
+    static constexpr uint32_t CB_GATHER_LIST = 5;      // gather reader element list tiles
+    static constexpr uint32_t CB_SCATTER_LIST = 6;     // scatter writer element list tiles
+    static constexpr uint32_t ELEMENT_LIST_SLOTS = 2;  // element list is read in order
+    static constexpr uint32_t GATHER_ORDER_BLOCK_TILES = 8; // output tiles per tile-sorted block
+    static constexpr size_t PATTERN_L1_BYTES = 256 * 1024; // per-core L1 budget for pattern tiles
+    static constexpr size_t L1_CB_RESERVE_BYTES = 512 * 1024; // per-bank L1 kept free for circular buffers
+    static constexpr const char* KERNEL_DIR = "/storage/tt/tt-spatter/src/Spatter/kernels/";
 };
 
 // Helper functions for TensTorrent backend
 void check_tt_error(const std::string& operation);
-size_t calculate_buffer_size(size_t num_elements);
+size_t calculate_buffer_size(size_t num_elements, size_t element_size = sizeof(bfloat16));
 
 } // namespace Spatter
 
@@ -0,0 +1,199 @@
+/*!
+  \file Threads.cc
+*/
+
+#include "Threads.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+#include <sched.h>
+
+namespace Spatter {
+
+namespace {
+
+Schedule schedule_ = {LoopSchedule::Static, 0};
+Accumulate accumulate_ = Accumulate::Auto;
+std::vector<int> affinity_;
+
+// Reads a topology id of cpu from sysfs, fallback if missing
+int topology_id(int cpu, const char *name, int fallback) {
+  std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+      "/topology/" + name);
+  int id;
+  return (in >> id) ? id : fallback;
+}
+
+std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+    return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &mask))
+      cpus.push_back(cpu);
+  return cpus;
+}
+
+bool parse_int(const std::string &s, int &value) {
+  if (s.empty() || !std::all_of(s.begin(), s.end(), ::isdigit))
+    return false;
+  try {
+    value = std::stoi(s);
+  } catch (const std::exception &) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool parse_schedule(const std::string &spec, Schedule &schedule) {
+  const size_t comma = spec.find(',');
+  const std::string kind = spec.substr(0, comma);
+
+  schedule.chunk = 0;
+  if (comma != std::string::npos &&
+      (!parse_int(spec.substr(comma + 1), schedule.chunk) ||
+          schedule.chunk < 1))
+    return false;
+
+  if (kind.compare("static") == 0)
+    schedule.kind = LoopSchedule::Static;
+  else if (kind.compare("dynamic") == 0)
+    schedule.kind = LoopSchedule::Dynamic;
+  else if (kind.compare("guided") == 0)
+    schedule.kind = LoopSchedule::Guided;
+  else
+    return false;
+  return true;
+}
+
+void set_loop_schedule(const Schedule &schedule) { schedule_ = schedule; }
+
+const Schedule &loop_schedule() { return schedule_; }
+
+bool parse_accumulate(const std::string &name, Accumulate &mode) {
+  if (name.compare("auto") == 0)
+    mode = Accumulate::Auto;
+  else if (name.compare("plain") == 0)
+    mode = Accumulate::Plain;
+  else if (name.compare("atomic") == 0)
+    mode = Accumulate::Atomic;
+  else if (name.compare("private") == 0)
+    mode = Accumulate::Private;
+  else
+    return false;
+  return true;
+}
+
+void set_accumulate(Accumulate mode) { accumulate_ = mode; }
+
+Accumulate accumulate() { return accumulate_; }
+
+bool affinity_cpus(
+    const std::string &spec, std::vector<int> &cpus, std::string &err) {
+  const std::vector<int> allowed = allowed_cpus();
+  std::vector<int> order;
+
+  if (spec.compare(0, 5, "list:") == 0) {
+    std::stringstream list(spec.substr(5));
+    std::string item;
+    while (std::getline(list, item, ',')) {
+      const size_t dash = item.find('-');
+      int first, last;
+      if (!parse_int(item.substr(0, dash), first) ||
+          !parse_int(dash == std::string::npos ? item.substr(0, dash)
+                                               : item.substr(dash + 1),
+              last) ||
+          last < first) {
+        err = "Invalid CPU list entry '" + item + "'";
+        return false;
+      }
+      for (int cpu = first; cpu <= last; ++cpu) {
+        if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end()) {
+          err = "CPU " + std::to_string(cpu) + " is not available";
+          return false;
+        }
+        order.push_back(cpu);
+      }
+    }
+  } else if (spec.compare("compact") == 0 || spec.compare("scatter") == 0) {
+    // (package, core, cpu) of every allowed CPU
+    std::vector<std::tuple<int, int, int>> topology;
+    for (int cpu : allowed)
+      topology.emplace_back(topology_id(cpu, "physical_package_id", 0),
+          topology_id(cpu, "core_id", cpu), cpu);
+    std::sort(topology.begin(), topology.end());
+
+    if (spec.compare("compact") == 0) {
+      for (auto const &entry : topology)
+        order.push_back(std::get<2>(entry));
+    } else {
+      // Rank each CPU among its core's siblings and each core within its
+      // package, then take all first siblings of the first cores first
+      std::vector<std::tuple<int, int, int, int>> ranked;
+      int sibling = 0, core_rank = 0;
+      for (size_t i = 0; i < topology.size(); ++i) {
+        auto [package, core, cpu] = topology[i];
+        if (i > 0 && std::get<0>(topology[i - 1]) != package) {
+          sibling = 0;
+          core_rank = 0;
+        } else if (i > 0 && std::get<1>(topology[i - 1]) == core) {
+          ++sibling;
+        } else if (i > 0) {
+          sibling = 0;
+          ++core_rank;
+        }
+        ranked.emplace_back(sibling, core_rank, package, cpu);
+      }
+      std::sort(ranked.begin(), ranked.end());
+      for (auto const &entry : ranked)
+        order.push_back(std::get<3>(entry));
+    }
+  } else {
+    err = "Valid affinities are: compact, scatter, list:<cpus>";
+    return false;
+  }
+
+  if (order.empty()) {
+    err = "No CPUs to pin to";
+    return false;
+  }
+
+  cpus = order;
+  return true;
+}
+
+void set_thread_affinity(const std::vector<int> &cpus) { affinity_ = cpus; }
+
+bool thread_affinity_enabled() { return !affinity_.empty(); }
+
+void pin_thread(int t) {
+  if (affinity_.empty())
+    return;
+
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  CPU_SET(affinity_[t % affinity_.size()], &mask);
+  sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+int current_cpu() { return sched_getcpu(); }
+
+void SpinBarrier::wait() {
+  const size_t generation = generation_.load(std::memory_order_acquire);
+  if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == threads_) {
+    waiting_.store(0, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+    return;
+  }
+  while (generation_.load(std::memory_order_acquire) == generation)
+    ;
+}
+
+} // namespace Spatter
@@ -0,0 +1,84 @@
+/*!
+  \file Threads.hh
+*/
+
+#ifndef SPATTER_THREADS_HH
+#define SPATTER_THREADS_HH
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Spatter {
+
+// Loop schedule of the OpenMP kernels, applied through schedule(runtime)
+enum class LoopSchedule { Static, Dynamic, Guided };
+
+struct Schedule {
+  LoopSchedule kind;
+  int chunk; // 0 for the runtime's default chunk
+};
+
+// By --schedule spec: "static", "static,N", "dynamic[,N]" or "guided[,N]".
+// false for others.
+bool parse_schedule(const std::string &spec, Schedule &schedule);
+
+// Schedule of the kernels run from now on, static by default
+void set_loop_schedule(const Schedule &schedule);
+const Schedule &loop_schedule();
+
+// How the OpenMP scatter-add kernel combines additions to the same index
+// (--accumulate):
+//   auto:    plain with one thread or if no index is added to twice, else
+//            private if a copy per thread fits the last-level cache, else
+//            atomic
+//   plain:   unsynchronized adds, which lose updates racing on an index
+//   atomic:  an omp atomic update per element
+//   private: per-thread copies of the sparse array, summed after each run
+enum class Accumulate { Auto, Plain, Atomic, Private };
+
+// By --accumulate name, false for others
+bool parse_accumulate(const std::string &name, Accumulate &mode);
+
+// Accumulation of the kernels run from now on, auto by default
+void set_accumulate(Accumulate mode);
+Accumulate accumulate();
+
+// By --affinity spec, the CPUs in the order threads take them:
+//   compact: fill the cores of one package before the next, hyperthread
+//            siblings next to each other
+//   scatter: round-robin over packages, then cores, siblings last
+//   list:C:  the CPUs in list C (e.g. 0-3,8,10)
+// Only CPUs in the process's affinity mask are used. false with a message
+// in err for invalid specs.
+bool affinity_cpus(
+    const std::string &spec, std::vector<int> &cpus, std::string &err);
+
+// CPUs threads are pinned to from now on, empty for no pinning
+void set_thread_affinity(const std::vector<int> &cpus);
+bool thread_affinity_enabled();
+
+// Pins the calling thread, OpenMP thread t, to CPU t of the affinity,
+// wrapping around when there are more threads than CPUs
+void pin_thread(int t);
+
+// CPU the calling thread runs on, -1 if unknown
+int current_cpu();
+
+// Barrier of a fixed number of threads that spins rather than sleeps, so
+// they leave it within a few cache line transfers of each other (--corun)
+class SpinBarrier {
+public:
+  explicit SpinBarrier(size_t threads) : threads_(threads) {}
+  void wait();
+
+private:
+  const size_t threads_;
+  std::atomic<size_t> waiting_{0};
+  std::atomic<size_t> generation_{0};
+};
+
+} // namespace Spatter
+
+#endif
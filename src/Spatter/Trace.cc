@@ -0,0 +1,133 @@
+/*!
+  \file Trace.cc
+*/
+
+#include "Trace.hh"
+
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace Spatter {
+
+namespace {
+
+// Addresses per chunk, as gz_read's NBUFS
+const size_t chunk_length = 1 << 18;
+
+} // namespace
+
+TraceReader::~TraceReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+
+  if (thread_.joinable())
+    thread_.join();
+  if (file_)
+    gzclose(file_);
+}
+
+bool TraceReader::open(
+    const std::string &file, size_t window, std::string &err) {
+  if (window == 0) {
+    err = "TRACE window must be at least 1";
+    return false;
+  }
+
+  file_ = gzopen(file.c_str(), "rb");
+  if (!file_) {
+    err = "Could not open trace " + file;
+    return false;
+  }
+  gzbuffer(file_, 1 << 20);
+
+  window_ = window;
+  for (std::vector<uint64_t> &chunk : chunks_)
+    chunk.resize(chunk_length);
+
+  thread_ = std::thread(&TraceReader::decode, this);
+  return true;
+}
+
+void TraceReader::decode() {
+  for (int c = 0;; c ^= 1) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] { return stop_ || !ready_[c]; });
+      if (stop_)
+        return;
+    }
+
+    // A trailing partial address is dropped like gz_read does
+    int bytes = gzread(file_, chunks_[c].data(),
+        static_cast<unsigned>(sizeof(uint64_t) * chunk_length));
+    size_t length = bytes > 0 ? static_cast<size_t>(bytes) / sizeof(uint64_t)
+                              : 0;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lengths_[c] = length;
+      ready_[c] = true;
+    }
+    cv_.notify_all();
+
+    if (length == 0)
+      return;
+  }
+}
+
+bool TraceReader::next(aligned_vector<size_t> &pattern, size_t &delta) {
+  if (end_ || !file_)
+    return false;
+
+  std::vector<uint64_t> addresses;
+  addresses.reserve(window_);
+
+  while (addresses.size() < window_) {
+    if (!started_ || position_ == lengths_[current_]) {
+      // Hand the consumed chunk back to the decoder and wait for the other
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (started_) {
+        ready_[current_] = false;
+        current_ ^= 1;
+        cv_.notify_all();
+      }
+      started_ = true;
+      cv_.wait(lock, [&] { return ready_[current_]; });
+      position_ = 0;
+
+      if (lengths_[current_] == 0) {
+        end_ = true;
+        break;
+      }
+    }
+
+    size_t take = std::min(window_ - addresses.size(),
+        lengths_[current_] - position_);
+    addresses.insert(addresses.end(), chunks_[current_].begin() + position_,
+        chunks_[current_].begin() + position_ + take);
+    position_ += take;
+  }
+
+  if (addresses.empty())
+    return false;
+
+  uint64_t base = *std::min_element(addresses.begin(), addresses.end());
+  base -= base % sizeof(double);
+
+  pattern.resize(addresses.size());
+  for (size_t j = 0; j < addresses.size(); ++j)
+    pattern[j] = static_cast<size_t>((addresses[j] - base) / sizeof(double));
+
+  delta = (windows_ > 0 && base >= base_)
+      ? static_cast<size_t>((base - base_) / sizeof(double))
+      : 0;
+  base_ = base;
+  ++windows_;
+  return true;
+}
+
+} // namespace Spatter
@@ -0,0 +1,74 @@
+/*!
+  \file Trace.hh
+*/
+
+#ifndef SPATTER_TRACE_HH
+#define SPATTER_TRACE_HH
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Configuration.hh"
+
+struct gzFile_s;
+
+namespace Spatter {
+
+// Streams a gzipped binary trace of 64-bit byte addresses (the .idx.gz
+// traces gz_read prints) as pattern windows for -p TRACE:<file>[:window].
+// A background thread decodes the next chunk while the current one is cut
+// into windows, so the trace is never held in memory whole.
+class TraceReader {
+public:
+  TraceReader() = default;
+  ~TraceReader();
+
+  TraceReader(const TraceReader &) = delete;
+  TraceReader &operator=(const TraceReader &) = delete;
+
+  // false with a message in err if file cannot be opened
+  bool open(const std::string &file, size_t window, std::string &err);
+
+  // The next window addresses as offsets in doubles from the lowest of them,
+  // and delta the distance in doubles from the previous window's lowest
+  // address (0 for the first window or one below it). The last window may
+  // be short. false at the end of the trace.
+  bool next(aligned_vector<size_t> &pattern, size_t &delta);
+
+  size_t window() const { return window_; }
+
+  // Windows returned so far
+  size_t windows() const { return windows_; }
+
+private:
+  // Body of the decoding thread
+  void decode();
+
+  gzFile_s *file_ = nullptr;
+  size_t window_ = 0;
+  size_t windows_ = 0;
+  uint64_t base_ = 0;
+
+  // Two chunks, one decoded into while the other is read. A ready chunk of
+  // length 0 marks the end of the trace.
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<uint64_t> chunks_[2];
+  size_t lengths_[2] = {0, 0};
+  bool ready_[2] = {false, false};
+  bool stop_ = false;
+
+  int current_ = 0;
+  size_t position_ = 0;
+  bool started_ = false;
+  bool end_ = false;
+};
+
+} // namespace Spatter
+
+#endif
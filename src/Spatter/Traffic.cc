@@ -0,0 +1,91 @@
+/*!
+  \file Traffic.cc
+*/
+
+#include "Traffic.hh"
+
+namespace Spatter {
+
+namespace {
+
+BandwidthModel model_ = BandwidthModel::Payload;
+
+} // namespace
+
+bool bandwidth_model(const std::string &name, BandwidthModel &model) {
+  if (name.compare("payload") == 0)
+    model = BandwidthModel::Payload;
+  else if (name.compare("rw") == 0)
+    model = BandwidthModel::ReadWrite;
+  else if (name.compare("full") == 0)
+    model = BandwidthModel::Full;
+  else
+    return false;
+  return true;
+}
+
+void set_bandwidth_model(BandwidthModel model) { model_ = model; }
+
+BandwidthModel bandwidth_model() { return model_; }
+
+size_t Traffic::bytes(BandwidthModel model) const {
+  switch (model) {
+  case BandwidthModel::Payload:
+    return payload;
+  case BandwidthModel::ReadWrite:
+    return reads + writes;
+  case BandwidthModel::Full:
+    return reads + writes + index;
+  }
+  return payload;
+}
+
+Traffic kernel_traffic(const std::string &kernel, size_t pattern_size,
+    size_t pattern_gather_size, size_t pattern_scatter_size, size_t count,
+    size_t element_size, size_t index_size) {
+  // Elements moved and indices read per run. The gather and scatter of gs
+  // each touch the sparse side, and the multi kernels read the inner
+  // pattern and then the outer one for every element.
+  size_t elements = 0, sparse = 0, indices = 0;
+  if (kernel.compare("gather-reduce") == 0 ||
+      kernel.compare("scatter-add") == 0) {
+    // One sum written per iteration, or the sparse targets read and written
+    // back along with the dense values
+    const size_t adds = pattern_size * count;
+    const bool reduces = kernel.compare("gather-reduce") == 0;
+    Traffic traffic;
+    traffic.payload = adds * element_size;
+    traffic.index = adds * index_size;
+    traffic.reads = (reduces ? adds : 2 * adds) * element_size;
+    traffic.writes = (reduces ? count : adds) * element_size;
+    return traffic;
+  }
+
+  if (kernel.compare("gather") == 0 || kernel.compare("scatter") == 0) {
+    elements = pattern_size * count;
+    sparse = elements;
+    indices = elements;
+  } else if (kernel.compare("gs") == 0) {
+    elements = pattern_gather_size * count;
+    sparse = (pattern_gather_size + pattern_scatter_size) * count;
+    indices = sparse;
+  } else if (kernel.compare("multigather") == 0) {
+    elements = pattern_gather_size * count;
+    sparse = elements;
+    indices = 2 * elements;
+  } else if (kernel.compare("multiscatter") == 0) {
+    elements = pattern_scatter_size * count;
+    sparse = elements;
+    indices = 2 * elements;
+  }
+
+  // Every element moved is read once and written once, dense side included
+  Traffic traffic;
+  traffic.payload = sparse * element_size;
+  traffic.index = indices * index_size;
+  traffic.reads = elements * element_size;
+  traffic.writes = elements * element_size;
+  return traffic;
+}
+
+} // namespace Spatter
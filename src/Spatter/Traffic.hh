@@ -0,0 +1,44 @@
+/*!
+  \file Traffic.hh
+*/
+
+#ifndef SPATTER_TRAFFIC_HH
+#define SPATTER_TRAFFIC_HH
+
+#include <cstddef>
+#include <string>
+
+namespace Spatter {
+
+// Which bytes the reported bandwidth counts (--bw-model)
+//   payload: the sparse-side elements gathered or scattered
+//   rw:      every element read plus every element written, as STREAM counts
+//   full:    rw plus the index reads
+enum class BandwidthModel { Payload, ReadWrite, Full };
+
+// By --bw-model name: "payload", "rw" or "full". false for others.
+bool bandwidth_model(const std::string &name, BandwidthModel &model);
+
+// Model of the reports from now on, payload by default
+void set_bandwidth_model(BandwidthModel model);
+BandwidthModel bandwidth_model();
+
+// Memory traffic of one run of a config, in bytes
+struct Traffic {
+  size_t payload = 0;
+  size_t index = 0;
+  size_t reads = 0;  // data elements read
+  size_t writes = 0; // data elements written
+
+  size_t bytes(BandwidthModel model) const;
+};
+
+// Traffic of one run of kernel, moving elements of element_size bytes
+// through indices of index_size bytes
+Traffic kernel_traffic(const std::string &kernel, size_t pattern_size,
+    size_t pattern_gather_size, size_t pattern_scatter_size, size_t count,
+    size_t element_size, size_t index_size);
+
+} // namespace Spatter
+
+#endif
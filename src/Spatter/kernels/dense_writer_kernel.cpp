@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include "dataflow_api.h"
+#include "spatter_elem.h"
+
+/*
+ * Dense Writer Kernel for Spatter TensTorrent Backend (Multi-Core, RISCV_1)
+ *
+ * Drains tiles produced by gather_reader_kernel from c_1 and writes them to
+ * consecutive tiles of the dense buffer over NOC1, so the write-back of one
+ * tile overlaps the reader gathering the next.
+ *
+ * Runtime Args:
+ * - arg0: start_element - Starting element index for this core (tile aligned)
+ * - arg1: num_elements_per_core - Number of elements this core should process
+ * - arg2: dense_addr - Destination buffer address (DRAM)
+ */
+
+void kernel_main() {
+    uint32_t start_element = get_arg_val<uint32_t>(0);
+    uint32_t num_elements_per_core = get_arg_val<uint32_t>(1);
+    uint32_t dense_addr = get_arg_val<uint32_t>(2);
+
+    // Tile constants, sized by ELEM_BYTES
+    const uint32_t tile_size_bytes = TILE_SIZE_BYTES;
+    const uint32_t elements_per_tile = ELEMENTS_PER_TILE;
+
+    constexpr uint32_t cb_in = tt::CBIndex::c_1;
+
+    constexpr auto dense_args = TensorAccessorArgs<0>();
+    const auto dense_accessor = TensorAccessor(dense_args, dense_addr, tile_size_bytes);
+
+    uint32_t end_element = start_element + num_elements_per_core;
+    uint32_t start_tile = start_element / elements_per_tile;
+    uint32_t end_tile = (end_element + elements_per_tile - 1) / elements_per_tile;
+
+    for (uint32_t out_tile_idx = start_tile; out_tile_idx < end_tile; out_tile_idx++) {
+        cb_wait_front(cb_in, 1);
+        noc_async_write_tile(out_tile_idx, dense_accessor, get_read_ptr(cb_in));
+        // The slot may be released once the data has left L1
+        noc_async_writes_flushed();
+        cb_pop_front(cb_in, 1);
+    }
+
+    noc_async_write_barrier();
+}
@@ -0,0 +1,264 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include "dataflow_api.h"
+#include "spatter_elem.h"
+#include "spatter_pattern.h"
+#include "spatter_tile_cache.h"
+#include "debug/dprint.h"  // required in all kernels using DPRINT
+
+/*
+ * Gather Reader Kernel for Spatter TensTorrent Backend (Multi-Core, RISCV_0)
+ *
+ * Produces: out[i] = sparse[pattern[i % pattern_length] + delta * (i / pattern_length)]
+ * one tile at a time into c_1, for a writer kernel on RISCV_1 to consume.
+ * Used by gather (with dense_writer_kernel) and gs (with scatter_writer_kernel).
+ *
+ * Each core owns a contiguous range of whole output tiles. For every output
+ * tile the kernel scans ahead to find the distinct sparse tiles it needs,
+ * issues them into a ring of NUM_SPARSE_SLOTS L1 slots (c_0) with all reads
+ * in flight, waits once, then copies the covered elements. The host sizes
+ * the ring from the L1 the other circular buffers leave free.
+ *
+ * The pattern is read through NUM_GATHER_PATTERN_SLOTS tiles in c_3, see
+ * spatter_pattern.h, so it may be any length.
+ *
+ * With ELEMENT_LIST defined, output position i holds element list[i] instead
+ * of element i, where list is the tile ownership order built by the host for
+ * scatter_writer_kernel (read through c_5). With DIRECT_SOURCE defined, element
+ * j reads sparse[j] without a pattern, which scatter uses to stream dense.
+ *
+ * With PERMUTED_OUTPUT defined as well, the list is a permutation within
+ * each block of OUTPUT_BLOCK_TILES output tiles that orders the block by
+ * source tile (built by the host for tile-sorted gather). The block is filled
+ * in list order and element list[i] lands at its own output position, so each
+ * distinct sparse tile is fetched once per block.
+ *
+ * With AFFINE_PATTERN defined the pattern is pattern[i] = PATTERN_BASE +
+ * PATTERN_STRIDE * i, baked in with its length and delta instead of read from
+ * DRAM. With CONTIGUOUS_SOURCE defined, output tile t is source tile
+ * SOURCE_BASE_TILE + t and is read straight into the output slot; the host
+ * only sets it when every core starts on a tile boundary.
+ *
+ * Runtime Args:
+ * - arg0: start_element - Starting output position for this core (tile
+ *         aligned unless ELEMENT_LIST)
+ * - arg1: num_elements_per_core - Number of elements this core should process
+ * - arg2: delta - Stride between pattern iterations
+ * - arg3: pattern_length - Length of the pattern array
+ * - arg4: sparse_addr - Source buffer address (DRAM)
+ * - arg5: pattern_addr - Pattern buffer address (DRAM)
+ * - arg6: list_addr - Element list address (DRAM, ELEMENT_LIST only)
+ * - next: stats_addr, stats_page - Cache stats buffer and this core's page
+ *         in it (CACHE_STATS only), see write_cache_stats()
+ */
+
+void kernel_main() {
+    uint32_t start_element = get_arg_val<uint32_t>(0);
+    uint32_t num_elements_per_core = get_arg_val<uint32_t>(1);
+    uint32_t delta = get_arg_val<uint32_t>(2);
+    uint32_t pattern_length = get_arg_val<uint32_t>(3);
+    uint32_t sparse_addr = get_arg_val<uint32_t>(4);
+    uint32_t pattern_addr = get_arg_val<uint32_t>(5);
+#ifdef ELEMENT_LIST
+    uint32_t list_addr = get_arg_val<uint32_t>(6);
+#endif
+#ifdef CACHE_STATS
+#ifdef ELEMENT_LIST
+    constexpr uint32_t stats_arg = 7;
+#else
+    constexpr uint32_t stats_arg = 6;
+#endif
+    uint32_t stats_addr = get_arg_val<uint32_t>(stats_arg);
+    uint32_t stats_page = get_arg_val<uint32_t>(stats_arg + 1);
+#endif
+
+    // Tile constants, sized by ELEM_BYTES
+    const uint32_t tile_size_bytes = TILE_SIZE_BYTES;
+    const uint32_t elements_per_tile = ELEMENTS_PER_TILE;
+
+    constexpr uint32_t num_slots = NUM_SPARSE_SLOTS;
+    constexpr uint32_t cb_sparse = tt::CBIndex::c_0;
+    constexpr uint32_t cb_out = tt::CBIndex::c_1;
+    constexpr uint32_t cb_pattern = tt::CBIndex::c_3;
+    constexpr uint32_t cb_list = tt::CBIndex::c_5;
+    static_assert(num_slots > 0 && num_slots < 32, "slot mask is a uint32_t");
+#ifdef PERMUTED_OUTPUT
+    constexpr uint32_t tiles_per_step = OUTPUT_BLOCK_TILES;
+#else
+    constexpr uint32_t tiles_per_step = 1;
+#endif
+    const uint32_t elements_per_step = tiles_per_step * elements_per_tile;
+
+    // Create TensorAccessors for the sparse, pattern and list buffers
+    constexpr auto sparse_args = TensorAccessorArgs<0>();
+    const auto sparse_accessor = TensorAccessor(sparse_args, sparse_addr, tile_size_bytes);
+
+    constexpr auto pattern_args = TensorAccessorArgs<sparse_args.next_compile_time_args_offset()>();
+    const auto pattern_accessor = TensorAccessor(pattern_args, pattern_addr, tile_size_bytes);
+
+    // Pattern and list tiles are loaded on first use, the slots are per-core
+    // L1 scratch with no push/pop
+#if !defined(DIRECT_SOURCE) && !defined(AFFINE_PATTERN)
+    PatternTileCache<NUM_GATHER_PATTERN_SLOTS, decltype(pattern_accessor)> pattern_data(
+        pattern_accessor, get_write_ptr(cb_pattern));
+#endif
+#ifdef ELEMENT_LIST
+    constexpr auto list_args = TensorAccessorArgs<pattern_args.next_compile_time_args_offset()>();
+    const auto list_accessor = TensorAccessor(list_args, list_addr, tile_size_bytes);
+    PatternTileCache<ELEMENT_LIST_SLOTS, decltype(list_accessor)> element_list(
+        list_accessor, get_write_ptr(cb_list));
+#endif
+#ifdef CACHE_STATS
+#ifdef ELEMENT_LIST
+    constexpr auto stats_args = TensorAccessorArgs<list_args.next_compile_time_args_offset()>();
+#else
+    constexpr auto stats_args = TensorAccessorArgs<pattern_args.next_compile_time_args_offset()>();
+#endif
+    const auto stats_accessor = TensorAccessor(stats_args, stats_addr, CACHE_STATS_PAGE_BYTES);
+#endif
+
+    // Sparse index read for output position pos
+    auto source_index = [&](uint32_t pos) -> uint32_t {
+#ifdef ELEMENT_LIST
+        uint32_t elem = element_list[pos];
+#else
+        uint32_t elem = pos;
+#endif
+#if defined(DIRECT_SOURCE)
+        return elem;
+#elif defined(AFFINE_PATTERN)
+        return PATTERN_BASE + PATTERN_STRIDE * (elem % PATTERN_LENGTH) +
+            PATTERN_DELTA * (elem / PATTERN_LENGTH);
+#else
+        return pattern_data[elem % pattern_length] + delta * (elem / pattern_length);
+#endif
+    };
+
+    // Offset in the current output step that position pos is written to
+    auto output_offset = [&](uint32_t pos, uint32_t step_start) -> uint32_t {
+#ifdef PERMUTED_OUTPUT
+        return element_list[pos] - step_start;
+#else
+        return pos - step_start;
+#endif
+    };
+
+    // The sparse slot ring is only used as per-core L1 scratch, no push/pop
+    uint32_t sparse_base = get_write_ptr(cb_sparse);
+
+    // Sparse tile resident in each slot, persists across batches and tiles
+    uint32_t slot_tile[num_slots];
+    for (uint32_t s = 0; s < num_slots; s++) {
+        slot_tile[s] = UINT32_MAX;
+    }
+    uint32_t next_victim = 0;
+    // Consecutive elements mostly share a tile, so try the last slot first
+    uint32_t last_slot = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+    auto find_slot = [&](uint32_t tile) -> uint32_t {
+        if (slot_tile[last_slot] == tile) {
+            return last_slot;
+        }
+        for (uint32_t s = 0; s < num_slots; s++) {
+            if (slot_tile[s] == tile) {
+                return s;
+            }
+        }
+        return num_slots;
+    };
+
+    uint32_t end_element = start_element + num_elements_per_core;
+
+    for (uint32_t tile_start = start_element; tile_start < end_element;
+         tile_start += elements_per_step) {
+        uint32_t tile_end = tile_start + elements_per_step;
+        if (tile_end > end_element) {
+            tile_end = end_element;
+        }
+        uint32_t num_tiles = (tile_end - tile_start + elements_per_tile - 1) / elements_per_tile;
+
+        // Wait for the writer to free slots in the output buffer
+        cb_reserve_back(cb_out, num_tiles);
+        elem_t* dense_data = reinterpret_cast<elem_t*>(get_write_ptr(cb_out));
+
+#ifdef CONTIGUOUS_SOURCE
+        // One NOC burst per tile, no per-element copy
+        noc_async_read_tile(SOURCE_BASE_TILE + tile_start / elements_per_tile,
+            sparse_accessor, get_write_ptr(cb_out));
+        noc_async_read_barrier();
+        misses++;
+#endif
+
+        // Only the final partial tile has elements nobody writes
+        for (uint32_t i = tile_end - tile_start; i < num_tiles * elements_per_tile; i++) {
+            dense_data[i] = elem_t{};
+        }
+
+#ifndef CONTIGUOUS_SOURCE
+        uint32_t elem_idx = tile_start;
+        while (elem_idx < tile_end) {
+            // Phase 1: issue reads for the distinct sparse tiles needed by the
+            // upcoming elements until every slot is pinned by this batch
+            uint32_t pinned = 0;  // bitmask of slots used by this batch
+            uint32_t batch_end = elem_idx;
+            while (batch_end < tile_end) {
+                uint32_t src_index = source_index(batch_end);
+                uint32_t src_tile_idx = src_index / elements_per_tile;
+
+                uint32_t slot = find_slot(src_tile_idx);
+
+                if (slot == num_slots) {
+                    if (pinned == (1u << num_slots) - 1) {
+                        break;
+                    }
+                    while (pinned & (1u << next_victim)) {
+                        next_victim = (next_victim + 1) % num_slots;
+                    }
+                    slot = next_victim;
+                    next_victim = (next_victim + 1) % num_slots;
+
+                    noc_async_read_tile(src_tile_idx, sparse_accessor,
+                        sparse_base + slot * tile_size_bytes);
+                    slot_tile[slot] = src_tile_idx;
+                    misses++;
+                } else {
+                    hits++;
+                }
+
+                last_slot = slot;
+                pinned |= 1u << slot;
+                batch_end++;
+            }
+
+            noc_async_read_barrier();
+
+            // Phase 2: copy the elements covered by the resident slots
+            for (; elem_idx < batch_end; elem_idx++) {
+                uint32_t src_index = source_index(elem_idx);
+                uint32_t src_tile_idx = src_index / elements_per_tile;
+
+                uint32_t slot = find_slot(src_tile_idx);
+                last_slot = slot;
+
+                elem_t* sparse_data = reinterpret_cast<elem_t*>(
+                    sparse_base + slot * tile_size_bytes);
+                dense_data[output_offset(elem_idx, tile_start)] =
+                    sparse_data[src_index % elements_per_tile];
+            }
+        }
+#endif
+
+        // Hand the completed tiles to the writer
+        cb_push_back(cb_out, num_tiles);
+    }
+
+#ifdef CACHE_STATS
+    // All reads have landed, so slot 0 is free to stage the counters
+    write_cache_stats(stats_accessor, stats_page, sparse_base, hits, misses);
+#endif
+}
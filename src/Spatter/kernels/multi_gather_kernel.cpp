@@ -3,6 +3,8 @@
 
 #include <cstdint>
 #include "dataflow_api.h"
+#include "spatter_elem.h"
+#include "spatter_tile_cache.h"
 #include "debug/dprint.h"
 
 /*
@@ -14,10 +16,13 @@
  * 1. pattern_gather[j] gives an index into the pattern array
  * 2. pattern[pattern_gather[j]] gives the actual sparse array index
  * 
+ * Sparse tiles are read through a SparseTileCache of NUM_SPARSE_SLOTS tiles
+ * in c_0, see spatter_tile_cache.h.
+ * 
  * Runtime Args:
  * - arg0: pattern_l1_addr - Pattern L1 buffer address
  * - arg1: pattern_gather_l1_addr - Pattern gather L1 buffer address (first indirection)
- * - arg2: sparse_l1_addr - Sparse L1 buffer address (source)
+ * - arg2: reserved (sparse tiles are cached in c_0)
  * - arg3: dense_l1_addr - Dense L1 buffer address (destination)
  * - arg4: start_element - Starting element index for this core
  * - arg5: end_element - Ending element index for this core
@@ -30,13 +35,14 @@
  * - arg12: pattern_gather_addr - Pattern gather buffer address (DRAM)
  * - arg13: sparse_addr - Sparse buffer address (DRAM)
  * - arg14: dense_addr - Dense buffer address (DRAM)
+ * - arg15: stats_addr - Cache stats buffer address (CACHE_STATS only)
+ * - arg16: stats_page - This core's page in the stats buffer (CACHE_STATS only)
  */
 
 void kernel_main() {
     // Read runtime arguments - four separate L1 buffers
     uint32_t pattern_l1_addr = get_arg_val<uint32_t>(0);
     uint32_t pattern_gather_l1_addr = get_arg_val<uint32_t>(1);
-    uint32_t sparse_l1_addr = get_arg_val<uint32_t>(2);
     uint32_t dense_l1_addr = get_arg_val<uint32_t>(3);
     uint32_t start_element = get_arg_val<uint32_t>(4);
     uint32_t end_element = get_arg_val<uint32_t>(5);
@@ -49,15 +55,19 @@ void kernel_main() {
     uint32_t pattern_gather_addr = get_arg_val<uint32_t>(12);
     uint32_t sparse_addr = get_arg_val<uint32_t>(13);
     uint32_t dense_addr = get_arg_val<uint32_t>(14);
+#ifdef CACHE_STATS
+    uint32_t stats_addr = get_arg_val<uint32_t>(15);
+    uint32_t stats_page = get_arg_val<uint32_t>(16);
+#endif
 
     // Early exit if no work to do
     if (start_element >= end_element) {
         return;
     }
 
-    // Tile constants
-    const uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-    const uint32_t elements_per_tile = 32 * 32;    // 1024 elements per tile
+    // Tile constants, sized by ELEM_BYTES
+    const uint32_t tile_size_bytes = TILE_SIZE_BYTES;
+    const uint32_t elements_per_tile = ELEMENTS_PER_TILE;
 
     // Create TensorAccessors for all four buffers
     constexpr auto pattern_args = TensorAccessorArgs<0>();
@@ -71,11 +81,18 @@ void kernel_main() {
     
     constexpr auto dense_args = TensorAccessorArgs<sparse_args.next_compile_time_args_offset()>();
     const auto dense_accessor = TensorAccessor(dense_args, dense_addr, tile_size_bytes);
+#ifdef CACHE_STATS
+    constexpr auto stats_args = TensorAccessorArgs<dense_args.next_compile_time_args_offset()>();
+    const auto stats_accessor = TensorAccessor(stats_args, stats_addr, CACHE_STATS_PAGE_BYTES);
+#endif
+
+    // The cache slots are per-core L1 scratch with no push/pop
+    SparseTileCache<NUM_SPARSE_SLOTS, decltype(sparse_accessor)> sparse_data(
+        sparse_accessor, get_write_ptr(tt::CBIndex::c_0));
 
     // Track cached tiles to avoid redundant loads
     uint32_t cached_pattern_gather_tile = UINT32_MAX;
     uint32_t cached_pattern_tile = UINT32_MAX;
-    uint32_t cached_sparse_tile = UINT32_MAX;
     uint32_t cached_dense_tile = UINT32_MAX;
 
     // Process elements assigned to this core
@@ -88,7 +105,7 @@ void kernel_main() {
         uint32_t pattern_idx = j % pattern_length;
         
         // Step 1: Load pattern_gather tile if needed
-        uint32_t pattern_gather_tile_id = pattern_idx / elements_per_tile;
+        uint32_t pattern_gather_tile_id = pattern_idx / PATTERN_INDICES_PER_TILE;
         if (pattern_gather_tile_id != cached_pattern_gather_tile) {
             noc_async_read_tile(pattern_gather_tile_id, pattern_gather_accessor, pattern_gather_l1_addr);
             noc_async_read_barrier();
@@ -97,14 +114,14 @@ void kernel_main() {
         
         // Step 2: Get first indirection - pattern_gather[j] gives index into pattern array
         uint32_t* pattern_gather_data = reinterpret_cast<uint32_t*>(pattern_gather_l1_addr);
-        uint32_t pattern_gather_elem_offset = pattern_idx % elements_per_tile;
+        uint32_t pattern_gather_elem_offset = pattern_idx % PATTERN_INDICES_PER_TILE;
         uint32_t first_indirection_idx = pattern_gather_data[pattern_gather_elem_offset];
         
         // No bounds check - pattern_gather values must be valid indices into pattern
         // This is enforced by host-side validation
         
         // Step 3: Load pattern tile containing pattern[first_indirection_idx]
-        uint32_t pattern_tile_id = first_indirection_idx / elements_per_tile;
+        uint32_t pattern_tile_id = first_indirection_idx / PATTERN_INDICES_PER_TILE;
         if (pattern_tile_id != cached_pattern_tile) {
             noc_async_read_tile(pattern_tile_id, pattern_accessor, pattern_l1_addr);
             noc_async_read_barrier();
@@ -113,23 +130,14 @@ void kernel_main() {
         
         // Step 4: Get second indirection - pattern[pattern_gather[j]]
         uint32_t* pattern_data = reinterpret_cast<uint32_t*>(pattern_l1_addr);
-        uint32_t pattern_elem_offset = first_indirection_idx % elements_per_tile;
+        uint32_t pattern_elem_offset = first_indirection_idx % PATTERN_INDICES_PER_TILE;
         uint32_t sparse_base_idx = pattern_data[pattern_elem_offset];
         
         // Step 5: Calculate final sparse index with delta
         uint32_t sparse_idx = (sparse_base_idx + delta * i) % sparse_size_elements;
         
-        // Step 6: Load sparse tile and read value
-        uint32_t sparse_tile_id = sparse_idx / elements_per_tile;
-        if (sparse_tile_id != cached_sparse_tile) {
-            noc_async_read_tile(sparse_tile_id, sparse_accessor, sparse_l1_addr);
-            noc_async_read_barrier();
-            cached_sparse_tile = sparse_tile_id;
-        }
-        
-        uint16_t* sparse_data = reinterpret_cast<uint16_t*>(sparse_l1_addr);
-        uint32_t sparse_elem_offset = sparse_idx % elements_per_tile;
-        uint16_t value = sparse_data[sparse_elem_offset];
+        // Step 6: Read the value through the sparse tile cache
+        elem_t value = sparse_data[sparse_idx];
         
         // Step 7: Calculate dense index with wrap
         uint32_t dense_idx = j + pattern_length * (i % wrap);
@@ -150,7 +158,7 @@ void kernel_main() {
         }
         
         // Step 9: Write value to dense buffer
-        uint16_t* dense_data = reinterpret_cast<uint16_t*>(dense_l1_addr);
+        elem_t* dense_data = reinterpret_cast<elem_t*>(dense_l1_addr);
         uint32_t dense_elem_offset = dense_idx % elements_per_tile;
         dense_data[dense_elem_offset] = value;
     }
@@ -162,4 +170,9 @@ void kernel_main() {
     }
     
     noc_async_writes_flushed();
+
+#ifdef CACHE_STATS
+    write_cache_stats(stats_accessor, stats_page, sparse_data.l1_base(),
+        sparse_data.hits(), sparse_data.misses());
+#endif
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include "dataflow_api.h"
+#include "spatter_elem.h"
 #include "debug/dprint.h"
 
 /*
@@ -55,9 +56,9 @@ void kernel_main() {
         return;
     }
 
-    // Tile constants
-    const uint32_t tile_size_bytes = 32 * 32 * 2;  // 2048 bytes per tile
-    const uint32_t elements_per_tile = 32 * 32;    // 1024 elements per tile
+    // Tile constants, sized by ELEM_BYTES
+    const uint32_t tile_size_bytes = TILE_SIZE_BYTES;
+    const uint32_t elements_per_tile = ELEMENTS_PER_TILE;
 
     // Create TensorAccessors for all four buffers
     constexpr auto pattern_args = TensorAccessorArgs<0>();
@@ -98,12 +99,12 @@ void kernel_main() {
         }
         
         // Step 2: Read value from dense buffer
-        uint16_t* dense_data = reinterpret_cast<uint16_t*>(dense_l1_addr);
+        elem_t* dense_data = reinterpret_cast<elem_t*>(dense_l1_addr);
         uint32_t dense_elem_offset = dense_idx % elements_per_tile;
-        uint16_t value = dense_data[dense_elem_offset];
+        elem_t value = dense_data[dense_elem_offset];
         
         // Step 3: Load pattern_scatter tile if needed
-        uint32_t pattern_scatter_tile_id = pattern_idx / elements_per_tile;
+        uint32_t pattern_scatter_tile_id = pattern_idx / PATTERN_INDICES_PER_TILE;
         if (pattern_scatter_tile_id != cached_pattern_scatter_tile) {
             noc_async_read_tile(pattern_scatter_tile_id, pattern_scatter_accessor, pattern_scatter_l1_addr);
             noc_async_read_barrier();
@@ -112,14 +113,14 @@ void kernel_main() {
         
         // Step 4: Get first indirection - pattern_scatter[j] gives index into pattern array
         uint32_t* pattern_scatter_data = reinterpret_cast<uint32_t*>(pattern_scatter_l1_addr);
-        uint32_t pattern_scatter_elem_offset = pattern_idx % elements_per_tile;
+        uint32_t pattern_scatter_elem_offset = pattern_idx % PATTERN_INDICES_PER_TILE;
         uint32_t first_indirection_idx = pattern_scatter_data[pattern_scatter_elem_offset];
         
         // Bounds check for first indirection
         first_indirection_idx = first_indirection_idx % pattern_length;
         
         // Step 5: Load pattern tile containing pattern[first_indirection_idx]
-        uint32_t pattern_tile_id = first_indirection_idx / elements_per_tile;
+        uint32_t pattern_tile_id = first_indirection_idx / PATTERN_INDICES_PER_TILE;
         if (pattern_tile_id != cached_pattern_tile) {
             noc_async_read_tile(pattern_tile_id, pattern_accessor, pattern_l1_addr);
             noc_async_read_barrier();
@@ -128,7 +129,7 @@ void kernel_main() {
         
         // Step 6: Get second indirection - pattern[pattern_scatter[j]]
         uint32_t* pattern_data = reinterpret_cast<uint32_t*>(pattern_l1_addr);
-        uint32_t pattern_elem_offset = first_indirection_idx % elements_per_tile;
+        uint32_t pattern_elem_offset = first_indirection_idx % PATTERN_INDICES_PER_TILE;
         uint32_t sparse_base_idx = pattern_data[pattern_elem_offset];
         
         // Step 7: Calculate final sparse index with delta
@@ -150,7 +151,7 @@ void kernel_main() {
         }
         
         // Step 9: Write value to sparse buffer
-        uint16_t* sparse_data = reinterpret_cast<uint16_t*>(sparse_l1_addr);
+        elem_t* sparse_data = reinterpret_cast<elem_t*>(sparse_l1_addr);
         uint32_t sparse_elem_offset = sparse_idx % elements_per_tile;
         sparse_data[sparse_elem_offset] = value;
     }
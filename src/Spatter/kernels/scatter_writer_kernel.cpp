@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include "dataflow_api.h"
+#include "spatter_elem.h"
+#include "spatter_pattern.h"
+
+/*
+ * Scatter Writer Kernel for Spatter TensTorrent Backend (Multi-Core, RISCV_1)
+ *
+ * Implements: sparse[pattern[j % pattern_length] + delta * (j / pattern_length)] = in[j]
+ * where in[] arrives one tile at a time in c_1 from gather_reader_kernel on
+ * RISCV_0. Used by scatter and gs.
+ *
+ * Destination tiles are updated read-modify-write in the c_2 scratch tile
+ * over NOC1, while the reader fetches the next input tile over NOC0.
+ *
+ * The pattern is read through NUM_SCATTER_PATTERN_SLOTS tiles in c_4, see
+ * spatter_pattern.h, so it may be any length.
+ *
+ * With ELEMENT_LIST defined, input position i holds element list[i] (read
+ * through c_6). The host groups the list by destination tile and gives each
+ * tile to exactly one core, so cores never write back the same tile and each
+ * tile is read and written once per core range.
+ *
+ * With AFFINE_PATTERN defined the pattern is pattern[i] = PATTERN_BASE +
+ * PATTERN_STRIDE * i, baked in with its length and delta instead of read from
+ * DRAM. With CONTIGUOUS_PATTERN, input tile t fills sparse tile
+ * PATTERN_BASE / 1024 + t, so whole tiles are written without the
+ * read-modify-write.
+ *
+ * Runtime Args:
+ * - arg0: start_element - Starting input position for this core (tile
+ *         aligned unless ELEMENT_LIST)
+ * - arg1: num_elements_per_core - Number of elements this core should process
+ * - arg2: delta - Stride between pattern iterations
+ * - arg3: pattern_length - Length of the pattern array
+ * - arg4: sparse_addr - Destination buffer address (DRAM)
+ * - arg5: pattern_addr - Pattern buffer address (DRAM)
+ * - arg6: list_addr - Element list address (DRAM, ELEMENT_LIST only)
+ */
+
+void kernel_main() {
+    uint32_t start_element = get_arg_val<uint32_t>(0);
+    uint32_t num_elements_per_core = get_arg_val<uint32_t>(1);
+    uint32_t delta = get_arg_val<uint32_t>(2);
+    uint32_t pattern_length = get_arg_val<uint32_t>(3);
+    uint32_t sparse_addr = get_arg_val<uint32_t>(4);
+    uint32_t pattern_addr = get_arg_val<uint32_t>(5);
+#ifdef ELEMENT_LIST
+    uint32_t list_addr = get_arg_val<uint32_t>(6);
+#endif
+
+    // Tile constants, sized by ELEM_BYTES
+    const uint32_t tile_size_bytes = TILE_SIZE_BYTES;
+    const uint32_t elements_per_tile = ELEMENTS_PER_TILE;
+
+    constexpr uint32_t cb_in = tt::CBIndex::c_1;
+    constexpr uint32_t cb_scratch = tt::CBIndex::c_2;
+    constexpr uint32_t cb_pattern = tt::CBIndex::c_4;
+    constexpr uint32_t cb_list = tt::CBIndex::c_6;
+
+    // Create TensorAccessors for the sparse, pattern and list buffers
+    constexpr auto sparse_args = TensorAccessorArgs<0>();
+    const auto sparse_accessor = TensorAccessor(sparse_args, sparse_addr, tile_size_bytes);
+
+    constexpr auto pattern_args = TensorAccessorArgs<sparse_args.next_compile_time_args_offset()>();
+    const auto pattern_accessor = TensorAccessor(pattern_args, pattern_addr, tile_size_bytes);
+
+    // Pattern and list tiles are loaded on first use, the slots are per-core
+    // L1 scratch with no push/pop
+#ifndef AFFINE_PATTERN
+    PatternTileCache<NUM_SCATTER_PATTERN_SLOTS, decltype(pattern_accessor)> pattern_data(
+        pattern_accessor, get_write_ptr(cb_pattern));
+#endif
+#ifdef ELEMENT_LIST
+    constexpr auto list_args = TensorAccessorArgs<pattern_args.next_compile_time_args_offset()>();
+    const auto list_accessor = TensorAccessor(list_args, list_addr, tile_size_bytes);
+    PatternTileCache<ELEMENT_LIST_SLOTS, decltype(list_accessor)> element_list(
+        list_accessor, get_write_ptr(cb_list));
+#endif
+
+    // The scratch buffer is only used as per-core L1 scratch, no push/pop
+    uint32_t sparse_l1_addr = get_write_ptr(cb_scratch);
+    elem_t* sparse_data = reinterpret_cast<elem_t*>(sparse_l1_addr);
+
+    uint32_t end_element = start_element + num_elements_per_core;
+
+    // Track the last loaded sparse tile to avoid redundant loads
+    uint32_t last_sparse_tile = UINT32_MAX;
+
+    for (uint32_t tile_start = start_element; tile_start < end_element;
+         tile_start += elements_per_tile) {
+        uint32_t tile_end = tile_start + elements_per_tile;
+        if (tile_end > end_element) {
+            tile_end = end_element;
+        }
+
+        cb_wait_front(cb_in, 1);
+        elem_t* in_data = reinterpret_cast<elem_t*>(get_read_ptr(cb_in));
+
+#ifdef CONTIGUOUS_PATTERN
+        // A whole aligned input tile is exactly one destination tile
+        if (tile_start % elements_per_tile == 0 && tile_end - tile_start == elements_per_tile) {
+            noc_async_write_tile(PATTERN_BASE / elements_per_tile + tile_start / elements_per_tile,
+                sparse_accessor, get_read_ptr(cb_in));
+            noc_async_writes_flushed();
+            cb_pop_front(cb_in, 1);
+            continue;
+        }
+#endif
+
+        for (uint32_t elem_idx = tile_start; elem_idx < tile_end; elem_idx++) {
+#ifdef ELEMENT_LIST
+            uint32_t elem = element_list[elem_idx];
+#else
+            uint32_t elem = elem_idx;
+#endif
+#ifdef AFFINE_PATTERN
+            uint32_t dst_index = PATTERN_BASE + PATTERN_STRIDE * (elem % PATTERN_LENGTH) +
+                PATTERN_DELTA * (elem / PATTERN_LENGTH);
+#else
+            uint32_t dst_index = pattern_data[elem % pattern_length] +
+                delta * (elem / pattern_length);
+#endif
+            uint32_t dst_tile_idx = dst_index / elements_per_tile;
+
+            if (dst_tile_idx != last_sparse_tile) {
+                // Write back the previously modified tile; it must land before
+                // it can be read again
+                if (last_sparse_tile != UINT32_MAX) {
+                    noc_async_write_tile(last_sparse_tile, sparse_accessor, sparse_l1_addr);
+                    noc_async_write_barrier();
+                }
+
+                noc_async_read_tile(dst_tile_idx, sparse_accessor, sparse_l1_addr);
+                noc_async_read_barrier();
+                last_sparse_tile = dst_tile_idx;
+            }
+
+            sparse_data[dst_index % elements_per_tile] = in_data[elem_idx - tile_start];
+        }
+
+        cb_pop_front(cb_in, 1);
+    }
+
+    // Write back the last modified sparse tile
+    if (last_sparse_tile != UINT32_MAX) {
+        noc_async_write_tile(last_sparse_tile, sparse_accessor, sparse_l1_addr);
+    }
+    noc_async_write_barrier();
+}
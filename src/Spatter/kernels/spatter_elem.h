@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Element type moved by the Spatter data-movement kernels.
+ *
+ * The host selects it with --tt-dtype and passes its size in as the
+ * ELEM_BYTES define. The kernels only copy elements, so fp32 and u32 share
+ * a 32-bit type and u64 is carried as two u32 words.
+ */
+
+#ifndef ELEM_BYTES
+#define ELEM_BYTES 2
+#endif
+
+#if ELEM_BYTES == 2
+typedef uint16_t elem_t;  // bfloat16
+#elif ELEM_BYTES == 4
+typedef uint32_t elem_t;  // fp32, u32
+#elif ELEM_BYTES == 8
+struct elem_t {           // u64 as 2 x u32
+    uint32_t lo;
+    uint32_t hi;
+};
+#else
+#error "Unsupported ELEM_BYTES"
+#endif
+
+// A tile is always 32x32 elements; pattern tiles hold uint32_t indices
+constexpr uint32_t ELEMENTS_PER_TILE = 32 * 32;
+constexpr uint32_t TILE_SIZE_BYTES = ELEMENTS_PER_TILE * ELEM_BYTES;
+constexpr uint32_t PATTERN_INDICES_PER_TILE = TILE_SIZE_BYTES / sizeof(uint32_t);
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include "dataflow_api.h"
+#include "spatter_elem.h"
+
+/*
+ * Direct-mapped cache of pattern tiles in a per-core circular buffer.
+ *
+ * Pattern tile t lives in slot t % num_slots. The host sizes num_slots to the
+ * whole pattern when it fits in L1, so every tile stays resident after its
+ * first use. Longer patterns stream through the slots in order, which is
+ * cheap because consecutive elements read consecutive pattern indices.
+ */
+template <uint32_t num_slots, typename Accessor>
+class PatternTileCache {
+public:
+    PatternTileCache(const Accessor& accessor, uint32_t l1_base)
+        : accessor_(accessor), l1_base_(l1_base) {
+        for (uint32_t s = 0; s < num_slots; s++) {
+            slot_tile_[s] = UINT32_MAX;
+        }
+    }
+
+    uint32_t operator[](uint32_t idx) {
+        uint32_t tile = idx / PATTERN_INDICES_PER_TILE;
+        uint32_t slot = tile % num_slots;
+        uint32_t slot_addr = l1_base_ + slot * TILE_SIZE_BYTES;
+
+        if (slot_tile_[slot] != tile) {
+            noc_async_read_tile(tile, accessor_, slot_addr);
+            noc_async_read_barrier();
+            slot_tile_[slot] = tile;
+        }
+
+        return reinterpret_cast<uint32_t*>(slot_addr)[idx % PATTERN_INDICES_PER_TILE];
+    }
+
+private:
+    const Accessor& accessor_;
+    uint32_t l1_base_;
+    uint32_t slot_tile_[num_slots];
+};
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: © 2025 Spatter Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include "dataflow_api.h"
+#include "spatter_elem.h"
+
+// Bytes per core in the cache stats buffer, set by the host with CACHE_STATS
+#ifndef CACHE_STATS_PAGE_BYTES
+#define CACHE_STATS_PAGE_BYTES 64
+#endif
+
+/*
+ * Read-only cache of sparse tiles in a per-core circular buffer.
+ *
+ * Sparse tile t lives in slot t % num_slots, so neighbouring tiles never
+ * evict each other until the window is num_slots tiles wide. The host sizes
+ * num_slots from the L1 left over by the program's other circular buffers.
+ * Hits and misses are counted for write_cache_stats().
+ */
+template <uint32_t num_slots, typename Accessor>
+class SparseTileCache {
+public:
+    SparseTileCache(const Accessor& accessor, uint32_t l1_base)
+        : accessor_(accessor), l1_base_(l1_base) {
+        for (uint32_t s = 0; s < num_slots; s++) {
+            slot_tile_[s] = UINT32_MAX;
+        }
+    }
+
+    elem_t operator[](uint32_t idx) {
+        uint32_t tile = idx / ELEMENTS_PER_TILE;
+        uint32_t slot = tile % num_slots;
+        uint32_t slot_addr = l1_base_ + slot * TILE_SIZE_BYTES;
+
+        if (slot_tile_[slot] != tile) {
+            noc_async_read_tile(tile, accessor_, slot_addr);
+            noc_async_read_barrier();
+            slot_tile_[slot] = tile;
+            misses_++;
+        } else {
+            hits_++;
+        }
+
+        return reinterpret_cast<elem_t*>(slot_addr)[idx % ELEMENTS_PER_TILE];
+    }
+
+    uint32_t hits() const { return hits_; }
+    uint32_t misses() const { return misses_; }
+    uint32_t l1_base() const { return l1_base_; }
+
+private:
+    const Accessor& accessor_;
+    uint32_t l1_base_;
+    uint32_t slot_tile_[num_slots];
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+};
+
+/*
+ * Writes a core's sparse tile hit and miss counts to page `page` of the
+ * host's cache stats buffer (CACHE_STATS_PAGE_BYTES per core), staging them
+ * through l1_addr, which must be free scratch by the time this is called.
+ */
+template <typename Accessor>
+inline void write_cache_stats(const Accessor& stats, uint32_t page, uint32_t l1_addr,
+                              uint32_t hits, uint32_t misses) {
+    volatile uint32_t* words = reinterpret_cast<volatile uint32_t*>(l1_addr);
+    words[0] = hits;
+    words[1] = misses;
+    noc_async_write(l1_addr, stats.get_noc_addr(page), CACHE_STATS_PAGE_BYTES);
+    noc_async_write_barrier();
+}
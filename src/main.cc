@@ -1,3 +1,9 @@
+#include <limits>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
 #ifdef USE_MPI
 #include "mpi.h"
 #endif
@@ -8,6 +14,105 @@
 #define xstr(s) str(s)
 #define str(s) #s
 
+#ifdef USE_OPENMP
+// The CPU each OpenMP thread of the first config runs on. Threads are
+// pinned on their first parallel region.
+std::vector<int> thread_cpus(Spatter::ClArgs &cl) {
+  std::vector<int> cpus(cl.configs[0]->omp_threads, -1);
+#pragma omp parallel num_threads(cl.configs[0]->omp_threads)
+  {
+    Spatter::pin_thread(omp_get_thread_num());
+    cpus[omp_get_thread_num()] = Spatter::current_cpu();
+  }
+  return cpus;
+}
+#endif
+
+// --stream: the backend's STREAM baseline, from the host's cache or
+// measured and cached, summed over ranks
+void stream_baseline(Spatter::ClArgs &cl) {
+  const int runs = 10;
+  int threads = 1;
+#ifdef USE_OPENMP
+  if (cl.backend.compare("openmp") == 0)
+    threads = omp_get_max_threads();
+#endif
+
+  // Keyed on everything the baseline depends on
+  char host[256] = {0};
+  gethostname(host, sizeof(host) - 1);
+  std::string key = std::string(host) + " " + cl.backend;
+  if (cl.backend.compare("serial") == 0 || cl.backend.compare("openmp") == 0)
+    key += " threads " + std::to_string(threads);
+#ifdef USE_TENSTORRENT
+  if (cl.backend.compare("tenstorrent") == 0)
+    key += " devices " + std::to_string(cl.tt_devices) + " cores " +
+        std::to_string(cl.tt_cores) + " " + cl.tt_dtype;
+#endif
+#ifdef USE_MPI
+  int ranks = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+  key += " ranks " + std::to_string(ranks);
+#endif
+
+  Spatter::StreamBaseline baseline;
+  int measure =
+      cl.stream.compare("run") == 0 || !Spatter::load_stream_baseline(key, baseline);
+#ifdef USE_MPI
+  // The ranks measure together, as they run the configs
+  MPI_Allreduce(MPI_IN_PLACE, &measure, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+  if (measure) {
+    baseline = Spatter::StreamBaseline();
+#ifdef USE_CUDA
+    if (cl.backend.compare("cuda") == 0) {
+      const size_t n = size_t(1) << 25;
+      float copy_ms = 0.0f, triad_ms = 0.0f;
+      cuda_stream(n, runs, &copy_ms, &triad_ms);
+      const double bytes = static_cast<double>(n * sizeof(double));
+      baseline.copy = 2.0 * bytes / copy_ms / 1000.0;
+      baseline.triad = 3.0 * bytes / triad_ms / 1000.0;
+    }
+#endif
+#ifdef USE_TENSTORRENT
+    // A tile copy per device, one device after another. There is no triad.
+    if (cl.backend.compare("tenstorrent") == 0) {
+      for (int d = 0; d < cl.tt_devices; ++d) {
+        std::shared_ptr<Spatter::TensTorrentDevice> device =
+            Spatter::TensTorrentDevice::shared(d);
+        if (!device) {
+          std::cerr << "Failed to open TensTorrent device " << d << std::endl;
+          exit(1);
+        }
+        device->configure(cl.tt_cores, cl.tt_dtype);
+        baseline.copy += Spatter::tt_stream_copy(*device, size_t(1) << 26, runs);
+      }
+    }
+#endif
+    if (cl.backend.compare("serial") == 0 || cl.backend.compare("openmp") == 0)
+      baseline = Spatter::host_stream(
+          Spatter::stream_elements(Spatter::node_ranks()), threads, runs);
+
+    if (baseline.peak() > 0.0)
+      Spatter::save_stream_baseline(key, baseline);
+  }
+
+#ifdef USE_MPI
+  double totals[2] = {baseline.copy, baseline.triad};
+  MPI_Allreduce(MPI_IN_PLACE, totals, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  baseline.copy = totals[0];
+  baseline.triad = totals[1];
+#endif
+
+  if (baseline.peak() <= 0.0)
+    std::cerr << "Warning: the STREAM baseline failed, configs are not "
+                 "reported against it"
+              << std::endl;
+  cl.stream_baseline = baseline;
+  cl.output.peak_bandwidth = baseline.peak();
+}
+
 void print_build_info(Spatter::ClArgs &cl) {
   std::cout << std::endl;
   std::cout << "Running Spatter version " << xstr(SPAT_VERSION) << std::endl;
@@ -23,6 +128,82 @@ void print_build_info(Spatter::ClArgs &cl) {
   else if (cl.backend.compare("tenstorrent") == 0)
     std::cout << "TensTorrent" << std::endl;
 
+  if (cl.backend.compare("openmp") == 0) {
+    const Spatter::SimdKernels *simd = Spatter::simd_kernels(cl.simd);
+    std::cout << "SIMD Kernels: " << (simd ? simd->name : "unsupported")
+              << std::endl;
+  }
+
+  if (cl.hugepages.compare("off") != 0) {
+    std::cout << "Huge Pages: " << cl.hugepages << std::endl;
+    std::cout << "  sparse: " << Spatter::hugepage_backing(cl.sparse.data())
+              << std::endl;
+    if (!cl.sparse_gather.empty())
+      std::cout << "  sparse_gather: "
+                << Spatter::hugepage_backing(cl.sparse_gather.data())
+                << std::endl;
+    if (!cl.sparse_scatter.empty())
+      std::cout << "  sparse_scatter: "
+                << Spatter::hugepage_backing(cl.sparse_scatter.data())
+                << std::endl;
+    std::cout << "  dense: "
+              << Spatter::hugepage_backing(cl.dense_perthread.empty()
+                         ? cl.dense.data()
+                         : cl.dense_perthread[0].data())
+              << std::endl;
+  }
+
+  if (cl.bw_model.compare("payload") != 0)
+    std::cout << "Bandwidth Model: " << cl.bw_model << std::endl;
+
+#ifdef USE_OPENMP
+  if (cl.backend.compare("openmp") == 0 && !cl.configs.empty()) {
+    std::cout << "Loop Schedule: " << cl.schedule << std::endl;
+
+    std::vector<int> cpus = thread_cpus(cl);
+
+    std::cout << "Thread Map (thread:cpu"
+              << (Spatter::thread_affinity_enabled() ? ", pinned" : "")
+              << "):";
+    for (size_t t = 0; t < cpus.size(); ++t)
+      std::cout << " " << t << ":" << cpus[t];
+    std::cout << std::endl;
+  }
+#endif
+
+  // Planned before any buffer was allocated
+  const size_t dense_copies =
+      cl.dense_perthread.empty() ? 1 : cl.dense_perthread.size();
+  auto mib = [](size_t bytes) { return static_cast<double>(bytes) / 1048576.0; };
+  std::cout << "Buffer Plan (MiB): sparse "
+            << mib(sizeof(double) * cl.plan.sparse_size);
+  if (cl.plan.sparse_gather_size || cl.plan.sparse_scatter_size)
+    std::cout << ", sparse_gather "
+              << mib(sizeof(double) * cl.plan.sparse_gather_size)
+              << ", sparse_scatter "
+              << mib(sizeof(double) * cl.plan.sparse_scatter_size);
+  std::cout << ", dense " << mib(sizeof(double) * cl.plan.dense_size);
+  if (dense_copies > 1)
+    std::cout << " x " << dense_copies;
+  std::cout << ", peak " << mib(cl.plan.bytes(dense_copies)) << std::endl;
+
+  if (cl.cold) {
+    std::cout << "Cold Caches: ";
+    if (cl.backend.compare("cuda") == 0)
+      std::cout << "device L2";
+    else
+      std::cout << mib(Spatter::cache_flush_bytes()) << " MiB streamed";
+    std::cout << " between timed runs" << std::endl;
+  }
+
+  if (cl.stream_baseline.peak() > 0.0) {
+    std::cout << "STREAM Baseline (MB/s): copy " << cl.stream_baseline.copy;
+    if (cl.stream_baseline.triad > 0.0)
+      std::cout << ", triad " << cl.stream_baseline.triad;
+    std::cout << (cl.stream_baseline.cached ? ", cached" : ", measured")
+              << std::endl;
+  }
+
   std::cout << "Aggregate Results? ";
   if (cl.aggregate == true)
     std::cout << "YES" << std::endl;
@@ -53,6 +234,197 @@ void print_build_info(Spatter::ClArgs &cl) {
   std::cout << std::endl;
 }
 
+// What print_build_info shows, for --output
+nlohmann::json build_info(Spatter::ClArgs &cl) {
+  nlohmann::json build;
+  build["version"] = xstr(SPAT_VERSION);
+  build["compiler"] = std::string(xstr(SPAT_CXX_NAME)) + " " + xstr(SPAT_CXX_VER);
+  build["backend"] = cl.backend;
+
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  build["host"] = host;
+  build["cpus"] = sysconf(_SC_NPROCESSORS_ONLN);
+  build["llc-bytes"] = Spatter::last_level_cache_bytes();
+#ifdef USE_MPI
+  int ranks = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+  build["ranks"] = ranks;
+#endif
+
+  if (cl.backend.compare("openmp") == 0) {
+    const Spatter::SimdKernels *simd = Spatter::simd_kernels(cl.simd);
+    build["simd"] = simd ? simd->name : "unsupported";
+#ifdef USE_OPENMP
+    if (!cl.configs.empty()) {
+      build["schedule"] = cl.schedule;
+      // thread:cpu pairs, as in the Thread Map line
+      std::string map;
+      std::vector<int> cpus = thread_cpus(cl);
+      for (size_t t = 0; t < cpus.size(); ++t)
+        map += (t ? " " : "") + std::to_string(t) + ":" +
+            std::to_string(cpus[t]);
+      build["thread-map"] = map;
+      build["pinned"] = Spatter::thread_affinity_enabled();
+    }
+#endif
+  }
+
+  build["hugepages"] = cl.hugepages;
+  build["bw-model"] = cl.bw_model;
+  build["warmup"] = cl.warmup;
+  build["cold"] = cl.cold;
+  build["adaptive"] = cl.adaptive;
+  if (cl.stream_baseline.peak() > 0.0) {
+    build["stream-copy-mbs"] = cl.stream_baseline.copy;
+    build["stream-triad-mbs"] = cl.stream_baseline.triad;
+    build["stream-cached"] = cl.stream_baseline.cached;
+  }
+  build["sparse-bytes"] = sizeof(double) * cl.plan.sparse_size;
+  build["dense-bytes"] = sizeof(double) * cl.plan.dense_size;
+
+#ifdef USE_CUDA
+  if (cl.backend.compare("cuda") == 0) {
+    int num_devices = 0;
+    checkCudaErrors(cudaGetDeviceCount(&num_devices));
+
+    struct cudaDeviceProp prop;
+    checkCudaErrors(cudaGetDeviceProperties(&prop, 0));
+
+    build["devices"] = num_devices;
+    build["device-name"] = prop.name;
+    build["memory-clock-khz"] = prop.memoryClockRate;
+    build["memory-bus-bits"] = prop.memoryBusWidth;
+    build["peak-bandwidth-gbs"] =
+        2.0 * prop.memoryClockRate * (prop.memoryBusWidth / 8) / 1.0e6;
+  }
+#endif
+#ifdef USE_TENSTORRENT
+  if (cl.backend.compare("tenstorrent") == 0) {
+    build["devices"] = cl.tt_devices;
+    build["tt-cores"] = cl.tt_cores;
+    build["tt-dtype"] = cl.tt_dtype;
+    build["tt-memory"] = cl.tt_memory;
+  }
+#endif
+  return build;
+}
+
+// Runs and reports one config, returning -1 if a run fails
+int run_config(Spatter::ClArgs &cl, Spatter::ConfigurationBase &config) {
+  for (unsigned long run = 0; run < cl.warmup; ++run)
+    if (config.run(false, 0) != 0)
+      return -1;
+
+  // --adaptive stops once the run time has settled, so the report covers
+  // the runs made
+  Spatter::Timer elapsed;
+  elapsed.start();
+  unsigned long runs = 0;
+  while (runs < config.nruns) {
+    if (cl.cold) {
+      elapsed.stop();
+      config.flush_caches();
+      elapsed.start();
+    }
+    if (config.run(true, runs) != 0)
+      return -1;
+    config.record_counters();
+    ++runs;
+
+    if (cl.adaptive > 0.0 && runs < config.nruns) {
+      elapsed.stop();
+      const bool out_of_time =
+          cl.time_budget > 0.0 && elapsed.seconds() >= cl.time_budget;
+      elapsed.start();
+      if (config.runs_settled(runs, cl.adaptive, out_of_time))
+        break;
+    }
+  }
+  config.time_seconds.resize(runs);
+
+  // Every rank takes part in the report, which rank 0 prints
+  config.report();
+  if (cl.adaptive > 0.0)
+    config.report_runs();
+  if (cl.stream_baseline.peak() > 0.0)
+    config.report_peak(cl.stream_baseline.peak());
+  config.report_counters();
+
+#ifdef USE_MPI
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank == 0) {
+#endif
+  if (!cl.sweep.empty())
+    std::cout << "  sweep: " << config.name << std::endl;
+  if (cl.analyze)
+    for (const Spatter::PatternLocality &l : config.locality())
+      std::cout << "  " << l << std::endl;
+#ifdef USE_MPI
+  }
+#endif
+  cl.record(config);
+  return 0;
+}
+
+// --corun: runs configs [first, last), which have each run alone, at once.
+// Every config drives its own OpenMP team from a thread of its own, pinned
+// to the --affinity CPUs after the previous config's, and each run starts
+// when all of them reach a barrier. Returns -1 if a run fails.
+int corun_configs(Spatter::ClArgs &cl, const size_t first, const size_t last) {
+  std::vector<double> alone_seconds;
+  std::vector<size_t> ids;
+  unsigned long runs = std::numeric_limits<unsigned long>::max();
+  int offset = 0;
+  for (size_t i = first; i < last; ++i) {
+    Spatter::ConfigurationBase &config = *cl.configs[i];
+    alone_seconds.push_back(
+        *std::min_element(config.time_seconds.begin(), config.time_seconds.end()));
+    ids.push_back(config.id);
+    runs = std::min(runs, config.nruns);
+    config.thread_offset = offset;
+    offset += config.omp_threads;
+  }
+
+  // The same number of runs each, so every run is made under co-run
+  Spatter::SpinBarrier barrier(last - first);
+  std::vector<char> failed(last - first, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = first; i < last; ++i) {
+    Spatter::ConfigurationBase &config = *cl.configs[i];
+    config.time_seconds.assign(runs, 0.0);
+    threads.emplace_back([&, i]() {
+      Spatter::ConfigurationBase &c = *cl.configs[i];
+      for (unsigned long run = 0; run < cl.warmup + runs; ++run) {
+        const bool timed = run >= cl.warmup;
+        if (timed && cl.cold)
+          c.flush_caches();
+        barrier.wait();
+        if (c.run(timed, timed ? run - cl.warmup : 0) != 0)
+          failed[i - first] = 1;
+      }
+    });
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+  if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+    return -1;
+
+  for (size_t i = first; i < last; ++i) {
+    Spatter::ConfigurationBase &config = *cl.configs[i];
+    config.report_corun(alone_seconds[i - first]);
+
+    std::vector<size_t> with;
+    for (size_t id : ids)
+      if (id != config.id)
+        with.push_back(id);
+    if (cl.output.enabled())
+      cl.output.record_corun(config, with, alone_seconds[i - first]);
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Check for --quiet-tt flag early and set TT-Metal logging level before library init
   for (int i = 1; i < argc; i++) {
@@ -72,13 +444,13 @@ int main(int argc, char **argv) {
   MPI_Comm_size(MPI_COMM_WORLD, &size);
 #endif
 
-  const unsigned long warmup_runs = 0;
-  bool timed = 0;
-
   Spatter::ClArgs cl;
   if (Spatter::parse_input(argc, argv, cl) != 0)
     return -1;
 
+  if (cl.stream.compare("off") != 0)
+    stream_baseline(cl);
+
 #ifdef USE_MPI
   if (rank == 0) {
 #endif
@@ -88,35 +460,46 @@ int main(int argc, char **argv) {
     if (cl.verbosity >= 2)
       std::cout << cl;
 
+    if (cl.output.enabled())
+      cl.output.build = build_info(cl);
+
     cl.report_header();
 #ifdef USE_MPI
   }
 #endif
 
-  for (std::unique_ptr<Spatter::ConfigurationBase> const &config : cl.configs) {
-    for (unsigned long run = 0; run < (config->nruns + warmup_runs); ++run) {
-
-      unsigned long run_id = 0;
-      if (run >= warmup_runs) {
-        timed = 1;
-        run_id = run - warmup_runs;
-      } else {
-        timed = 0;
-      }
+  for (size_t i = 0; i < cl.configs.size(); ++i) {
+    if (run_config(cl, *cl.configs[i]) != 0)
+      return -1;
 
-      if (config->run(timed, run_id) != 0)
+    // --corun: each group of configs runs together once it has run alone
+    const size_t first = cl.corun ? i - i % cl.corun : i;
+    const bool group_done =
+        !cl.corun || i + 1 - first == cl.corun || i + 1 == cl.configs.size();
+    if (cl.corun && group_done && i > first)
+      if (corun_configs(cl, first, i + 1) != 0)
         return -1;
-    }
 
-#ifdef USE_MPI
-    if (rank == 0) {
-#endif
-    config->report();
-#ifdef USE_MPI
-    }
-#endif
+    // Each config is freed once it and the rest of its group have been
+    // reported, so a suite only holds the configs it is running
+    if (group_done)
+      for (size_t j = first; j <= i; ++j)
+        cl.configs.release(j);
   }
 
+  // -p TRACE runs the rest of the trace one window at a time
+  if (cl.next_trace_config) {
+    int more;
+    while ((more = cl.next_trace_config()) > 0)
+      if (run_config(cl, *cl.configs.back()) != 0)
+        return -1;
+    if (more < 0)
+      return -1;
+  }
+
+  cl.report_suite();
+  cl.output.write();
+
 #ifdef USE_MPI
   MPI_Finalize();
 #endif
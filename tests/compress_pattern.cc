@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "Spatter/PatternParser.hh"
+
+// The page-by-page search compress_pattern replaced
+void reference_compress(aligned_vector<size_t> &pattern) {
+  std::vector<size_t> pages;
+
+  for (size_t i = 0; i < pattern.size(); i++) {
+    size_t page = (pattern[i] * 8) >> PAGE_BITS;
+    size_t page_index;
+
+    auto it = std::find(pages.begin(), pages.end(), page);
+    if (it != pages.end()) {
+      page_index = it - pages.begin();
+    } else {
+      page_index = pages.size();
+      pages.push_back(page);
+    }
+
+    size_t new_val = (page_index << PAGE_BITS) |
+        ((pattern[i] * 8) & ((1l << PAGE_BITS) - 1l));
+    pattern[i] = new_val / 8;
+  }
+}
+
+// compress_pattern must match the reference for short patterns and for
+// patterns long enough to be compressed in parallel
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+#ifdef USE_OPENMP
+  // Several chunks even on a single core
+  omp_set_num_threads(4);
+#endif
+
+  unsigned int seed = 7;
+  for (size_t n : {1, 1000, 1 << 20}) {
+    aligned_vector<size_t> pattern(n);
+    for (size_t i = 0; i < n; ++i)
+      pattern[i] = rand_r(&seed) % (1 << 18);
+
+    aligned_vector<size_t> gold(pattern);
+    reference_compress(gold);
+    Spatter::compress_pattern(pattern);
+
+    if (gold != pattern) {
+      std::cerr << "Test failure on compress of length " << n << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
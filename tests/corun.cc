@@ -0,0 +1,48 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Spatter/Input.hh"
+
+int main() {
+  // No thread leaves a phase of the barrier before all have entered it
+  const size_t threads = 3, phases = 100;
+  Spatter::SpinBarrier barrier(threads);
+  std::vector<std::atomic<size_t>> arrived(phases);
+  std::atomic<bool> early{false};
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t)
+    workers.emplace_back([&]() {
+      for (size_t p = 0; p < phases; ++p) {
+        ++arrived[p];
+        barrier.wait();
+        if (arrived[p] != threads)
+          early = true;
+      }
+    });
+  for (std::thread &worker : workers)
+    worker.join();
+  if (early) {
+    std::cerr << "Test failure: a thread left the barrier early" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> args = {"./spatter", "-pUNIFORM:8:1", "-bopenmp",
+      "--sweep", "kernel=gather,scatter", "--corun", "2"};
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+          0 ||
+      cl.corun != 2 || cl.configs.size() != 2) {
+    std::cerr << "Test failure on --corun parsing" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
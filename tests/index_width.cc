@@ -0,0 +1,76 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Spatter/Configuration.hh"
+#include "Spatter/Input.hh"
+
+// Runs one config and checks its last iteration against the indices of the
+// size_t patterns, and the index width picked for them
+int check(std::vector<std::string> args, size_t width) {
+  // Serial, so the last iteration is the last write to dense
+  args.insert(args.begin(), {"./spatter", "-bserial"});
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+      0) {
+    std::cerr << "Parse Input Failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Spatter::ConfigurationBase &c = *cl.configs[0];
+  if (c.index_width != width) {
+    std::cerr << "Test failure on " << c.kernel << ": index width was "
+              << c.index_width << ", expected " << width << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const aligned_vector<double> sparse(cl.sparse);
+  const aligned_vector<double> sparse_gather(cl.sparse_gather);
+  const aligned_vector<double> dense(cl.dense);
+  c.run(false, 0);
+
+  const size_t i = c.count - 1;
+  bool ok = true;
+  if (c.kernel.compare("gather") == 0)
+    for (size_t j = 0; j < c.pattern.size(); ++j)
+      ok &= cl.dense[j] == sparse[c.pattern[j] + c.delta * i];
+  else if (c.kernel.compare("scatter") == 0)
+    for (size_t j = 0; j < c.pattern.size(); ++j)
+      ok &= cl.sparse[c.pattern[j] + c.delta * i] == dense[j];
+  else if (c.kernel.compare("gs") == 0)
+    for (size_t j = 0; j < c.pattern_scatter.size(); ++j)
+      ok &= cl.sparse_scatter[c.pattern_scatter[j] + c.delta_scatter * i] ==
+          sparse_gather[c.pattern_gather[j] + c.delta_gather * i];
+  else if (c.kernel.compare("multigather") == 0)
+    for (size_t j = 0; j < c.pattern_gather.size(); ++j)
+      ok &= cl.dense[j] == sparse[c.pattern[c.pattern_gather[j]] + c.delta * i];
+
+  if (!ok) {
+    std::cerr << "Test failure on " << c.kernel << " with " << width
+              << "-byte indices" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  if (check({"-kgather", "-pUNIFORM:8:4", "-l16"}, 2) != EXIT_SUCCESS ||
+      check({"-kgather", "-p0,65535,7", "-l16"}, 2) != EXIT_SUCCESS ||
+      check({"-kgather", "-p0,65536,7", "-l16"}, 4) != EXIT_SUCCESS ||
+      check({"-kscatter", "-p3,70000,9,1", "-l16"}, 4) != EXIT_SUCCESS ||
+      check({"-kgs", "-gUNIFORM:8:1", "-u0,70000,2,3,4,5,6,7", "-l16"}, 4) !=
+          EXIT_SUCCESS ||
+      check({"-kmultigather", "-p0,2,80000,6", "-g3,1,0,2", "-l16"}, 4) !=
+          EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Spatter/Input.hh"
+#include "Spatter/Locality.hh"
+
+int main() {
+  // Eight contiguous doubles are one 64-byte line; with delta 8 every
+  // iteration moves to a new line that is never touched again
+  size_t uniform[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  Spatter::PatternLocality l =
+      Spatter::analyze_locality("pattern", uniform, 8, 8, 16);
+
+  if (l.iterations != 16 || l.lines_per_iteration != 1.0 ||
+      l.footprint_lines != 16 || l.footprint_pages != 1 || l.cold != 16) {
+    std::cerr << "Test failure on UNIFORM:8:1 with delta 8: lines "
+              << l.lines_per_iteration << ", footprint " << l.footprint_lines
+              << ", cold " << l.cold << std::endl;
+    return EXIT_FAILURE;
+  }
+  // The 7 other accesses of each line reuse it at distance 0
+  if (l.reuse.size() != 1 || l.reuse[0] != 16 * 7) {
+    std::cerr << "Test failure on UNIFORM:8:1 reuse distances" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (l.strides.size() != 1 || l.strides[0].first != 1 || l.steps != 7) {
+    std::cerr << "Test failure on UNIFORM:8:1 strides" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // With delta 0 the same two lines come back every iteration, each after
+  // the other one, and stay in their tile
+  size_t pair[2] = {0, 8};
+  l = Spatter::analyze_locality("pattern", pair, 2, 0, 4);
+  if (l.cold != 2 || l.reuse.size() != 2 || l.reuse[1] != 6 ||
+      l.tile_hits != 7 || l.strides[0].first != 8) {
+    std::cerr << "Test failure on a repeated pattern: cold " << l.cold
+              << ", tile hits " << l.tile_hits << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Every config indexes through its patterns
+  std::vector<std::string> args = {"./spatter", "-kgs", "-gUNIFORM:8:1",
+      "-uUNIFORM:8:2", "-l16", "--analyze"};
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+          0 ||
+      !cl.analyze) {
+    std::cerr << "Test failure on --analyze parsing" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<Spatter::PatternLocality> gs = cl.configs[0]->locality();
+  if (gs.size() != 2 || gs[0].name != "pattern-gather" ||
+      gs[1].name != "pattern-scatter" || gs[1].strides[0].first != 2) {
+    std::cerr << "Test failure on gs locality" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "Spatter/PatternParser.hh"
+
+// Generated patterns must come with descriptors that expand to the same
+// indices, before and after truncation, and custom patterns with none
+int check(const std::string &spec, Spatter::PatternDescriptor::Kind kind) {
+  std::stringstream stream(spec);
+  aligned_vector<size_t> pattern;
+  size_t delta;
+  Spatter::PatternDescriptor descriptor;
+
+  if (Spatter::pattern_parser(stream, pattern, delta, descriptor) != 0) {
+    std::cerr << "Failed to parse " << spec << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (descriptor.kind != kind) {
+    std::cerr << "Test failure on " << spec << ": descriptor is "
+              << descriptor.name() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (kind == Spatter::PatternDescriptor::Kind::None) {
+    if (!descriptor.empty()) {
+      std::cerr << "Test failure on " << spec << ": custom pattern has runs"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (!descriptor.describes(pattern.data(), pattern.size())) {
+    std::cerr << "Test failure on " << spec
+              << ": descriptor does not match the pattern" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t length = pattern.size() / 2 + 1;
+  descriptor.truncate(length);
+  if (!descriptor.describes(pattern.data(), length)) {
+    std::cerr << "Test failure on " << spec
+              << ": truncated descriptor does not match the pattern"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  using Kind = Spatter::PatternDescriptor::Kind;
+
+  if (check("UNIFORM:8:1", Kind::Affine) != EXIT_SUCCESS ||
+      check("UNIFORM:16:7:NR", Kind::Affine) != EXIT_SUCCESS ||
+      check("MS1:16:4,9:5", Kind::Segmented) != EXIT_SUCCESS ||
+      check("MS1:8:3:20", Kind::Segmented) != EXIT_SUCCESS ||
+      check("LAPLACIAN:2:2:50", Kind::Stencil) != EXIT_SUCCESS ||
+      check("LAPLACIAN:3:1:10", Kind::Stencil) != EXIT_SUCCESS ||
+      check("1,5,9,2", Kind::None) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "Spatter/Configuration.hh"
+#include "Spatter/Input.hh"
+
+bool close(double a, double b) {
+  return std::fabs(a - b) <= 1e-9 * std::fmax(1.0, std::fabs(b));
+}
+
+// Runs one gather-reduce or scatter-add config once and checks the sums
+int check(std::vector<std::string> args) {
+  args.insert(args.begin(), "./spatter");
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+      0) {
+    std::cerr << "Parse Input Failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Spatter::ConfigurationBase &c = *cl.configs[0];
+  const aligned_vector<double> sparse(cl.sparse);
+  const aligned_vector<double> dense(cl.dense);
+  c.run(false, 0);
+
+  const size_t length = c.pattern.size();
+  bool ok = true;
+  if (c.kernel.compare("gather-reduce") == 0) {
+    // Each dense slot holds the sum of the last iteration that wrote it
+    for (size_t i = c.count - c.wrap; i < c.count; ++i) {
+      double sum = 0.0;
+      for (size_t j = 0; j < length; ++j)
+        sum += sparse[c.pattern[j] + c.delta * i];
+      ok &= close(cl.dense[i % c.wrap], sum);
+    }
+  } else {
+    std::vector<double> expected(sparse.begin(), sparse.end());
+    for (size_t i = 0; i < c.count; ++i)
+      for (size_t j = 0; j < length; ++j)
+        expected[c.pattern[j] + c.delta * i] += dense[j + length * (i % c.wrap)];
+    for (size_t k = 0; k < expected.size(); ++k)
+      ok &= close(cl.sparse[k], expected[k]);
+  }
+
+  if (!ok) {
+    std::cerr << "Test failure on " << c.kernel << " with";
+    for (size_t a = 1; a < args.size(); ++a)
+      std::cerr << " " << args[a];
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  // Indices repeat within and across iterations
+  if (check({"-kgather-reduce", "-p0,3,3,9", "-d2", "-l16", "-w4"}) !=
+          EXIT_SUCCESS ||
+      check({"-kscatter-add", "-p0,3,3,9", "-d2", "-l16", "-w4"}) !=
+          EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+#ifdef USE_OPENMP
+  omp_set_num_threads(3);
+  for (const char *mode : {"auto", "atomic", "private"})
+    if (check({"-bopenmp", "-t3", "-kscatter-add", "-p0,3,3,9", "-d2",
+            "-l64", std::string("--accumulate=") + mode}) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+  if (check({"-bopenmp", "-t3", "-kgather-reduce", "-pUNIFORM:37:3", "-d5",
+          "-l64", "-w64"}) != EXIT_SUCCESS ||
+      check({"-bopenmp", "-t3", "-kscatter-add", "-pUNIFORM:8:1", "-d8",
+          "-l64"}) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  // Targets that never repeat are added to in place, with simd
+  std::vector<std::string> args = {"./spatter", "-bopenmp", "-t3",
+      "-kscatter-add", "-pUNIFORM:8:1", "-d8"};
+  std::vector<char *> args_;
+  for (std::string &arg : args)
+    args_.push_back(&arg[0]);
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(args_.size()), args_.data(), cl) !=
+          0 ||
+      dynamic_cast<Spatter::Configuration<Spatter::OpenMP> &>(*cl.configs[0])
+              .accumulate != Spatter::Accumulate::Plain) {
+    std::cerr << "Test failure on --accumulate auto" << std::endl;
+    return EXIT_FAILURE;
+  }
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Spatter/Input.hh"
+
+int main() {
+  const std::string path = "result_output_test.json";
+  std::vector<std::string> args = {"./spatter", "-pUNIFORM:8:1", "-l16",
+      "-r3", "--output", "json:" + path};
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+          0 ||
+      !cl.output.enabled()) {
+    std::cerr << "Test failure on --output parsing" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Spatter::ConfigurationBase &config = *cl.configs[0];
+  for (unsigned long run = 0; run < config.nruns; ++run)
+    config.run(true, run);
+  cl.output.build["backend"] = cl.backend;
+  cl.record(config);
+  cl.output.write();
+
+  std::ifstream file(path);
+  nlohmann::json results = nlohmann::json::parse(file);
+  std::remove(path.c_str());
+
+  const nlohmann::json &c = results["configs"][0];
+  if (results["build"]["backend"] != cl.backend || c["kernel"] != "gather" ||
+      c["pattern"].size() != 8 || c["times"].size() != 3 ||
+      c["bytes"] != config.bytes_per_run() || !(c["min-time"] > 0.0)) {
+    std::cerr << "Test failure on the --output json record: " << c.dump()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Spatter/Input.hh"
+#include "Spatter/Statistics.hh"
+
+int main() {
+  double seconds[4] = {4.0, 1.0, 3.0, 2.0};
+  Spatter::RunStatistics stats = Spatter::run_statistics(seconds, 4);
+
+  // Sample stddev sqrt(5/3); t(3) = 3.182 over sqrt(4) runs and mean 2.5
+  const double stddev = std::sqrt(5.0 / 3.0);
+  if (stats.runs != 4 || stats.min != 1.0 || stats.median != 2.5 ||
+      stats.mean != 2.5 || std::fabs(stats.stddev - stddev) > 1e-12 ||
+      std::fabs(stats.ci95 - 3.182 * stddev / 2.0 / 2.5) > 1e-12) {
+    std::cerr << "Test failure on run statistics: " << stats << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Identical runs settle as soon as there are enough of them
+  std::vector<std::string> args = {"./spatter", "-pUNIFORM:8:1", "-l16",
+      "-r100", "--warmup", "2", "--adaptive", "0.05"};
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+          0 ||
+      cl.warmup != 2 || cl.adaptive != 0.05) {
+    std::cerr << "Test failure on --warmup and --adaptive parsing"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Spatter::ConfigurationBase &config = *cl.configs[0];
+  std::fill(config.time_seconds.begin(), config.time_seconds.end(), 1.0);
+  if (config.runs_settled(2, cl.adaptive, false) ||
+      !config.runs_settled(3, cl.adaptive, false)) {
+    std::cerr << "Test failure on settling identical runs" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  config.time_seconds[1] = 3.0;
+  if (config.runs_settled(3, cl.adaptive, false) ||
+      !config.runs_settled(3, cl.adaptive, true)) {
+    std::cerr << "Test failure on settling noisy runs" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
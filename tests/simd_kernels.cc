@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "Spatter/SimdKernels.hh"
+
+// Every intrinsic kernel this CPU supports must match the scalar kernels,
+// including the remainder lanes and duplicate scatter indices, and so must
+// every non-temporal variant
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  const Spatter::SimdKernels *scalar =
+      Spatter::simd_kernels(Spatter::SimdIsa::Scalar);
+
+  std::vector<double> sparse(4096);
+  for (size_t i = 0; i < sparse.size(); ++i)
+    sparse[i] = static_cast<double>(i) * 0.5;
+
+  for (Spatter::SimdIsa isa : {Spatter::SimdIsa::Scalar, Spatter::SimdIsa::AVX2,
+           Spatter::SimdIsa::AVX512, Spatter::SimdIsa::SVE}) {
+    const Spatter::SimdKernels *kernels = Spatter::simd_kernels(isa);
+    if (!kernels)
+      continue;
+
+    for (size_t n : {1, 7, 8, 16, 37}) {
+      std::vector<uint32_t> pattern(n);
+      for (size_t j = 0; j < n; ++j)
+        pattern[j] = static_cast<uint32_t>((j * 97) % 301);
+      pattern[n - 1] = pattern[0];
+
+      // Offset by one element so the streaming gathers peel a head
+      std::vector<double> gold(n), dense(n), dense_nt(n + 1);
+      scalar->gather(gold.data(), sparse.data(), pattern.data(), n);
+      kernels->gather(dense.data(), sparse.data(), pattern.data(), n);
+      kernels->gather_nt(dense_nt.data() + 1, sparse.data(), pattern.data(), n);
+      Spatter::simd_store_fence();
+      if (gold != dense ||
+          !std::equal(gold.begin(), gold.end(), dense_nt.begin() + 1)) {
+        std::cerr << "Test failure on " << kernels->name
+                  << " gather of length " << n << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      std::vector<double> gold_sparse(sparse), simd_sparse(sparse),
+          nt_sparse(sparse);
+      scalar->scatter(gold_sparse.data(), dense.data(), pattern.data(), n);
+      kernels->scatter(simd_sparse.data(), dense.data(), pattern.data(), n);
+      kernels->scatter_nt(nt_sparse.data(), dense.data(), pattern.data(), n);
+      Spatter::simd_store_fence();
+      if (gold_sparse != simd_sparse || gold_sparse != nt_sparse) {
+        std::cerr << "Test failure on " << kernels->name
+                  << " scatter of length " << n << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
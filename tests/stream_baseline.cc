@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "Spatter/Stream.hh"
+
+int main() {
+  Spatter::StreamBaseline measured = Spatter::host_stream(1 << 20, 1, 2);
+  if (!(measured.copy > 0.0) || !(measured.triad > 0.0) || measured.cached) {
+    std::cerr << "Test failure on the host STREAM baseline" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string dir = "stream_baseline_test." + std::to_string(getpid());
+  setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+
+  Spatter::StreamBaseline cached;
+  if (Spatter::load_stream_baseline("host serial", cached) ||
+      !Spatter::save_stream_baseline("host serial", measured) ||
+      !Spatter::load_stream_baseline("host serial", cached) ||
+      !cached.cached || cached.copy != measured.copy ||
+      cached.triad != measured.triad ||
+      Spatter::load_stream_baseline("host openmp", cached)) {
+    std::cerr << "Test failure on the STREAM baseline cache" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::remove(Spatter::stream_cache_path().c_str());
+  rmdir((dir + "/spatter").c_str());
+  rmdir(dir.c_str());
+  return EXIT_SUCCESS;
+}
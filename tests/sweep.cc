@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "Spatter/Configuration.hh"
+#include "Spatter/Input.hh"
+
+int main() {
+  std::vector<Spatter::SweepAxis> axes;
+  std::string error;
+  if (!Spatter::parse_sweep("delta=1..8x2;count=2^10..2^12", axes, error) ||
+      axes.size() != 2 ||
+      axes[0].values != std::vector<std::string>{"1", "2", "4", "8"} ||
+      axes[1].values != std::vector<std::string>{"1024", "2048", "4096"} ||
+      Spatter::sweep_size(axes) != 12 ||
+      Spatter::sweep_name(axes, 5) != "delta=2 count=4096") {
+    std::cerr << "Test failure on --sweep parsing: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (Spatter::parse_sweep("delta=8..1", axes, error) ||
+      Spatter::parse_sweep("foo=1", axes, error)) {
+    std::cerr << "Test failure: invalid --sweep specs accepted" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> args = {"./spatter", "-pUNIFORM:8:1",
+      "--sweep", "kernel=gather,scatter;delta=1,8"};
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+          0 ||
+      cl.configs.size() != 4) {
+    std::cerr << "Test failure on --sweep configs" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const Spatter::ConfigurationBase &config = *cl.configs[3];
+  if (config.kernel != "scatter" || config.delta != 8 ||
+      config.name != "kernel=scatter delta=8") {
+    std::cerr << "Test failure on the --sweep point: " << config.kernel << " "
+              << config.delta << " " << config.name << std::endl;
+    return EXIT_FAILURE;
+  }
+
+#ifdef USE_OPENMP
+  // Swept threads past the OpenMP limit are clamped to it, as -t is
+  const int max_threads = omp_get_max_threads();
+  std::vector<std::string> omp_args = {"./spatter", "-bopenmp",
+      "-pUNIFORM:8:1", "--sweep",
+      "threads=1," + std::to_string(max_threads + 1)};
+  std::vector<char *> omp_argv;
+  for (std::string &arg : omp_args)
+    omp_argv.push_back(&arg[0]);
+
+  Spatter::ClArgs omp_cl;
+  if (Spatter::parse_input(static_cast<int>(omp_argv.size()), omp_argv.data(),
+          omp_cl) != 0 ||
+      omp_cl.configs.size() != 2 ||
+      omp_cl.configs[1]->omp_threads != max_threads) {
+    std::cerr << "Test failure on clamping --sweep threads" << std::endl;
+    return EXIT_FAILURE;
+  }
+#endif
+
+  return EXIT_SUCCESS;
+}
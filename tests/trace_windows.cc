@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "Spatter/Configuration.hh"
+#include "Spatter/Input.hh"
+
+// Runs the current window's config and checks its last iteration
+bool gathered(Spatter::ClArgs &cl) {
+  Spatter::ConfigurationBase &c = *cl.configs.back();
+  if (cl.sparse.size() < cl.sparse_size || cl.dense.size() < cl.dense_size)
+    return false;
+
+  const aligned_vector<double> sparse(cl.sparse);
+  c.run(false, 0);
+
+  const size_t i = c.count - 1;
+  bool ok = true;
+  for (size_t j = 0; j < c.pattern.size(); ++j)
+    ok &= cl.dense[j + c.pattern.size() * (i % c.wrap)] ==
+        sparse[c.pattern[j] + c.delta * i];
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  // Two windows of four byte addresses, the second reaching 1000 doubles
+  // past its base and outgrowing the buffers of the first
+  const std::string file = "trace_windows.idx.gz";
+  const uint64_t addresses[] = {0, 8, 16, 24, 0, 8000, 16, 24};
+  gzFile out = gzopen(file.c_str(), "wb");
+  if (!out || gzwrite(out, addresses, sizeof(addresses)) !=
+          static_cast<int>(sizeof(addresses))) {
+    std::cerr << "Failed to write " << file << std::endl;
+    return EXIT_FAILURE;
+  }
+  gzclose(out);
+
+  std::vector<std::string> args = {"./spatter", "-bserial", "-kgather",
+      "-pTRACE:" + file + ":4", "-l16"};
+  std::vector<char *> argv_;
+  for (std::string &arg : args)
+    argv_.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv_.size()), argv_.data(), cl) !=
+      0) {
+    std::cerr << "Parse Input Failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const size_t first_size = cl.sparse.size();
+  if (!gathered(cl)) {
+    std::cerr << "Test failure on the first TRACE window" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (cl.next_trace_config() != 1 || cl.sparse.size() <= first_size ||
+      cl.configs.back()->pattern[1] != 1000 || !gathered(cl)) {
+    std::cerr << "Test failure on the TRACE window that outgrew the first"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (cl.next_trace_config() != 0) {
+    std::cerr << "Test failure on the end of the TRACE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Spatter/Configuration.hh"
+#include "Spatter/Input.hh"
+#include "Spatter/Traffic.hh"
+
+// Elements per iteration a kernel moves, indexes, reads and writes
+struct PerIteration {
+  size_t payload;
+  size_t index;
+  size_t reads;
+  size_t writes;
+};
+
+// Parses one config and checks its traffic, at width-byte indices, and the
+// bytes each bandwidth model reports for it
+int check(std::vector<std::string> args, size_t width, PerIteration expected) {
+  args.insert(args.begin(), "./spatter");
+  std::vector<char *> argv;
+  for (std::string &arg : args)
+    argv.push_back(&arg[0]);
+
+  Spatter::ClArgs cl;
+  if (Spatter::parse_input(static_cast<int>(argv.size()), argv.data(), cl) !=
+      0) {
+    std::cerr << "Parse Input Failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const Spatter::ConfigurationBase &c = *cl.configs[0];
+  const Spatter::Traffic traffic = c.traffic();
+  const size_t element = sizeof(double);
+  bool ok = c.index_width == width &&
+      traffic.payload == expected.payload * c.count * element &&
+      traffic.index == expected.index * c.count * width &&
+      traffic.reads == expected.reads * c.count * element &&
+      traffic.writes == expected.writes * c.count * element;
+
+  Spatter::set_bandwidth_model(Spatter::BandwidthModel::Payload);
+  ok &= c.bytes_per_run() == traffic.payload;
+  Spatter::set_bandwidth_model(Spatter::BandwidthModel::ReadWrite);
+  ok &= c.bytes_per_run() == traffic.reads + traffic.writes;
+  Spatter::set_bandwidth_model(Spatter::BandwidthModel::Full);
+  ok &= c.bytes_per_run() == traffic.reads + traffic.writes + traffic.index;
+  Spatter::set_bandwidth_model(Spatter::BandwidthModel::Payload);
+
+  if (!ok) {
+    std::cerr << "Test failure on " << c.kernel << " traffic with " << width
+              << "-byte indices" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  // Patterns of 8 entries with indices that narrow to 2 bytes, and the same
+  // kernels with an index past 65535 that keeps them at 4
+  const std::vector<std::pair<std::string, size_t>> patterns = {
+      {"UNIFORM:8:1", 2}, {"0,1,2,3,4,5,6,70000", 4}};
+  for (const auto &[p, width] : patterns) {
+    if (check({"-kgather", "-p" + p, "-l16"}, width, {8, 8, 8, 8}) !=
+            EXIT_SUCCESS ||
+        check({"-kscatter", "-p" + p, "-l16"}, width, {8, 8, 8, 8}) !=
+            EXIT_SUCCESS ||
+        check({"-kgs", "-gUNIFORM:8:1", "-u" + p, "-l16"}, width,
+            {16, 16, 8, 8}) != EXIT_SUCCESS ||
+        check({"-kmultigather", "-p" + p, "-g3,1,0,2", "-l16"}, width,
+            {4, 8, 4, 4}) != EXIT_SUCCESS ||
+        check({"-kmultiscatter", "-p" + p, "-u3,1,0,2", "-l16"}, width,
+            {4, 8, 4, 4}) != EXIT_SUCCESS ||
+        check({"-kgather-reduce", "-p" + p, "-l16"}, width, {8, 8, 8, 1}) !=
+            EXIT_SUCCESS ||
+        check({"-kscatter-add", "-p" + p, "-l16"}, width, {8, 8, 16, 8}) !=
+            EXIT_SUCCESS)
+      return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}